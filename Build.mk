@@ -46,7 +46,7 @@ bins+=greedy
 greedy+=greedy.o gl/ sdl/ data/ core/ lib/
 
 tools+=embed
-embed+=embed.o lib/
+embed+=embed.o core/rgba.o core/rgba_kernels.o lib/
 
 BASICS?=$(abspath $(SROOT)/../basics)
 cppflags+=-I$(BASICS)/include
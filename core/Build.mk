@@ -23,4 +23,11 @@ lib.a:=controller.o game.o game_controller.o game_mixer.o game_renderer.o \
 	menu_renderer.o mixer.o mobile.o pacman.o renderer.o rgba.o data.o \
 	toolkit.o engine.o game_phase.o menu_phase.o hall_of_fame.o \
 	hall_of_fame_phase.o console.o fade_io.o credits_phase.o env.o json.o \
-	lang.json.data.o preferences.o
+	lang.json.data.o preferences.o autopilot.o \
+	game_config.o balance.o maze.o soft_renderer.o soft_console.o overlay.o \
+	texture_cache.o rgba_kernels.o
+bins+=rgba_test
+rgba_test:=rgba_test.o rgba_kernels.o
+bins+=game_test
+game_test:=game_test.o game.o level.o items.o ghosts.o pacman.o mobile.o \
+	maze.o data.o ../lib/
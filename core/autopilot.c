@@ -0,0 +1,250 @@
+/*
+ * Open Greedy - an open-source version of Edromel Studio's Greedy XP
+ *
+ * Copyright (C) 2014-2017 Arnaud TROEL
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "autopilot.h"
+
+#include <b6/cmdline.h>
+
+#include "lib/log.h"
+#include "lib/std.h"
+
+#define NO_DISTANCE 0xffff
+
+static unsigned int autopilot_margin = 1;
+b6_flag(autopilot_margin, uint);
+
+static struct place *get_autopilot_neighbor(struct autopilot *self,
+					    struct place *place,
+					    enum direction d)
+{
+	struct place *n = place_neighbor(&self->game->level, place, d);
+	if (n && is_teleport(self->game->level.items, n->item))
+		n = get_teleport_destination(n->item);
+	return n;
+}
+
+static unsigned int get_autopilot_index(const struct autopilot *self,
+					const struct place *place)
+{
+	return place - self->game->level.places;
+}
+
+static int is_autopilot_target(const struct autopilot *self,
+			       const struct place *place)
+{
+	const struct items *items = self->game->level.items;
+	return is_pacgum_item(items, place->item) ||
+		is_super_pacgum_item(items, place->item) ||
+		is_bonus_item(items, place->item);
+}
+
+static int is_autopilot_safe(const struct autopilot *self, unsigned int i,
+			     unsigned int distance)
+{
+	return self->ghost_distance[i] > distance + autopilot_margin;
+}
+
+static void measure_ghost_distance(struct autopilot *self)
+{
+	struct game *game = self->game;
+	unsigned short int *distance = self->ghost_distance;
+	unsigned int head = 0, tail = 0;
+	int i;
+	for (i = 0; i < self->size; i += 1)
+		distance[i] = NO_DISTANCE;
+	for (i = 0; i < game->nghosts; i += 1) {
+		struct mobile *mobile = &game->ghosts[i].mobile;
+		struct place *places[] = { mobile->curr, mobile->next };
+		int j;
+		if (get_ghost_state(&game->ghosts[i]) != GHOST_HUNTER)
+			continue;
+		for (j = 0; j < b6_card_of(places); j += 1) {
+			unsigned int k;
+			if (!places[j])
+				continue;
+			k = get_autopilot_index(self, places[j]);
+			if (distance[k] == NO_DISTANCE) {
+				distance[k] = 0;
+				self->queue[tail++] = k;
+			}
+		}
+	}
+	while (head < tail) {
+		unsigned int curr = self->queue[head++];
+		enum direction d;
+		for_each_direction(d) {
+			struct place *n = get_autopilot_neighbor(
+				self, &game->level.places[curr], d);
+			unsigned int k;
+			if (!n)
+				continue;
+			k = get_autopilot_index(self, n);
+			if (distance[k] != NO_DISTANCE)
+				continue;
+			distance[k] = distance[curr] + 1;
+			self->queue[tail++] = k;
+		}
+	}
+}
+
+/* Breadth-first search of the closest target among the places pacman would
+ * reach well before any hunting ghost.
+ */
+static int find_autopilot_target(struct autopilot *self, struct place *from)
+{
+	struct level *level = &self->game->level;
+	unsigned short int *distance = self->pacman_distance;
+	unsigned int head = 0, tail = 0;
+	int i;
+	for (i = 0; i < self->size; i += 1)
+		distance[i] = NO_DISTANCE;
+	i = get_autopilot_index(self, from);
+	distance[i] = 0;
+	self->queue[tail++] = i;
+	while (head < tail) {
+		unsigned int curr = self->queue[head++];
+		enum direction d;
+		for_each_direction(d) {
+			struct place *n = get_autopilot_neighbor(
+				self, &level->places[curr], d);
+			unsigned int k;
+			if (!n)
+				continue;
+			k = get_autopilot_index(self, n);
+			if (distance[k] != NO_DISTANCE ||
+			    !is_autopilot_safe(self, k, distance[curr] + 1))
+				continue;
+			distance[k] = distance[curr] + 1;
+			self->direction[k] = curr == i ? d : self->direction[curr];
+			if (is_autopilot_target(self, n))
+				return self->direction[k];
+			self->queue[tail++] = k;
+		}
+	}
+	return -1;
+}
+
+static int find_autopilot_escape(struct autopilot *self, struct place *from)
+{
+	unsigned short int best = 0;
+	enum direction d;
+	int i = -1;
+	for_each_direction(d) {
+		struct place *n = get_autopilot_neighbor(self, from, d);
+		unsigned int k;
+		if (!n)
+			continue;
+		k = get_autopilot_index(self, n);
+		if (i < 0 || self->ghost_distance[k] > best) {
+			best = self->ghost_distance[k];
+			i = d;
+		}
+	}
+	return i;
+}
+
+static void autopilot_on_pacman_move(struct game_observer *observer)
+{
+	struct autopilot *self =
+		b6_cast_of(observer, struct autopilot, game_observer);
+	struct game *game = self->game;
+	struct mobile *mobile = &game->pacman.mobile;
+	struct place *from;
+	enum direction d;
+	int i;
+	if (!self->size)
+		return;
+	if (game->stopwatch.frozen &&
+	    get_game_pause_reason(game) == GAME_PAUSED_OTHER)
+		return;
+	from = mobile_is_stopped(mobile) ? mobile->curr : mobile->next;
+	if (from == self->place && !mobile_is_stopped(mobile))
+		return;
+	self->place = from;
+	measure_ghost_distance(self);
+	if ((i = find_autopilot_target(self, from)) < 0 &&
+	    (i = find_autopilot_escape(self, from)) < 0)
+		return;
+	for_each_direction(d)
+		if (d != i)
+			cancel_pacman_move(game, d);
+	submit_pacman_move(game, i);
+}
+
+static void release_autopilot_buffers(struct autopilot *self)
+{
+	b6_deallocate(&b6_std_allocator, self->queue);
+	self->queue = NULL;
+	self->size = 0;
+}
+
+/* All buffers share a single allocation sized after the level. */
+static void autopilot_on_level_init(struct game_observer *observer)
+{
+	struct autopilot *self =
+		b6_cast_of(observer, struct autopilot, game_observer);
+	unsigned int size = get_level_size(&self->game->level);
+	release_autopilot_buffers(self);
+	self->queue = b6_allocate(&b6_std_allocator, size *
+				  (sizeof(*self->queue) +
+				   sizeof(*self->ghost_distance) +
+				   sizeof(*self->pacman_distance) +
+				   sizeof(*self->direction)));
+	if (!self->queue) {
+		log_e(_s("autopilot out of memory"));
+		return;
+	}
+	self->ghost_distance = (unsigned short int*)(self->queue + size);
+	self->pacman_distance = self->ghost_distance + size;
+	self->direction = (unsigned char*)(self->pacman_distance + size);
+	self->size = size;
+}
+
+static void autopilot_on_level_exit(struct game_observer *observer)
+{
+	release_autopilot_buffers(
+		b6_cast_of(observer, struct autopilot, game_observer));
+}
+
+static void autopilot_on_level_start(struct game_observer *observer)
+{
+	b6_cast_of(observer, struct autopilot, game_observer)->place = NULL;
+}
+
+void initialize_autopilot(struct autopilot *self, struct game *game)
+{
+	static const struct game_observer_ops ops = {
+		.on_pacman_move = autopilot_on_pacman_move,
+		.on_level_init = autopilot_on_level_init,
+		.on_level_exit = autopilot_on_level_exit,
+		.on_level_start = autopilot_on_level_start,
+	};
+	self->game = game;
+	self->place = NULL;
+	self->queue = NULL;
+	self->size = 0;
+	add_game_observer(game, setup_game_observer(&self->game_observer,
+						    &ops));
+}
+
+void finalize_autopilot(struct autopilot *self)
+{
+	del_game_observer(&self->game_observer);
+	release_autopilot_buffers(self);
+}
@@ -0,0 +1,43 @@
+/*
+ * Open Greedy - an open-source version of Edromel Studio's Greedy XP
+ *
+ * Copyright (C) 2014-2017 Arnaud TROEL
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef AUTOPILOT_H
+#define AUTOPILOT_H
+
+#include "game.h"
+
+/* Plays the game on behalf of the user: pacman heads to the closest item it
+ * can reach before any hunting ghost, and runs away otherwise.
+ */
+struct autopilot {
+	struct game_observer game_observer;
+	struct game *game;
+	struct place *place;
+	unsigned int size; /* count of places the buffers below can hold */
+	unsigned int *queue;
+	unsigned short int *ghost_distance;
+	unsigned short int *pacman_distance;
+	unsigned char *direction;
+};
+
+extern void initialize_autopilot(struct autopilot *self, struct game *game);
+
+extern void finalize_autopilot(struct autopilot *self);
+
+#endif /* AUTOPILOT_H */
@@ -0,0 +1,292 @@
+/*
+ * Open Greedy - an open-source version of Edromel Studio's Greedy XP
+ *
+ * Copyright (C) 2014-2017 Arnaud TROEL
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Balancing tool: plays many unattended games for each point of a grid of
+ * game config parameters and reports statistics as CSV on the standard output.
+ *
+ *   greedy balance <config> [<param>=<value>[,<value>...]]...
+ *
+ * where <config> is either the name of a registered game config or the path of
+ * a JSON file overriding the default one. Levels come from the default game
+ * unless -balance_game names another one, e.g. "Maze" along with -maze.
+ */
+
+#include "autopilot.h"
+#include "game.h"
+#include "json.h"
+#include "level.h"
+
+#include "lib/init.h"
+#include "lib/log.h"
+#include "lib/rng.h"
+
+#include <b6/clock.h>
+#include <b6/cmdline.h>
+#include <b6/utf8.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+extern unsigned int get_platform_cpu_count(void);
+extern int run_platform_jobs(unsigned int njobs,
+			     void (*job)(unsigned int, void*), void *arg);
+
+static unsigned int balance_games = 16;
+b6_flag(balance_games, uint);
+
+static unsigned int balance_jobs = 0;
+b6_flag(balance_jobs, uint);
+
+static unsigned int balance_minutes = 30;
+b6_flag(balance_minutes, uint);
+
+static unsigned int balance_seed = 0;
+b6_flag(balance_seed, uint);
+
+static const char *balance_game = NULL;
+b6_flag(balance_game, string);
+
+#define BALANCE_STEP_US 10000ULL
+
+struct balance_axis {
+	const char *name;
+	double values[16];
+	unsigned int nvalues;
+};
+
+struct balance {
+	struct game_config base;
+	struct balance_axis axes[8];
+	unsigned int naxes;
+	unsigned long int nconfigs;
+	unsigned int njobs;
+	struct layout_provider *layout_provider;
+};
+
+struct balance_stats {
+	unsigned int games;
+	unsigned int survivors;
+	unsigned int min_score;
+	unsigned int max_score;
+	double score;
+	double level;
+	double minutes;
+};
+
+struct balance_clock {
+	struct b6_clock up;
+	unsigned long long int time;
+};
+
+static unsigned long long int get_balance_clock_time(const struct b6_clock *up)
+{
+	return b6_cast_of(up, struct balance_clock, up)->time;
+}
+
+static void play_balance_game(const struct balance *self,
+			      const struct game_config *config,
+			      unsigned int seed, struct balance_stats *stats)
+{
+	static const struct b6_clock_ops ops = {
+		.get_time = get_balance_clock_time,
+	};
+	static struct game game;
+	static struct autopilot autopilot;
+	struct balance_clock clock;
+	unsigned long long int limit = balance_minutes * 60000000ULL;
+	clock.up.ops = &ops;
+	clock.time = 0;
+	reset_random_number_generator(seed);
+	if (initialize_game(&game, &clock.up, config, self->layout_provider,
+			    0)) {
+		log_e(_s("cannot initialize game"));
+		return;
+	}
+	initialize_autopilot(&autopilot, &game);
+	while (clock.time < limit && play_game(&game)) {
+		update_game(&game);
+		clock.time += BALANCE_STEP_US;
+	}
+	if (!stats->games || stats->min_score > game.pacman.score)
+		stats->min_score = game.pacman.score;
+	if (!stats->games || stats->max_score < game.pacman.score)
+		stats->max_score = game.pacman.score;
+	stats->games += 1;
+	stats->survivors += game.pacman.lifes >= 0;
+	stats->score += game.pacman.score;
+	stats->level += game.n;
+	stats->minutes += clock.time / 60e6;
+	finalize_autopilot(&autopilot);
+	finalize_game(&game);
+}
+
+static void make_balance_config(const struct balance *self, unsigned long int n,
+				struct game_config *config, double *values)
+{
+	unsigned int i;
+	copy_game_config(config, &self->base);
+	for (i = 0; i < self->naxes; i += 1) {
+		const struct balance_axis *axis = &self->axes[i];
+		values[i] = axis->values[n % axis->nvalues];
+		n /= axis->nvalues;
+		set_game_config_param(config, axis->name, values[i]);
+	}
+}
+
+static void run_balance_job(unsigned int job, void *arg)
+{
+	const struct balance *self = arg;
+	unsigned long int n;
+	for (n = job; n < self->nconfigs; n += self->njobs) {
+		struct game_config config;
+		struct balance_stats stats;
+		double values[b6_card_of(self->axes)];
+		char line[1024];
+		int len, i;
+		make_balance_config(self, n, &config, values);
+		memset(&stats, 0, sizeof(stats));
+		for (i = 0; i < balance_games; i += 1)
+			play_balance_game(self, &config, balance_seed + i,
+					  &stats);
+		if (!stats.games)
+			continue;
+		len = snprintf(line, sizeof(line), "%lu", n);
+		for (i = 0; i < self->naxes; i += 1)
+			len += snprintf(line + len, sizeof(line) - len, ",%g",
+					values[i]);
+		snprintf(line + len, sizeof(line) - len,
+			 ",%u,%g,%g,%u,%u,%g,%g\n", stats.games,
+			 (double)stats.survivors / stats.games,
+			 stats.score / stats.games, stats.min_score,
+			 stats.max_score, stats.level / stats.games,
+			 stats.minutes / stats.games);
+		fputs(line, stdout);
+		fflush(stdout);
+	}
+}
+
+static int parse_balance_axis(struct balance_axis *self, char *arg)
+{
+	struct game_config config;
+	char *ptr = strchr(arg, '=');
+	if (!ptr) {
+		log_e(_s("expected <param>=<values>: "), _s(arg));
+		return -1;
+	}
+	*ptr++ = '\0';
+	self->name = arg;
+	if (set_game_config_param(&config, self->name, 0))
+		return -1;
+	for (self->nvalues = 0; *ptr; self->nvalues += 1) {
+		char *end;
+		if (self->nvalues >= b6_card_of(self->values)) {
+			log_e(_s("too many values for "), _s(self->name));
+			return -1;
+		}
+		self->values[self->nvalues] = strtod(ptr, &end);
+		if (end == ptr || (*end && *end != ',')) {
+			log_e(_s("bad value for "), _s(self->name));
+			return -1;
+		}
+		if (set_game_config_param(&config, self->name,
+					  self->values[self->nvalues]))
+			return -1;
+		ptr = *end ? end + 1 : end;
+	}
+	if (!self->nvalues) {
+		log_e(_s("no value for "), _s(self->name));
+		return -1;
+	}
+	return 0;
+}
+
+static int setup_balance_base(struct balance *self, const char *name)
+{
+	const struct game_config *config;
+	struct b6_json *json;
+	struct b6_utf8 utf8;
+	int retval;
+	if ((config = lookup_game_config(b6_utf8_from_ascii(&utf8, name)))) {
+		copy_game_config(&self->base, config);
+		return 0;
+	}
+	copy_game_config(&self->base, get_default_game_config());
+	if (!(json = get_json()))
+		return -1;
+	retval = read_game_config(&self->base, json, name);
+	put_json(json);
+	return retval;
+}
+
+static int balance(struct b6_cmd *cmd, int argc, char *argv[])
+{
+	static struct balance self;
+	unsigned long int n;
+	int i, retval = EXIT_FAILURE;
+	if (argc < 2) {
+		log_e(_s("usage: balance <config> [<param>=<values>]..."));
+		return EXIT_FAILURE;
+	}
+	init_all();
+	if (setup_balance_base(&self, argv[1]))
+		goto bail_out;
+	if (argc - 2 > b6_card_of(self.axes)) {
+		log_e(_s("too many parameters"));
+		goto bail_out;
+	}
+	self.nconfigs = 1;
+	for (self.naxes = 0, i = 2; i < argc; i += 1, self.naxes += 1) {
+		if (parse_balance_axis(&self.axes[self.naxes], argv[i]))
+			goto bail_out;
+		self.nconfigs *= self.axes[self.naxes].nvalues;
+	}
+	for (n = 0; n < self.nconfigs; n += 1) {
+		struct game_config config;
+		double values[b6_card_of(self.axes)];
+		make_balance_config(&self, n, &config, values);
+		if (check_game_config(&config)) {
+			logf_e("inconsistent game config #%lu", n);
+			goto bail_out;
+		}
+	}
+	if (balance_game) {
+		struct b6_utf8 utf8;
+		self.layout_provider = lookup_layout_provider(
+			b6_utf8_from_ascii(&utf8, balance_game));
+		if (!self.layout_provider) {
+			logf_e("unknown game %s", balance_game);
+			goto bail_out;
+		}
+	} else
+		self.layout_provider = get_default_layout_provider();
+	self.njobs = balance_jobs ? balance_jobs : get_platform_cpu_count();
+	if (self.njobs > self.nconfigs)
+		self.njobs = self.nconfigs;
+	fputs("config", stdout);
+	for (i = 0; i < self.naxes; i += 1)
+		printf(",%s", self.axes[i].name);
+	puts(",games,survival,score,min_score,max_score,level,minutes");
+	if (!run_platform_jobs(self.njobs, run_balance_job, &self))
+		retval = EXIT_SUCCESS;
+bail_out:
+	exit_all();
+	return retval;
+}
+b6_cmd(balance);
@@ -34,6 +34,10 @@ struct console_ops {
 	void (*poll)(struct console*);
 	void (*show)(struct console*);
 	void (*close)(struct console*);
+	/* optional: switches to or from fullscreen keeping the renderer and
+	 * its resources, returns -1 when the console has to be reopened.
+	 */
+	int (*fullscreen)(struct console*, int);
 };
 
 extern unsigned short int get_console_width();
@@ -54,6 +58,15 @@ static inline void close_console(struct console *self)
 		self->ops->close(self);
 }
 
+/* Falls back to reopening the console when it cannot switch in place. */
+static inline int switch_console_fullscreen(struct console *self, int value)
+{
+	if (!self->ops->fullscreen || self->ops->fullscreen(self, value))
+		return -1;
+	set_console_fullscreen(value);
+	return 0;
+}
+
 static inline void poll_console(struct console *self)
 {
 	if (self->ops->poll)
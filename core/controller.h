@@ -80,6 +80,7 @@ enum controller_key {
 	CTRLK_PERIOD,
 	CTRLK_COMMA,
 	CTRLK_ENTER,
+	CTRLK_F11,
 	CTRLK_UNKNOWN,
 };
 
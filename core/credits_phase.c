@@ -27,6 +27,7 @@
 #include "json.h"
 #include "mixer.h"
 #include "data.h"
+#include "texture_cache.h"
 #include "toolkit.h"
 
 static const char *credits_skin = "default";
@@ -49,8 +50,8 @@ static void on_render_credits_phase_pacman(struct renderer_observer *observer)
 	unsigned long long int t = b6_get_clock_time(self->clock);
 	struct renderer_base *base = self->tile->parent;
 	float dt = self->t ? (float)(t - self->t) : 0;
-	float x = base->x + self->vx * dt;
-	float y = base->y + self->vy * dt;
+	float x = get_renderer_base_x(base) + self->vx * dt;
+	float y = get_renderer_base_y(base) + self->vy * dt;
 	self->t = t;
 	if ((x <= self->xmin && self->vx < 0) ||
 	    (x >= self->xmax && self->vx > 0))
@@ -71,8 +72,8 @@ static int initialize_credits_phase_pacman(struct credits_phase_pacman *self,
 	};
 	struct renderer_base *base = NULL;
 	struct renderer_texture *texture = NULL;
-	if (!(texture = make_texture(renderer, credits_skin,
-				     CREDITS_PACMAN_DATA_ID)))
+	if (!(texture = get_texture(renderer, credits_skin,
+				    CREDITS_PACMAN_DATA_ID)))
 		goto bail_out;
 	if (!(base = create_renderer_base(renderer, get_renderer_base(renderer),
 					  "pacman", 192, 112)))
@@ -82,10 +83,10 @@ static int initialize_credits_phase_pacman(struct credits_phase_pacman *self,
 		goto bail_out;
 	self->renderer = renderer;
 	self->clock = clock;
-	self->xmin = xmin - self->tile->w / 2;
-	self->ymin = ymin - self->tile->h / 2;
-	self->xmax = xmax - self->tile->w / 2;
-	self->ymax = ymax - self->tile->h / 2;
+	self->xmin = xmin - get_renderer_tile_w(self->tile) / 2;
+	self->ymin = ymin - get_renderer_tile_h(self->tile) / 2;
+	self->xmax = xmax - get_renderer_tile_w(self->tile) / 2;
+	self->ymax = ymax - get_renderer_tile_h(self->tile) / 2;
 	self->vx = 2e-4;
 	self->vy = 2e-4;
 	self->t = 0;
@@ -94,7 +95,7 @@ static int initialize_credits_phase_pacman(struct credits_phase_pacman *self,
 			&renderer_observer_ops));
 	return 0;
 bail_out:
-	destroy_renderer_texture(texture);
+	put_texture(texture);
 	destroy_renderer_base(base);
 	self->tile = NULL;
 	return -1;
@@ -105,7 +106,7 @@ static void finalize_credits_phase_pacman(struct credits_phase_pacman *self)
 	if (!self->tile)
 		return;
 	del_renderer_observer(&self->renderer_observer);
-	destroy_renderer_texture(self->tile->texture);
+	put_texture(get_renderer_tile_texture(self->tile));
 	destroy_renderer_base(self->tile->parent);
 }
 
@@ -159,7 +160,7 @@ static int credits_phase_init(struct phase *up, const struct phase *prev)
 	}
 	if ((self->background = create_renderer_tile(renderer, root, 0, 0,
 						     640, 480, NULL)))
-		set_renderer_tile_texture(self->background, make_texture(
+		set_renderer_tile_texture(self->background, get_texture(
 			renderer, credits_skin, CREDITS_BACKGROUND_DATA_ID));
 	initialize_credits_phase_pacman(&self->pacman, renderer,
 					up->engine->clock, 0, 0, 640, 480);
@@ -221,7 +222,7 @@ static void credits_phase_exit(struct phase *up)
 	finalize_credits_phase_pacman(&self->pacman);
 	finalize_fixed_font(&self->font);
 	if (self->background) {
-		destroy_renderer_texture(self->background->texture);
+		put_texture(get_renderer_tile_texture(self->background));
 		destroy_renderer_tile(self->background);
 	}
 }
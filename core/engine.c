@@ -29,6 +29,7 @@
 #include "mixer.h"
 #include "preferences.h"
 #include "renderer.h"
+#include "texture_cache.h"
 
 B6_REGISTRY_DEFINE(__phase_registry);
 
@@ -37,6 +38,14 @@ static void on_quit(struct controller_observer *observer)
 	b6_cast_of(observer, struct engine, observer)->quit = 1;
 }
 
+static void on_key_pressed(struct controller_observer *observer,
+			   enum controller_key key)
+{
+	struct engine *self = b6_cast_of(observer, struct engine, observer);
+	if (key == CTRLK_F11)
+		toggle_overlay(&self->overlay);
+}
+
 static void on_focus_in(struct controller_observer *observer)
 {
 	struct engine *self = b6_cast_of(observer, struct engine, observer);
@@ -138,6 +147,7 @@ int initialize_engine(struct engine *self, const struct b6_clock *clock,
 		      struct b6_json_object *languages)
 {
 	static const struct controller_observer_ops ops = {
+		.on_key_pressed = on_key_pressed,
 		.on_quit = on_quit,
 		.on_focus_in = on_focus_in,
 		.on_focus_out = on_focus_out,
@@ -157,6 +167,7 @@ int initialize_engine(struct engine *self, const struct b6_clock *clock,
 	self->console = console;
 	self->mixer = mixer;
 	self->pref = pref;
+	set_overlay_game(&self->overlay, NULL);
 	set_console_fullscreen(get_pref_fullscreen(self->pref));
 	set_console_vsync(get_pref_vsync(self->pref));
 	if ((retval = setup_engine_language(self, languages)))
@@ -195,13 +206,17 @@ void finalize_engine(struct engine *self)
 
 void reset_engine(struct engine *self)
 {
+	close_overlay(&self->overlay);
 	stop_renderer(self->console->default_renderer);
+	flush_texture_cache(self->console->default_renderer);
 	del_controller_observer(&self->observer);
 	close_console(self->console);
 	open_console(self->console);
 	add_controller_observer(self->console->default_controller,
 				&self->observer);
 	start_renderer(self->console->default_renderer, 640, 480);
+	open_overlay(&self->overlay, self->console->default_renderer,
+		     self->clock);
 }
 
 static int init_phase(struct phase *self, const struct phase *prev)
@@ -235,6 +250,8 @@ void run_engine(struct engine *self)
 			self->curr = prev;
 			continue;
 		}
+		open_overlay(&self->overlay, self->console->default_renderer,
+			     self->clock);
 		do {
 			poll_console(self->console);
 			next = exec_phase(self->curr);
@@ -242,12 +259,14 @@ void run_engine(struct engine *self)
 			if (b6_unlikely(self->quit))
 				next = NULL;
 		} while (next == self->curr);
+		close_overlay(&self->overlay);
 		exit_phase(self->curr);
 		self->curr->engine = NULL;
 		stop_renderer(self->console->default_renderer);
 		prev = self->curr;
 		self->curr = next;
 	}
+	flush_texture_cache(self->console->default_renderer);
 	del_controller_observer(&self->observer);
 	close_console(self->console);
 }
@@ -27,6 +27,7 @@
 #include "core/controller.h"
 #include "core/hall_of_fame.h"
 #include "core/level.h"
+#include "core/overlay.h"
 
 struct game_result {
 	unsigned long int level; /* final level in the game */
@@ -50,6 +51,7 @@ struct engine {
 	struct b6_json_object *languages;
 	struct b6_json_iterator iter;
 	struct hall_of_fame hall_of_fame;
+	struct overlay overlay;
 };
 
 static inline struct controller *get_engine_controller(const struct engine *e)
@@ -26,6 +26,8 @@
 #include "lib/std.h"
 
 #include <b6/cmdline.h>
+#include <stddef.h>
+#include <string.h>
 
 static int cheat = 0;
 b6_flag(cheat, bool);
@@ -37,7 +39,7 @@ b6_flag(cheat, bool);
 	for (_ghost = (_self)->ghosts, \
 	     (void)((_self)==(struct game*)NULL), \
 	     (void)((_ghost)==(struct ghost*)NULL); \
-	     _ghost < (_self)->ghosts + b6_card_of((_self)->ghosts); \
+	     _ghost < (_self)->ghosts + (_self)->nghosts; \
 	     _ghost += 1) \
 
 #define __for_each_ghost_alive(_self, _ghost) \
@@ -106,7 +108,8 @@ static void defer_game_event(struct game_event *self, unsigned long int delay)
 	struct b6_event_queue *event_queue = &game->event_queue;
 	if (game_event_is_pending(self))
 		b6_cancel_event(event_queue, event);
-	b6_defer_event(event_queue, event, game->time + delay);
+	self->deadline = game->time + delay;
+	b6_defer_event(event_queue, event, self->deadline);
 }
 
 static void cancel_game_event(struct game_event *self)
@@ -323,8 +326,8 @@ static int is_pacman(const struct game *self, const struct mobile* mobile)
 
 static int is_ghost(const struct game *self, const struct ghost* ghost)
 {
-	int retval = ghost == &self->ghosts[0] || ghost == &self->ghosts[1] ||
-		ghost == &self->ghosts[2] || ghost == &self->ghosts[3];
+	int retval = ghost >= self->ghosts &&
+		ghost < self->ghosts + self->nghosts;
 	if (b6_unlikely(!retval))
 		log_e(_s("unexpected mobile; wanted ghost"));
 	return retval;
@@ -877,12 +880,109 @@ static double update_pacman(struct game *self)
 	return d;
 }
 
+/* Ghosts are filed in the cell of the place their position rounds to. Any
+ * mobile closer than one place to a ghost is then in one of the 3x3 cells
+ * around it, which keeps collision checks independent of the ghost count.
+ */
+#define GHOST_NO_CELL 0xffffffff
+
+static int get_ghost_grid_coordinate(double value, unsigned short int size)
+{
+	int i = value + .5;
+	return i < 0 ? 0 : i >= size ? size - 1 : i;
+}
+
+static void unlink_ghost_cell(struct ghost *ghost)
+{
+	if (ghost->cell == GHOST_NO_CELL)
+		return;
+	b6_list_del(&ghost->cell_dref);
+	ghost->cell = GHOST_NO_CELL;
+}
+
+static void link_ghost_cell(struct game *self, struct ghost *ghost)
+{
+	const struct level *level = &self->level;
+	unsigned int cell;
+	if (get_ghost_state(ghost) == GHOST_OUT) {
+		unlink_ghost_cell(ghost);
+		return;
+	}
+	cell = get_ghost_grid_coordinate(ghost->mobile.y, level->height) *
+		level->width +
+		get_ghost_grid_coordinate(ghost->mobile.x, level->width);
+	if (cell == ghost->cell)
+		return;
+	unlink_ghost_cell(ghost);
+	b6_list_add_last(&self->ghost_grid[cell], &ghost->cell_dref);
+	ghost->cell = cell;
+}
+
+static int open_ghost_grid(struct game *self)
+{
+	struct ghost *ghost;
+	unsigned int i, size = get_level_size(&self->level);
+	self->ghost_grid = b6_allocate(&b6_std_allocator,
+				       size * sizeof(*self->ghost_grid));
+	if (!self->ghost_grid) {
+		log_e(_s("cannot allocate ghost grid"));
+		return -1;
+	}
+	for (i = 0; i < size; i += 1)
+		b6_list_initialize(&self->ghost_grid[i]);
+	__for_each_ghost(self, ghost)
+		ghost->cell = GHOST_NO_CELL;
+	return 0;
+}
+
+static void close_ghost_grid(struct game *self)
+{
+	struct ghost *ghost;
+	__for_each_ghost(self, ghost)
+		ghost->cell = GHOST_NO_CELL;
+	b6_deallocate(&b6_std_allocator, self->ghost_grid);
+	self->ghost_grid = NULL;
+}
+
 static void update_ghost(struct game *self, struct ghost *ghost)
 {
 	update_mobile(&ghost->mobile);
+	link_ghost_cell(self, ghost);
 	__notify_game_observers(self, on_ghost_move, ghost);
 }
 
+static void check_pacman_collisions(struct game *self)
+{
+	const struct level *level = &self->level;
+	const struct mobile *pacman = &self->pacman.mobile;
+	int xc = get_ghost_grid_coordinate(pacman->x, level->width);
+	int yc = get_ghost_grid_coordinate(pacman->y, level->height);
+	int x, y;
+	for (y = yc - 1; y <= yc + 1; y += 1) for (x = xc - 1; x <= xc + 1;
+						    x += 1) {
+		struct b6_list *cell;
+		struct b6_dref *dref, *next;
+		if (x < 0 || x >= level->width || y < 0 || y >= level->height)
+			continue;
+		cell = &self->ghost_grid[y * level->width + x];
+		for (dref = b6_list_first(cell); dref != b6_list_tail(cell);
+		     dref = next) {
+			struct ghost *ghost =
+				b6_cast_of(dref, struct ghost, cell_dref);
+			enum ghost_state state = get_ghost_state(ghost);
+			double dx = ghost->mobile.x - pacman->x;
+			double dy = ghost->mobile.y - pacman->y;
+			next = b6_list_walk(dref, B6_NEXT);
+			if (dx * dx + dy * dy >= 1)
+				continue;
+			if (state == GHOST_AFRAID || state == GHOST_FROZEN)
+				pacman_eats_ghost(self, ghost);
+			else if (state == GHOST_HUNTER)
+				game_failed(self);
+		}
+	}
+}
+
 static void do_update_at(struct game *self, unsigned long long int now)
 {
 	struct ghost *ghost;
@@ -914,7 +1014,6 @@ static void do_update_at(struct game *self, unsigned long long int now)
 	__for_each_ghost(self, ghost) {
 		struct mobile *mobile = &ghost->mobile;
 		enum ghost_state state = get_ghost_state(ghost);
-		double dx, dy;
 		if (state == GHOST_OUT)
 			continue;
 		update_ghost(self, ghost);
@@ -923,17 +1022,10 @@ static void do_update_at(struct game *self, unsigned long long int now)
 			set_mobile_speed(&ghost->mobile,
 					 self->config->ghosts_speed);
 			reset_ghost(ghost, &self->level);
-			continue;
+			link_ghost_cell(self, ghost);
 		}
-		dx = mobile->x - pacman->mobile.x;
-		dy = mobile->y - pacman->mobile.y;
-		if (dx * dx + dy * dy >= 1)
-			continue;
-		if (state == GHOST_AFRAID || state == GHOST_FROZEN)
-			pacman_eats_ghost(self, ghost);
-		else if (state == GHOST_HUNTER)
-			game_failed(self);
 	}
+	check_pacman_collisions(self);
 }
 
 static void do_update(struct game *self)
@@ -942,11 +1034,14 @@ static void do_update(struct game *self)
 	unsigned long long int delta = now - self->time;
 	if (!get_next_ops(self) && !self->stopwatch.frozen && delta >= 30000) {
 		logf_w("game catching up: %llu", delta);
-		do
+		self->catch_ups += 1;
+		do {
 			do_update_at(self, self->time + 10000);
-		while (now - self->time > 10000);
+			self->ticks += 1;
+		} while (now - self->time > 10000);
 	}
 	do_update_at(self, now);
+	self->ticks += 1;
 }
 
 static void do_pause(struct game *self)
@@ -964,6 +1059,8 @@ static void do_resume(struct game *self)
 static int init_level(struct game *self, int n)
 {
 	int error = open_level(&self->level, &self->layout);
+	if (!error && (error = open_ghost_grid(self)))
+		close_level(&self->level);
 	if (error) {
 		struct ofstream ofs;
 		logf_w("skipping rejected layout #%d: %d", n, error);
@@ -1015,6 +1112,7 @@ static int init_enter(struct game *self)
 {
 	if (is_level_open(&self->level)) {
 		__notify_game_observers(self, on_level_exit);
+		close_ghost_grid(self);
 		close_level(&self->level);
 	}
 	if (self->pacman.lifes < 0)
@@ -1161,6 +1259,414 @@ static const struct game_ops leave_ops = {
 	.init = init_leave,
 };
 
+static const size_t game_event_offset[] = {
+	offsetof(struct game, bonus_enabled),
+	offsetof(struct game, bonus_disabled),
+	offsetof(struct game, shield),
+	offsetof(struct game, shield_wearing_out),
+	offsetof(struct game, x2),
+	offsetof(struct game, zzz),
+	offsetof(struct game, zzz_recovering),
+	offsetof(struct game, diet),
+	offsetof(struct game, ghosts_vulnerable),
+	offsetof(struct game, ghosts_recovering),
+	offsetof(struct game, banquet),
+	offsetof(struct game, pacman_fast),
+	offsetof(struct game, pacman_slow),
+	offsetof(struct game, ghosts_fast),
+	offsetof(struct game, ghosts_slow),
+};
+
+static struct game_event *get_game_event(struct game *self, int i)
+{
+	return (struct game_event*)((char*)self + game_event_offset[i]);
+}
+
+enum {
+	PLACE_STATE_WALL,
+	PLACE_STATE_EMPTY,
+	PLACE_STATE_PACGUM,
+	PLACE_STATE_SUPER_PACGUM,
+	PLACE_STATE_BONUS,
+	PLACE_STATE_TELEPORT,
+};
+
+static unsigned char save_place_state(const struct game *self,
+				      const struct place *place)
+{
+	const struct items *items = self->level.items;
+	if (!place->item)
+		return PLACE_STATE_WALL;
+	if (is_pacgum_item(items, place->item))
+		return PLACE_STATE_PACGUM;
+	if (is_super_pacgum_item(items, place->item))
+		return PLACE_STATE_SUPER_PACGUM;
+	if (is_bonus_item(items, place->item))
+		return PLACE_STATE_BONUS;
+	if (is_teleport(items, place->item))
+		return PLACE_STATE_TELEPORT;
+	return PLACE_STATE_EMPTY;
+}
+
+static struct item *restore_place_state(struct game *self, unsigned char code)
+{
+	struct items *items = self->level.items;
+	switch (code) {
+	case PLACE_STATE_PACGUM: return clone_pacgum(items);
+	case PLACE_STATE_SUPER_PACGUM: return clone_super_pacgum(items);
+	case PLACE_STATE_BONUS: return &items->bonus.item;
+	default: return clone_empty(items);
+	}
+}
+
+static int is_static_place_state(unsigned char code)
+{
+	return code == PLACE_STATE_WALL || code == PLACE_STATE_TELEPORT;
+}
+
+static unsigned int save_place_index(const struct level *level,
+				     const struct place *place)
+{
+	return place ? place - level->places : GAME_STATE_NO_PLACE;
+}
+
+static struct place *restore_place_index(struct level *level,
+					 unsigned int index)
+{
+	return index < get_level_size(level) ? &level->places[index] : NULL;
+}
+
+static unsigned char *put_state_u8(unsigned char *p, unsigned int v)
+{
+	*p++ = v;
+	return p;
+}
+
+static unsigned char *put_state_u16(unsigned char *p, unsigned int v)
+{
+	*p++ = v;
+	*p++ = v >> 8;
+	return p;
+}
+
+static unsigned char *put_state_u32(unsigned char *p, unsigned long int v)
+{
+	p = put_state_u16(p, v & 0xffff);
+	return put_state_u16(p, (v >> 16) & 0xffff);
+}
+
+static unsigned char *put_state_u64(unsigned char *p,
+				    unsigned long long int v)
+{
+	p = put_state_u32(p, v & 0xffffffff);
+	return put_state_u32(p, (v >> 32) & 0xffffffff);
+}
+
+/* Doubles are stored as their IEEE 754 binary64 representation. */
+static unsigned char *put_state_double(unsigned char *p, double v)
+{
+	unsigned long long int u;
+	b6_static_assert(sizeof(u) == sizeof(v));
+	memcpy(&u, &v, sizeof(u));
+	return put_state_u64(p, u);
+}
+
+static unsigned int get_state_u8(const unsigned char **p)
+{
+	return *(*p)++;
+}
+
+static unsigned int get_state_u16(const unsigned char **p)
+{
+	unsigned int v = get_state_u8(p);
+	return v | get_state_u8(p) << 8;
+}
+
+static unsigned long int get_state_u32(const unsigned char **p)
+{
+	unsigned long int v = get_state_u16(p);
+	return v | (unsigned long int)get_state_u16(p) << 16;
+}
+
+static unsigned long long int get_state_u64(const unsigned char **p)
+{
+	unsigned long long int v = get_state_u32(p);
+	return v | (unsigned long long int)get_state_u32(p) << 32;
+}
+
+static double get_state_double(const unsigned char **p)
+{
+	unsigned long long int u = get_state_u64(p);
+	double v;
+	memcpy(&v, &u, sizeof(v));
+	return v;
+}
+
+enum {
+	/* version, level number, width, height, ghost count and lag */
+	STATE_HEADER_SIZE = 4 + 4 + 2 + 2 + 1 + 8,
+	/* place state */
+	STATE_PLACE_SIZE = 1,
+	/* janitor visits of a place, on levels with a ghosts den */
+	STATE_JANITOR_SIZE = 4,
+	/* pending mask, event delays and quick completion delay */
+	STATE_EVENTS_SIZE = 4 + 8 * b6_card_of(game_event_offset) + 8,
+	/* speed, delta, x, y, age, places, direction, orders, flags */
+	STATE_MOBILE_SIZE = 8 * 4 + 8 + 4 * 2 + 1 + 1 + 4 + 1 + 1,
+	/* introduction event, mobile, state and strategy */
+	STATE_GHOST_SIZE = 1 + 8 + STATE_MOBILE_SIZE + 1 + 1,
+	/* bonus, random number generator and pacman */
+	STATE_WORLD_SIZE = 1 + 4 + STATE_MOBILE_SIZE,
+	/* score, booster, lifes to boost, then casino */
+	STATE_SCORE_SIZE = 4 + 8 + 4 * 9 + 8 * 6 + 4,
+};
+
+unsigned long int get_game_state_size(const struct game *self)
+{
+	unsigned long int size = get_level_size(&self->level);
+	if (self->level.ghosts_home)
+		size *= STATE_PLACE_SIZE + STATE_JANITOR_SIZE;
+	else
+		size *= STATE_PLACE_SIZE;
+	return STATE_HEADER_SIZE + STATE_EVENTS_SIZE + STATE_WORLD_SIZE +
+		STATE_SCORE_SIZE + size + STATE_GHOST_SIZE * self->nghosts;
+}
+
+static unsigned char *save_mobile_state(struct game *self,
+					struct mobile *mobile,
+					unsigned long long int now,
+					unsigned char *p)
+{
+	unsigned char orders[4];
+	struct b6_dref *dref;
+	int i, n = 0;
+	p = put_state_double(p, mobile->speed);
+	p = put_state_double(p, mobile->delta);
+	p = put_state_double(p, mobile->x);
+	p = put_state_double(p, mobile->y);
+	p = put_state_u64(p, now - mobile->timestamp_us);
+	p = put_state_u32(p, save_place_index(&self->level, mobile->curr));
+	p = put_state_u32(p, save_place_index(&self->level, mobile->next));
+	p = put_state_u8(p, mobile->direction);
+	for (dref = b6_list_first(&mobile->orders);
+	     dref != b6_list_tail(&mobile->orders);
+	     dref = b6_list_walk(dref, B6_NEXT))
+		orders[n++] = dref - mobile->moves;
+	p = put_state_u8(p, n);
+	for (i = 0; i < b6_card_of(orders); i += 1)
+		p = put_state_u8(p, i < n ? orders[i] : 0);
+	p = put_state_u8(p, mobile->uturn);
+	return put_state_u8(p, mobile->locked);
+}
+
+static void restore_mobile_state(struct game *self, struct mobile *mobile,
+				 unsigned long long int now,
+				 const unsigned char **p)
+{
+	unsigned char orders[4];
+	int i, n;
+	mobile->speed = get_state_double(p);
+	mobile->delta = get_state_double(p);
+	mobile->x = get_state_double(p);
+	mobile->y = get_state_double(p);
+	mobile->timestamp_us = now - get_state_u64(p);
+	mobile->level = &self->level;
+	mobile->curr = restore_place_index(&self->level, get_state_u32(p));
+	mobile->next = restore_place_index(&self->level, get_state_u32(p));
+	mobile->direction = get_state_u8(p);
+	n = get_state_u8(p);
+	for (i = 0; i < b6_card_of(orders); i += 1)
+		orders[i] = get_state_u8(p);
+	cancel_all_mobile_moves(mobile);
+	while (n-- > 0)
+		if (n < b6_card_of(orders) && orders[n] < 4)
+			submit_mobile_move(mobile, orders[n]);
+	mobile->uturn = get_state_u8(p);
+	mobile->locked = get_state_u8(p);
+}
+
+static unsigned long long int get_game_event_delay(const struct game *self,
+						   struct game_event *event)
+{
+	if (!game_event_is_pending(event) || event->deadline <= self->time)
+		return 0;
+	return event->deadline - self->time;
+}
+
+/* The layout of the blob follows the order in which restore_game_state()
+ * applies it. The janitor visits and the state of the random number generator
+ * are saved as well, so that a restored game unfolds like the original one.
+ * Ghost strategies are only set up on levels with a ghosts den, and so are
+ * the janitor visits.
+ */
+int save_game_state(struct game *self, void *buf, unsigned long int len)
+{
+	unsigned long long int now = b6_get_stopwatch_time(&self->stopwatch);
+	unsigned long int i, size = get_level_size(&self->level);
+	unsigned long int pending = 0;
+	unsigned char *p = buf;
+	if (len < get_game_state_size(self))
+		return -1;
+	p = put_state_u32(p, GAME_STATE_VERSION);
+	p = put_state_u32(p, self->n);
+	p = put_state_u16(p, self->level.width);
+	p = put_state_u16(p, self->level.height);
+	p = put_state_u8(p, self->nghosts);
+	p = put_state_u64(p, now - self->time);
+	for (i = 0; i < size; i += 1)
+		p = put_state_u8(p, save_place_state(self,
+						     &self->level.places[i]));
+	for (i = 0; i < b6_card_of(game_event_offset); i += 1)
+		if (game_event_is_pending(get_game_event(self, i)))
+			pending |= 1 << i;
+	p = put_state_u32(p, pending);
+	for (i = 0; i < b6_card_of(game_event_offset); i += 1)
+		p = put_state_u64(p, get_game_event_delay(
+				self, get_game_event(self, i)));
+	p = put_state_u64(p, self->quick_completion_limit > self->time ?
+			  self->quick_completion_limit - self->time : 0);
+	for (i = 0; i < self->nghosts; i += 1) {
+		struct game_event *event = &self->introduce_ghost[i];
+		p = put_state_u8(p, game_event_is_pending(event));
+		p = put_state_u64(p, get_game_event_delay(self, event));
+	}
+	p = put_state_u8(p, self->items.bonus.contents);
+	if (self->level.ghosts_home)
+		for (i = 0; i < size; i += 1)
+			p = put_state_u32(p, get_janitor_visits(i));
+	p = put_state_u32(p, get_random_number_generator_state());
+	p = save_mobile_state(self, &self->pacman.mobile, now, p);
+	for (i = 0; i < self->nghosts; i += 1) {
+		struct ghost *ghost = &self->ghosts[i];
+		p = save_mobile_state(self, &ghost->mobile, now, p);
+		p = put_state_u8(p, ghost->state);
+		p = put_state_u8(p, get_ghost_strategy_index(ghost));
+	}
+	p = put_state_u32(p, self->pacman.score);
+	p = put_state_double(p, self->pacman.booster);
+	p = put_state_u32(p, self->pacman.lifes);
+	p = put_state_u32(p, self->pacman.shields);
+	p = put_state_u32(p, self->pacman.jewels);
+	p = put_state_u32(p, self->extra_life_score);
+	p = put_state_u32(p, self->pacgum_score);
+	p = put_state_u32(p, self->ghost_score);
+	p = put_state_u32(p, self->quick_completion_bonus);
+	p = put_state_u32(p, self->rewind);
+	p = put_state_u32(p, self->boost);
+	for (i = 0; i < 3; i += 1)
+		p = put_state_double(p, self->casino.value[i]);
+	for (i = 0; i < 3; i += 1)
+		p = put_state_double(p, self->casino.delta[i]);
+	p = put_state_u32(p, self->casino.award);
+	b6_check(p - (unsigned char*)buf == get_game_state_size(self));
+	return 0;
+}
+
+/* Restoring a snapshot only works within the level it was taken from, as the
+ * layout is not part of the state. Events are rescheduled first so that the
+ * side effects of their handlers get overridden by the restored values.
+ */
+int restore_game_state(struct game *self, const void *buf,
+		       unsigned long int len)
+{
+	unsigned long long int now, lag;
+	unsigned long int i, size, pending;
+	const unsigned char *p = buf, *places;
+	unsigned long long int delay[b6_card_of(game_event_offset)];
+	struct ghost *ghost;
+	if (len < 4 || get_state_u32(&p) != GAME_STATE_VERSION) {
+		log_e(_s("unsupported game state version"));
+		return -1;
+	}
+	if (!is_level_open(&self->level) ||
+	    len != get_game_state_size(self) ||
+	    get_state_u32(&p) != self->n ||
+	    get_state_u16(&p) != self->level.width ||
+	    get_state_u16(&p) != self->level.height ||
+	    get_state_u8(&p) != self->nghosts) {
+		logf_e("cannot restore game state in level #%u", self->n);
+		return -1;
+	}
+	now = b6_get_stopwatch_time(&self->stopwatch);
+	if ((lag = get_state_u64(&p)) > now) {
+		log_e(_s("game state lags behind clock"));
+		return -1;
+	}
+	size = get_level_size(&self->level);
+	places = p;
+	for (i = 0; i < size; i += 1) {
+		unsigned char code =
+			save_place_state(self, &self->level.places[i]);
+		if (code == places[i])
+			continue;
+		if (is_static_place_state(code) ||
+		    is_static_place_state(places[i])) {
+			log_e(_s("game state does not match level layout"));
+			return -1;
+		}
+	}
+	p += size;
+	self->time = now - lag;
+	b6_cancel_all_events(&self->event_queue);
+	pending = get_state_u32(&p);
+	for (i = 0; i < b6_card_of(delay); i += 1)
+		delay[i] = get_state_u64(&p);
+	for (i = 0; i < b6_card_of(delay); i += 1)
+		if (pending & (1 << i))
+			defer_game_event(get_game_event(self, i), delay[i]);
+	self->quick_completion_limit = self->time + get_state_u64(&p);
+	for (i = 0; i < self->nghosts; i += 1) {
+		int introduce_pending = get_state_u8(&p);
+		unsigned long long int introduce_delay = get_state_u64(&p);
+		if (introduce_pending)
+			defer_game_event(&self->introduce_ghost[i],
+					 introduce_delay);
+	}
+	self->items.bonus.contents = get_state_u8(&p);
+	for (i = 0; i < size; i += 1) {
+		struct place *place = &self->level.places[i];
+		if (save_place_state(self, place) != places[i])
+			touch_level(self, place,
+				    restore_place_state(self, places[i]));
+	}
+	if (self->level.ghosts_home)
+		for (i = 0; i < size; i += 1)
+			set_janitor_visits(i, get_state_u32(&p));
+	set_random_number_generator_state(get_state_u32(&p));
+	restore_mobile_state(self, &self->pacman.mobile, now, &p);
+	__for_each_ghost(self, ghost) {
+		restore_mobile_state(self, &ghost->mobile, now, &p);
+		ghost->state = get_state_u8(&p);
+		if (set_ghost_strategy_index(ghost, get_state_u8(&p)))
+			log_w(_s("unknown ghost strategy in game state"));
+		link_ghost_cell(self, ghost);
+	}
+	self->pacman.score = get_state_u32(&p);
+	self->pacman.booster = get_state_double(&p);
+	self->pacman.lifes = (int)get_state_u32(&p);
+	self->pacman.shields = (int)get_state_u32(&p);
+	self->pacman.jewels = get_state_u32(&p);
+	self->extra_life_score = get_state_u32(&p);
+	self->pacgum_score = get_state_u32(&p);
+	self->ghost_score = get_state_u32(&p);
+	self->quick_completion_bonus = get_state_u32(&p);
+	self->rewind = (int)get_state_u32(&p);
+	self->boost = (int)get_state_u32(&p);
+	for (i = 0; i < 3; i += 1)
+		self->casino.value[i] = get_state_double(&p);
+	for (i = 0; i < 3; i += 1)
+		self->casino.delta[i] = get_state_double(&p);
+	self->casino.award = get_state_u32(&p);
+	__notify_game_observers(self, on_score_change);
+	__notify_game_observers(self, on_casino_update);
+	__notify_game_observers(self, on_pacman_move);
+	__for_each_ghost(self, ghost) {
+		__notify_game_observers(self, on_ghost_state_change, ghost);
+		__notify_game_observers(self, on_ghost_move, ghost);
+	}
+	return 0;
+}
+
 #define RESET_EVENT(self, event, ops) \
 	reset_game_event(self, &self->event, ops, #event)
 
@@ -1254,7 +1760,28 @@ int initialize_game(struct game *self,
 	};
 	struct ghost *ghost;
 	int i;
+	if (config->ghosts > GAME_MAX_GHOSTS) {
+		logf_e("too many ghosts: %lu > %u", config->ghosts,
+		       GAME_MAX_GHOSTS);
+		return -1;
+	}
+	self->nghosts = config->ghosts;
+	self->ghosts = NULL;
+	self->introduce_ghost = NULL;
+	self->ghost_grid = NULL;
+	if (self->nghosts &&
+	    (!(self->ghosts = b6_allocate(&b6_std_allocator, self->nghosts *
+					  sizeof(*self->ghosts))) ||
+	     !(self->introduce_ghost = b6_allocate(
+		     &b6_std_allocator,
+		     self->nghosts * sizeof(*self->introduce_ghost))))) {
+		log_e(_s("cannot allocate ghosts"));
+		b6_deallocate(&b6_std_allocator, self->ghosts);
+		return -1;
+	}
 	b6_setup_stopwatch(&self->stopwatch, clock);
+	self->ticks = 0;
+	self->catch_ups = 0;
 	b6_reset_fixed_allocator(&self->event_queue_allocator,
 				 &self->event_queue_buffer,
 				 sizeof(self->event_queue_buffer));
@@ -1278,17 +1805,12 @@ int initialize_game(struct game *self,
 	RESET_EVENT(self, pacman_slow, &pacman_slow_ops);
 	RESET_EVENT(self, pacman_fast, &pacman_fast_ops);
 	__for_each_ghost(self, ghost) {
-		static const char *event_name[] = {
-			"introduce_ghost_1",
-			"introduce_ghost_2",
-			"introduce_ghost_3",
-			"introduce_ghost_4"
-		};
 		i = ghost - self->ghosts;
-		initialize_ghost(ghost, i, config->ghosts_speed,
+		initialize_ghost(ghost, i % 4, config->ghosts_speed,
 				 &self->stopwatch.up);
+		ghost->cell = GHOST_NO_CELL;
 		reset_game_event(self, &self->introduce_ghost[i],
-				 &introduce_ghost_ops, event_name[i]);
+				 &introduce_ghost_ops, "introduce_ghost");
 	}
 	b6_list_initialize(&self->observers);
 	initialize_items(&self->items);
@@ -1328,7 +1850,12 @@ void finalize_game(struct game *self)
 {
 	b6_finalize_event_queue(&self->realtime_event_queue);
 	b6_finalize_event_queue(&self->event_queue);
+	if (self->ghost_grid)
+		close_ghost_grid(self);
 	finalize_level(&self->level);
+	finalize_ghost_strategies();
+	b6_deallocate(&b6_std_allocator, self->introduce_ghost);
+	b6_deallocate(&b6_std_allocator, self->ghosts);
 }
 
 B6_REGISTRY_DEFINE(__game_config_registry);
@@ -1364,6 +1891,7 @@ static struct game_config slow_game_config = {
 	.ghosts_slow_duration = 6000000UL,
 	.ghosts_fast_duration = 6000000UL,
 	.quick_completion_limit = 60000000UL,
+	.ghosts = 4,
 };
 
 static struct game_config fast_game_config = {
@@ -1397,6 +1925,7 @@ static struct game_config fast_game_config = {
 	.ghosts_slow_duration = 6000000UL,
 	.ghosts_fast_duration = 6000000UL,
 	.quick_completion_limit = 60000000UL,
+	.ghosts = 4,
 };
 
 static int register_game_configs(void)
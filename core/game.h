@@ -31,10 +31,13 @@
 #include <b6/observer.h>
 #include <b6/registry.h>
 
+#define GAME_MAX_GHOSTS 256
+
 struct game_event {
 	struct b6_event event;
 	const char *name;
 	struct game *game;
+	unsigned long long int deadline;
 };
 
 /* Counting from 0, levels 17, 31, 32, 34, 57.
@@ -83,6 +86,7 @@ struct game_config {
 	unsigned long int ghosts_slow_duration;
 	unsigned long int ghosts_fast_duration;
 	unsigned long int quick_completion_limit;
+	unsigned long int ghosts; /* count of ghosts up to GAME_MAX_GHOSTS */
 };
 
 extern struct b6_registry __game_config_registry;
@@ -111,6 +115,24 @@ static inline const struct game_config *get_next_game_config(
 	return b6_cast_of(entry, struct game_config, entry);
 }
 
+struct b6_json;
+struct b6_json_object;
+
+extern void copy_game_config(struct game_config *self,
+			     const struct game_config *from);
+
+extern int set_game_config_param(struct game_config *self, const char *name,
+				 double value);
+
+/* Tells whether parameters are consistent with each other. */
+extern int check_game_config(const struct game_config *self);
+
+extern int load_game_config(struct game_config *self,
+			    struct b6_json_object *json);
+
+extern int read_game_config(struct game_config *self, struct b6_json *json,
+			    const char *path);
+
 struct game_casino {
 	double value[3];
 	double delta[3];
@@ -136,10 +158,12 @@ struct game {
 	struct item_observer bonus;
 	struct item_observer teleport[2];
 	struct pacman pacman;
-	struct ghost ghosts[4];
+	struct ghost *ghosts;
+	unsigned int nghosts;
+	struct b6_list *ghost_grid; /* ghosts by closest place of the level */
 	struct b6_event_queue realtime_event_queue;
 	struct b6_event_queue event_queue;
-	void *event_queue_buffer[32];
+	void *event_queue_buffer[32 + 2 * GAME_MAX_GHOSTS];
 	struct b6_fixed_allocator event_queue_allocator;
 	struct game_event bonus_enabled;
 	struct game_event bonus_disabled;
@@ -156,7 +180,7 @@ struct game {
 	struct game_event pacman_slow;
 	struct game_event ghosts_fast;
 	struct game_event ghosts_slow;
-	struct game_event introduce_ghost[4];
+	struct game_event *introduce_ghost;
 	struct b6_list infos;
 	unsigned int extra_life_score;
 	unsigned int pacgum_score;
@@ -166,6 +190,8 @@ struct game {
 	unsigned long long int time;
 	unsigned long long int quick_completion_limit;
 	unsigned long int hold;
+	unsigned long int ticks; /* simulation steps run so far */
+	unsigned long int catch_ups; /* updates that lagged behind */
 	const struct game_config *config;
 	int rewind;
 	int boost;
@@ -257,6 +283,25 @@ extern int initialize_game(struct game *self,
 
 extern void finalize_game(struct game *self);
 
+/* Snapshot of a game running a level, relative to the game time so that it can
+ * be restored later on. It is a versioned blob whose fields are stored one by
+ * one with explicit widths in little endian order, so that it can be written
+ * as is and read back on any platform.
+ */
+
+#define GAME_STATE_VERSION 4
+
+#define GAME_STATE_NO_PLACE 0xffffffff
+
+/* Returns the length in bytes of a snapshot of the level being played. */
+extern unsigned long int get_game_state_size(const struct game *self);
+
+/* Writes a snapshot in buf, which should hold get_game_state_size() bytes. */
+extern int save_game_state(struct game *self, void *buf, unsigned long int len);
+
+extern int restore_game_state(struct game *self, const void *buf,
+			      unsigned long int len);
+
 static inline void add_game_hold(struct game *self) { self->hold += 1; }
 
 static inline void remove_game_hold(struct game *self) { self->hold -= 1; }
@@ -0,0 +1,186 @@
+/*
+ * Open Greedy - an open-source version of Edromel Studio's Greedy XP
+ *
+ * Copyright (C) 2014-2017 Arnaud TROEL
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "game.h"
+#include "json.h"
+
+#include "lib/io.h"
+#include "lib/log.h"
+
+#include <b6/json.h>
+#include <b6/utf8.h>
+#include <stddef.h>
+#include <string.h>
+
+struct game_config_param {
+	const char *name;
+	size_t offset;
+	int real;
+};
+
+#define GAME_CONFIG_PARAM(_field, _real) \
+	{ #_field, offsetof(struct game_config, _field), _real }
+
+static const struct game_config_param game_config_params[] = {
+	GAME_CONFIG_PARAM(pacman_speed, 1),
+	GAME_CONFIG_PARAM(ghosts_speed, 1),
+	GAME_CONFIG_PARAM(booster, 1),
+	GAME_CONFIG_PARAM(micro_booster_bonus, 1),
+	GAME_CONFIG_PARAM(small_booster_bonus, 1),
+	GAME_CONFIG_PARAM(large_booster_bonus, 1),
+	GAME_CONFIG_PARAM(small_casino_award, 0),
+	GAME_CONFIG_PARAM(large_casino_award, 0),
+	GAME_CONFIG_PARAM(pacgum_score, 0),
+	GAME_CONFIG_PARAM(jewel_score, 0),
+	GAME_CONFIG_PARAM(ghost_score, 0),
+	GAME_CONFIG_PARAM(ghost_score_limit, 0),
+	GAME_CONFIG_PARAM(extra_life_score, 0),
+	GAME_CONFIG_PARAM(shield_duration, 0),
+	GAME_CONFIG_PARAM(shield_wear_out_duration, 0),
+	GAME_CONFIG_PARAM(banquet_duration, 0),
+	GAME_CONFIG_PARAM(diet_duration, 0),
+	GAME_CONFIG_PARAM(zzz_duration, 0),
+	GAME_CONFIG_PARAM(x2_duration, 0),
+	GAME_CONFIG_PARAM(super_pacgum_duration, 0),
+	GAME_CONFIG_PARAM(ghosts_recovery_duration, 0),
+	GAME_CONFIG_PARAM(ghost_startup_interval, 0),
+	GAME_CONFIG_PARAM(ghost_respawn_duration, 0),
+	GAME_CONFIG_PARAM(bonus_enabled_duration, 0),
+	GAME_CONFIG_PARAM(bonus_disabled_duration, 0),
+	GAME_CONFIG_PARAM(pacman_slow_duration, 0),
+	GAME_CONFIG_PARAM(pacman_fast_duration, 0),
+	GAME_CONFIG_PARAM(ghosts_slow_duration, 0),
+	GAME_CONFIG_PARAM(ghosts_fast_duration, 0),
+	GAME_CONFIG_PARAM(quick_completion_limit, 0),
+	GAME_CONFIG_PARAM(ghosts, 0),
+};
+
+/* Parameters are either positive reals or 32-bit counts. */
+static int set_param(struct game_config *self,
+		     const struct game_config_param *param, double value)
+{
+	void *ptr = (char*)self + param->offset;
+	if (!(value >= 0) || (!param->real && value > 0xffffffff)) {
+		logf_e("game config parameter %s out of range: %g",
+		       param->name, value);
+		return -1;
+	}
+	if (param->real)
+		*(double*)ptr = value;
+	else
+		*(unsigned long int*)ptr = value;
+	return 0;
+}
+
+int set_game_config_param(struct game_config *self, const char *name,
+			  double value)
+{
+	int i;
+	for (i = 0; i < b6_card_of(game_config_params); i += 1)
+		if (!strcmp(game_config_params[i].name, name))
+			return set_param(self, &game_config_params[i], value);
+	logf_e("unknown game config parameter %s", name);
+	return -1;
+}
+
+int check_game_config(const struct game_config *self)
+{
+	if (self->pacman_speed <= 0 || self->ghosts_speed <= 0 ||
+	    self->booster <= 0) {
+		log_e(_s("game config speeds and booster should be positive"));
+		return -1;
+	}
+	if (self->ghosts > GAME_MAX_GHOSTS) {
+		logf_e("too many ghosts in game config: %lu > %u",
+		       self->ghosts, GAME_MAX_GHOSTS);
+		return -1;
+	}
+	/* the ghosts recover before the end of what made them vulnerable */
+	if (self->super_pacgum_duration < self->ghosts_recovery_duration ||
+	    self->zzz_duration < self->ghosts_recovery_duration) {
+		log_e(_s("game config ghosts_recovery_duration exceeds "
+			 "super_pacgum_duration or zzz_duration"));
+		return -1;
+	}
+	if (self->shield_duration < self->shield_wear_out_duration) {
+		log_e(_s("game config shield_wear_out_duration exceeds "
+			 "shield_duration"));
+		return -1;
+	}
+	return 0;
+}
+
+void copy_game_config(struct game_config *self, const struct game_config *from)
+{
+	int i;
+	for (i = 0; i < b6_card_of(game_config_params); i += 1) {
+		size_t offset = game_config_params[i].offset;
+		size_t size = game_config_params[i].real ?
+			sizeof(double) : sizeof(unsigned long int);
+		memcpy((char*)self + offset, (const char*)from + offset, size);
+	}
+}
+
+int load_game_config(struct game_config *self,
+		     struct b6_json_object *json)
+{
+	int i;
+	for (i = 0; i < b6_card_of(game_config_params); i += 1) {
+		const struct game_config_param *param = &game_config_params[i];
+		struct b6_json_number *number;
+		struct b6_utf8 utf8;
+		b6_utf8_from_ascii(&utf8, param->name);
+		if (!(number = b6_json_get_object_as(json, &utf8, number)))
+			continue;
+		if (set_param(self, param, b6_json_get_number(number)))
+			return -1;
+	}
+	return check_game_config(self);
+}
+
+int read_game_config(struct game_config *self, struct b6_json *json,
+		     const char *path)
+{
+	struct ifstream fs;
+	struct json_istream js;
+	struct b6_json_object *object;
+	struct b6_json_parser_info info;
+	enum b6_json_error error;
+	int retval = -1;
+	if (!(object = b6_json_new_object(json))) {
+		log_e(_s("cannot create json object"));
+		return -1;
+	}
+	if (initialize_ifstream(&fs, path)) {
+		log_e(_s("cannot open "), _s(path));
+		goto bail_out;
+	}
+	setup_json_istream(&js, &fs.istream);
+	info.row = info.col = 0;
+	b6_json_reset_parser_info(&info);
+	if ((error = b6_json_parse_object(object, &js.up, &info)))
+		logf_e("%s: json parsing failed (%s): row=%d col=%d", path,
+		       b6_json_strerror(error), info.row, info.col);
+	else
+		retval = load_game_config(self, object);
+	finalize_ifstream(&fs);
+bail_out:
+	b6_json_unref_value(&object->up);
+	return retval;
+}
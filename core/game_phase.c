@@ -19,6 +19,7 @@
 
 #include "lib/init.h"
 
+#include "autopilot.h"
 #include "console.h"
 #include "controller.h"
 #include "engine.h"
@@ -40,11 +41,15 @@ struct game_phase {
 	struct game_mixer mixer;
 	struct game_renderer renderer;
 	struct game_controller controller;
+	struct autopilot autopilot;
 };
 
 static const char *game_skin = NULL;
 b6_flag(game_skin, string);
 
+static int autopilot = 0;
+b6_flag(autopilot, bool);
+
 static struct game_phase *to_game_phase(struct phase *up)
 {
 	return b6_cast_of(up, struct game_phase, up);
@@ -82,6 +87,9 @@ static int game_phase_init(struct phase *up, const struct phase *prev)
 			      up->engine->mixer);
 	initialize_game_controller(&self->controller, &self->game,
 				   get_engine_controller(up->engine));
+	if (autopilot)
+		initialize_autopilot(&self->autopilot, &self->game);
+	set_overlay_game(&up->engine->overlay, &self->game);
 	up->engine->game_result.score = 0;
 	up->engine->game_result.level = 0;
 	return 0;
@@ -98,9 +106,12 @@ static void game_phase_exit(struct phase *up)
 	game_result.score = self->game.pacman.score;
 	game_result.level = self->game.n - 1;
 	set_last_game_result(up->engine, &game_result);
+	set_overlay_game(&up->engine->overlay, NULL);
 	finalize_game_mixer(&self->mixer);
 	finalize_game_renderer(&self->renderer);
 	finalize_game_controller(&self->controller);
+	if (autopilot)
+		finalize_autopilot(&self->autopilot);
 	finalize_game(&self->game);
 }
 
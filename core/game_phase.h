@@ -25,6 +25,7 @@
 #define GAME_LIFE_ICON_DATA_ID "game.life_icon"
 #define GAME_SHIELD_ICON_DATA_ID "game.shield_icon"
 #define GAME_LAYOUT_DATA_ID "game.layout"
+#define GAME_TILES_DATA_ID "game.tiles" /* 48 frames, see get_layout_tile */
 #define GAME_BOTTOM_DATA_ID(where) "game.bottom." where
 #define GAME_PACMAN_DATA_ID(mode, dir) "game.pacman." mode "." dir
 #define GAME_GHOST_DATA_ID(n, mode, dir) "game.ghost." #n "." mode "." dir
@@ -28,6 +28,7 @@
 #include "game_phase.h"
 #include "data.h"
 #include "renderer.h"
+#include "texture_cache.h"
 
 #define for_each_gum(curr, head) \
 	for (curr = head; curr; curr = curr->tile->userdata)
@@ -256,8 +257,8 @@ static int initialize_game_renderer_info(struct game_renderer_info *self,
 		render_fixed_font(&game_renderer->font, utf8, rgba, x / 2, 1);
 	}
 	self->texture = create_renderer_texture(game_renderer->renderer, rgba);
-	self->icon_texture = make_texture(game_renderer->renderer,
-					  game_renderer->skin_id, data_id);
+	self->icon_texture = get_texture(game_renderer->renderer,
+					 game_renderer->skin_id, data_id);
 	self->game_renderer = game_renderer;
 	reset_state(&self->up, ops);
 	return 0;
@@ -266,7 +267,7 @@ static int initialize_game_renderer_info(struct game_renderer_info *self,
 static void finalize_game_renderer_info(struct game_renderer_info *self)
 {
 	if (self->icon_texture)
-		destroy_renderer_texture(self->icon_texture);
+		put_texture(self->icon_texture);
 	if (self->texture)
 		destroy_renderer_texture(self->texture);
 }
@@ -296,7 +297,8 @@ static void game_renderer_count_on_render(struct renderer_observer *obs)
 			copy_rgba(&self->icon, 0, 0, 16, 16,
 				  &self->rgba, 54 - count * 16, 1);
 	}
-	update_renderer_texture(self->tile->texture, &self->rgba);
+	update_renderer_texture(get_renderer_tile_texture(self->tile),
+				&self->rgba);
 }
 
 static void initialize_game_renderer_count(struct game_renderer_count *self,
@@ -346,7 +348,7 @@ static void finalize_game_renderer_count(struct game_renderer_count *self)
 	if (self->icon.p)
 		del_renderer_observer(&self->observer);
 	finalize_rgba(&self->icon);
-	destroy_renderer_texture(self->tile->texture);
+	destroy_renderer_texture(get_renderer_tile_texture(self->tile));
 	destroy_renderer_tile(self->tile);
 }
 
@@ -371,7 +373,8 @@ static void game_renderer_gauge_on_render(struct renderer_observer *obs)
 		  &self->rgba, 0, 0);
 	copy_rgba(&self->skin, 0, 0, self->rendered_width, self->rgba.h,
 		  &self->rgba, 0, 0);
-	update_renderer_texture(self->tile->texture, &self->rgba);
+	update_renderer_texture(get_renderer_tile_texture(self->tile),
+				&self->rgba);
 }
 
 static void initialize_game_renderer_gauge(struct game_renderer_gauge *self,
@@ -423,7 +426,7 @@ static void finalize_game_renderer_gauge(struct game_renderer_gauge *self)
 		del_renderer_observer(&self->observer);
 	finalize_rgba(&self->rgba);
 	finalize_rgba(&self->skin);
-	destroy_renderer_texture(self->tile->texture);
+	destroy_renderer_texture(get_renderer_tile_texture(self->tile));
 	destroy_renderer_tile(self->tile);
 }
 
@@ -614,7 +617,7 @@ static void finalize_game_renderer_jewels(struct game_renderer_jewels *self)
 	if (!linear_is_stopped(&self->linear))
 		del_renderer_observer(&self->renderer_observer);
 	for (i = 0; i < b6_card_of(self->tiles); i += 1) {
-		destroy_renderer_texture(self->textures[i]);
+		put_texture(self->textures[i]);
 		destroy_renderer_tile(self->tiles[i]);
 	}
 }
@@ -627,7 +630,7 @@ static int initialize_game_renderer_jewel(struct renderer *renderer,
 					  struct renderer_tile **tile,
 					  struct renderer_texture **texture)
 {
-	*texture = make_texture(renderer, skin_id, data_id);
+	*texture = get_texture(renderer, skin_id, data_id);
 	*tile = create_renderer_tile(renderer, base, x, y, 32, 32, NULL);
 	return *texture && *tile ? 0 : -1;
 }
@@ -680,7 +683,7 @@ static void game_renderer_popup_on_render(struct renderer_observer *obs)
 		b6_cast_of(obs, struct game_renderer_popup, renderer_observer);
 	struct renderer_base *base = self->tile->parent;
 	if (b6_likely(!linear_is_stopped(&self->linear))) {
-		double x = base->x;
+		double x = get_renderer_base_x(base);
 		double y = update_linear(&self->linear);
 		move_renderer_base(base, x, y);
 	} else {
@@ -741,7 +744,7 @@ static void finalize_game_renderer_popup(struct game_renderer_popup *self)
 		return;
 	if (!linear_is_stopped(&self->linear))
 		del_renderer_observer(&self->renderer_observer);
-	destroy_renderer_texture(self->tile->texture);
+	destroy_renderer_texture(get_renderer_tile_texture(self->tile));
 	destroy_renderer_base(self->tile->parent);
 }
 
@@ -759,6 +762,169 @@ static void trigger_game_renderer_popup(struct game_renderer_popup *self,
 	reset_linear(&self->linear, y, y - 64, 15e-5);
 }
 
+/* Levels that do not fit in the 640x400 area below the panel are scrolled so
+ * that pacman stays in sight, smaller ones are centered.
+ */
+static double get_playground_offset(double view, double size, double focus)
+{
+	double offset = (view - size) / 2;
+	if (offset >= 0)
+		return (int)offset;
+	offset = view / 2 - focus;
+	if (offset > 0)
+		return 0;
+	if (offset < view - size)
+		return view - size;
+	return (int)offset;
+}
+
+static void scroll_playground(struct game_renderer *self)
+{
+	const struct renderer_tile *tile = self->playground;
+	const struct mobile *mobile = &self->game->pacman.mobile;
+	double w = get_renderer_tile_w(tile), h = get_renderer_tile_h(tile);
+	move_renderer_base(get_renderer_tile_base(tile),
+			   get_playground_offset(640, w, 16 * mobile->x + 16),
+			   80 + get_playground_offset(400, h,
+						      16 * mobile->y + 16));
+}
+
+static int resize_playground(struct game_renderer *self,
+			     const struct rgba *rgba)
+{
+	struct renderer_tile *tile = self->playground;
+	struct renderer_texture *texture = get_renderer_tile_texture(tile);
+	if (get_renderer_tile_w(tile) == rgba->w &&
+	    get_renderer_tile_h(tile) == rgba->h) {
+		update_renderer_texture(texture, rgba);
+		return 0;
+	}
+	if (!(texture = create_renderer_texture(self->renderer, rgba)))
+		return -1;
+	destroy_renderer_texture(get_renderer_tile_texture(tile));
+	set_renderer_tile_texture(tile, texture);
+	resize_renderer_tile(tile, rgba->w, rgba->h);
+	return 0;
+}
+
+/* Lets the renderer draw the maze out of its tiles, so that only the map is
+ * uploaded rather than the pixels of the whole playground.
+ */
+static int compose_playground(struct game_renderer *self,
+			      const struct layout *layout)
+{
+	struct renderer_tile *tile = self->playground;
+	unsigned char *map;
+	unsigned short int x, y;
+	struct rgba rgba;
+	int retval;
+	if (!self->tiles)
+		return -1;
+	if (get_renderer_tile_w(tile) != 16 * layout->width ||
+	    get_renderer_tile_h(tile) != 16 * layout->height) {
+		if (initialize_rgba(&rgba, 16 * layout->width,
+				    16 * layout->height))
+			return -1;
+		clear_rgba(&rgba, 0);
+		retval = resize_playground(self, &rgba);
+		finalize_rgba(&rgba);
+		if (retval)
+			return -1;
+	}
+	if (!(map = b6_allocate(&b6_std_allocator,
+				layout->width * layout->height)))
+		return -1;
+	for (y = 0; y < layout->height; y += 1)
+		for (x = 0; x < layout->width; x += 1)
+			map[x + y * layout->width] =
+				get_layout_tile(layout, x, y);
+	retval = compose_renderer_texture(get_renderer_tile_texture(tile),
+					  self->tiles, map, layout->width,
+					  layout->height, 16, 16);
+	b6_deallocate(&b6_std_allocator, map);
+	return retval;
+}
+
+static void update_playground(struct game_renderer *self,
+			      struct layout *layout)
+{
+	struct data_entry *entry;
+	struct image_data *data;
+	if (!compose_playground(self, layout))
+		return;
+	if (get_image_data(self->skin_id, GAME_LAYOUT_DATA_ID, layout, &entry,
+			   &data)) {
+		log_e(_s("cannot update playground texture"));
+		return;
+	}
+	if (resize_playground(self, data->rgba))
+		log_e(_s("cannot resize playground texture"));
+	put_image_data(entry, data);
+}
+
+static int resize_pacgums(struct game_renderer *self,
+			  unsigned short int w, unsigned short int h)
+{
+	struct renderer_tile *tile = self->pacgums;
+	struct renderer_texture *texture;
+	struct rgba rgba;
+	if (self->pacgums_rgba.w == w && self->pacgums_rgba.h == h) {
+		clear_rgba(&self->pacgums_rgba, 0);
+		return 0;
+	}
+	if (initialize_rgba(&rgba, w, h))
+		return -1;
+	clear_rgba(&rgba, 0);
+	if (!(texture = create_renderer_texture(self->renderer, &rgba))) {
+		finalize_rgba(&rgba);
+		return -1;
+	}
+	destroy_renderer_texture(get_renderer_tile_texture(tile));
+	set_renderer_tile_texture(tile, texture);
+	finalize_rgba(&self->pacgums_rgba);
+	self->pacgums_rgba = rgba;
+	resize_renderer_tile(tile, w, h);
+	return 0;
+}
+
+static void put_pacgum(struct game_renderer *self, int x, int y)
+{
+	const struct rgba *gum = &self->pacgum_rgba;
+	copy_rgba(gum, 0, 0, gum->w, gum->h, &self->pacgums_rgba,
+		  16 * x + 16 - gum->w / 2, 16 * y + 16 - gum->h / 2);
+	self->pacgums_dirty = 1;
+}
+
+/* Only the rectangle around the gums eaten since the last frame is uploaded.
+ */
+static void wipe_pacgum(struct game_renderer *self, int x, int y)
+{
+	const struct rgba *gum = &self->pacgum_rgba;
+	unsigned short int x1 = 16 * x + 16 - gum->w / 2;
+	unsigned short int y1 = 16 * y + 16 - gum->h / 2;
+	unsigned short int x2 = x1 + gum->w, y2 = y1 + gum->h;
+	fill_rgba(&self->pacgums_rgba, x1, y1, gum->w, gum->h, 0);
+	if (x2 > self->pacgums_rgba.w)
+		x2 = self->pacgums_rgba.w;
+	if (y2 > self->pacgums_rgba.h)
+		y2 = self->pacgums_rgba.h;
+	if (self->pacgums_x1 >= self->pacgums_x2) {
+		self->pacgums_x1 = x1;
+		self->pacgums_y1 = y1;
+		self->pacgums_x2 = x2;
+		self->pacgums_y2 = y2;
+		return;
+	}
+	if (self->pacgums_x1 > x1)
+		self->pacgums_x1 = x1;
+	if (self->pacgums_y1 > y1)
+		self->pacgums_y1 = y1;
+	if (self->pacgums_x2 < x2)
+		self->pacgums_x2 = x2;
+	if (self->pacgums_y2 < y2)
+		self->pacgums_y2 = y2;
+}
+
 static void on_level_init(struct game_observer *game_observer)
 {
 	struct game_renderer *self = to_game_renderer(game_observer);
@@ -768,37 +934,29 @@ static void on_level_init(struct game_observer *game_observer)
 	int x, y;
 	char s[] = "000";
 	struct level_iterator iterator;
-	struct data_entry *entry;
-	struct image_data *data;
 	struct b6_utf8 utf8;
 
-	if (!(get_image_data(self->skin_id, GAME_LAYOUT_DATA_ID, layout, &entry,
-			     &data))) {
-		update_renderer_texture(
-			get_renderer_tile_texture(self->playground),
-			data->rgba);
-		put_image_data(entry, data);
-	} else
-		log_e(_s("cannot update playground texture"));
+	update_playground(self, layout);
+	if (resize_pacgums(self, get_renderer_tile_w(self->playground),
+			   get_renderer_tile_h(self->playground)))
+		log_e(_s("cannot resize pac-gums texture"));
+	self->pacgums_dirty = 1;
 
+	self->gums = b6_allocate(&b6_std_allocator,
+				 get_level_size(level) * sizeof(*self->gums));
+	if (!self->gums)
+		log_p(_s("out of memory"));
 	initialize_level_iterator(&iterator, level);
-	self->pacgums = NULL;
 	self->super_pacgums = NULL;
 	while (level_iterator_has_next(&iterator)) {
 		struct place *place = level_iterator_next(&iterator);
 		struct item *item = place->item;
 		struct toolkit_image *image;
 		place_location(level, place, &x, &y);
-		image = &self->gums[x][y];
-		if (is_pacgum_item(items, item)) {
-			initialize_toolkit_image(
-				image, self->renderer,
-				get_renderer_tile_base(self->playground),
-				16 * x + 12, 16 * y + 12, 8, 8,
-				self->pacgum_texture);
-			image->tile->userdata = self->pacgums;
-			self->pacgums = image;
-		} else if (is_super_pacgum_item(items, item)) {
+		image = &self->gums[place - level->places];
+		if (is_pacgum_item(items, item))
+			put_pacgum(self, x, y);
+		else if (is_super_pacgum_item(items, item)) {
 			initialize_toolkit_image(
 				image, self->renderer,
 				get_renderer_tile_base(self->playground),
@@ -813,6 +971,7 @@ static void on_level_init(struct game_observer *game_observer)
 		place_location(level, level->bonus_place, &x, &y);
 		move_game_renderer_sprite(&self->bonus, x, y);
 	}
+	scroll_playground(self);
 
 	b6_reset_event(&self->hold.event, NULL);
 	self->rendered_score = self->notified_score - 1;
@@ -820,7 +979,7 @@ static void on_level_init(struct game_observer *game_observer)
 	s[0] += (self->game->n / 100) % 10;
 	s[1] += (self->game->n / 10) % 10;
 	s[2] += self->game->n % 10;
-	set_toolkit_label(&self->level, b6_utf8_from_ascii(&utf8, s));
+	set_toolkit_text(&self->level, b6_utf8_from_ascii(&utf8, s));
 }
 
 static void on_level_exit(struct game_observer *game_observer)
@@ -831,9 +990,8 @@ static void on_level_exit(struct game_observer *game_observer)
 	for_each_gum_safe(curr, next, self->super_pacgums)
 		finalize_toolkit_image(curr);
 	self->super_pacgums = NULL;
-	for_each_gum_safe(curr, next, self->pacgums)
-		finalize_toolkit_image(curr);
-	self->pacgums = NULL;
+	b6_deallocate(&b6_std_allocator, self->gums);
+	self->gums = NULL;
 }
 
 static void on_level_enter(struct game_observer *game_observer)
@@ -865,12 +1023,16 @@ static void on_level_touch(struct game_observer *game_observer,
 			   struct item *item)
 {
 	struct game_renderer *self = to_game_renderer(game_observer);
-	struct items *items = self->game->level.items;
-	int x, y;
-	place_location(&self->game->level, place, &x, &y);
-	if (is_pacgum_item(items, item) || is_super_pacgum_item(items, item)) {
-		hide_toolkit_image(&self->gums[x][y]);
-		self->gums[x][y].texture = NULL;
+	struct level *level = &self->game->level;
+	struct items *items = level->items;
+	if (is_pacgum_item(items, item)) {
+		int x, y;
+		place_location(level, place, &x, &y);
+		wipe_pacgum(self, x, y);
+	} else if (is_super_pacgum_item(items, item)) {
+		struct toolkit_image *image = &self->gums[place - level->places];
+		hide_toolkit_image(image);
+		image->texture = NULL;
 	} else if (is_bonus_item(items, place->item)) {
 		enum bonus_type contents = get_bonus_contents(place->item);
 		set_game_renderer_sprite_cartoon(
@@ -941,6 +1103,7 @@ static void on_pacman_move(struct game_observer *game_observer)
 	const struct mobile *mobile = &self->game->pacman.mobile;
 	move_game_renderer_sprite(&self->pacman, mobile->x, mobile->y);
 	self->pacman_direction = mobile->direction;
+	scroll_playground(self);
 }
 
 static void on_extra_life(struct game_observer *game_observer)
@@ -961,8 +1124,8 @@ static void on_score_bump(struct game_observer *game_observer,
 {
 	struct game_renderer *self = to_game_renderer(game_observer);
 	struct renderer_base *base = self->pacman.tile->parent;
-	double x = base->x + 2;
-	double y = base->y;
+	double x = get_renderer_base_x(base) + 2;
+	double y = get_renderer_base_y(base);
 	amount /= 100;
 	if (amount > 0 && amount <= b6_card_of(self->points))
 		trigger_game_renderer_popup(&self->points[amount - 1], x, y);
@@ -1036,27 +1199,28 @@ static void on_ghost_move(struct game_observer *game_observer,
 			  const struct ghost *ghost)
 {
 	struct game_renderer *self = to_game_renderer(game_observer);
-	move_game_renderer_sprite(&self->ghosts[ghost - self->game->ghosts],
-				  ghost->mobile.x, ghost->mobile.y);
+	move_game_renderer_sprite(
+		&self->ghosts[ghost - self->game->ghosts].sprite,
+		ghost->mobile.x, ghost->mobile.y);
 }
 
 static void on_ghost_state_change(struct game_observer *game_observer,
 				  const struct ghost *ghost)
 {
 	struct game_renderer *self = to_game_renderer(game_observer);
-	int n = ghost - self->game->ghosts;
+	struct game_renderer_ghost *g = &self->ghosts[ghost - self->game->ghosts];
 	switch (get_ghost_state(ghost)) {
 	case GHOST_ZOMBIE:
-		self->ghosts_state[n] = 0;
+		g->state = 0;
 		break;
 	case GHOST_OUT:
-		if (self->ghosts_state[n] == -1)
+		if (g->state == -1)
 			break;
-		set_game_renderer_sprite_cartoon(&self->ghosts[n], NULL);
-		self->ghosts_state[n] = -1;
+		set_game_renderer_sprite_cartoon(&g->sprite, NULL);
+		g->state = -1;
 		break;
 	default:
-		self->ghosts_state[n] = 1;
+		g->state = 1;
 	}
 }
 
@@ -1156,13 +1320,13 @@ static void on_wipeout(struct game_observer *game_observer)
 {
 	struct game_renderer *self = to_game_renderer(game_observer);
 	int i;
-	for (i = 0; i < b6_card_of(self->ghosts); i += 1) {
-		struct cartoon *cartoon = &self->wiped_out[i];
-		if (self->ghosts_state[i] <= 0)
+	for (i = 0; i < self->nghosts; i += 1) {
+		struct game_renderer_ghost *g = &self->ghosts[i];
+		if (g->state <= 0)
 			continue;
-		reset_cartoon(cartoon, self->time);
-		self->ghosts_state[i] = -1;
-		set_game_renderer_sprite_cartoon(&self->ghosts[i], cartoon);
+		reset_cartoon(&g->wiped_out, self->time);
+		g->state = -1;
+		set_game_renderer_sprite_cartoon(&g->sprite, &g->wiped_out);
 	}
 	publish_game_renderer_info(&self->wiped_out_info);
 }
@@ -1209,11 +1373,11 @@ static void game_renderer_on_render(struct renderer_observer *observer)
 		cartoon = &self->pacman_cartoons[blink][self->pacman_direction];
 	if (self->pacman_state <= 1)
 		set_game_renderer_sprite_cartoon(&self->pacman, cartoon);
-	for (n = 0; n < b6_card_of(self->ghosts_state); n += 1) {
-		cartoon = &self->hunter[n];
-		if (self->ghosts_state[n] < 0)
+	for (n = 0; n < self->nghosts; n += 1) {
+		cartoon = &self->hunter[n % b6_card_of(self->hunter)];
+		if (self->ghosts[n].state < 0)
 			continue;
-		if (!self->ghosts_state[n])
+		if (!self->ghosts[n].state)
 			cartoon = &self->zombie;
 		else if (self->locked_state >= 0) {
 			if (self->locked_state || blink)
@@ -1223,8 +1387,20 @@ static void game_renderer_on_render(struct renderer_observer *observer)
 		} else if (self->afraid_state > 0 ||
 			   (!self->afraid_state && blink))
 			cartoon = &self->afraid;
-		set_game_renderer_sprite_cartoon(&self->ghosts[n], cartoon);
+		set_game_renderer_sprite_cartoon(&self->ghosts[n].sprite,
+						 cartoon);
 	}
+	if (self->pacgums_dirty)
+		update_renderer_texture(get_renderer_tile_texture(self->pacgums),
+					&self->pacgums_rgba);
+	else if (self->pacgums_x1 < self->pacgums_x2)
+		patch_renderer_texture(get_renderer_tile_texture(self->pacgums),
+				       &self->pacgums_rgba,
+				       self->pacgums_x1, self->pacgums_y1,
+				       self->pacgums_x2 - self->pacgums_x1,
+				       self->pacgums_y2 - self->pacgums_y1);
+	self->pacgums_dirty = 0;
+	self->pacgums_x1 = self->pacgums_x2 = 0;
 	if (self->time / 500000 & 1)
 		for_each_gum(image, self->super_pacgums)
 			hide_toolkit_image(image);
@@ -1242,7 +1418,7 @@ static void game_renderer_on_render(struct renderer_observer *observer)
 			s[i] += score % 10;
 			score /= 10;
 		}
-		set_toolkit_label(&self->score, b6_utf8_from_ascii(&utf8, s));
+		set_toolkit_text(&self->score, b6_utf8_from_ascii(&utf8, s));
 	}
 }
 
@@ -1276,12 +1452,92 @@ fail_base:
 	return NULL;
 }
 
+/* Returns NULL when the renderer cannot compose the playground or the skin
+ * has no tiles to compose it of.
+ */
+static struct renderer_texture *create_tiles(struct game_renderer *self)
+{
+	struct renderer_texture *texture =
+		get_renderer_tile_texture(self->playground);
+	struct data_entry *entry;
+	struct image_data *data;
+	struct rgba rgba;
+	unsigned int i;
+	if (!renderer_texture_can_compose(texture))
+		return NULL;
+	if (get_image_data_no_fallback(self->skin_id, GAME_TILES_DATA_ID, NULL,
+				       &entry, &data))
+		return NULL;
+	texture = NULL;
+	if (!initialize_rgba(&rgba, data->w * data->length, data->h)) {
+		for (i = 0; i < data->length; i += 1)
+			copy_rgba(data->rgba, data->x[i], data->y[i],
+				  data->w, data->h, &rgba, i * data->w, 0);
+		texture = create_renderer_texture(self->renderer, &rgba);
+		finalize_rgba(&rgba);
+	}
+	put_image_data(entry, data);
+	return texture;
+}
+
 static void destroy_playground(struct renderer_tile *tile)
 {
 	destroy_renderer_texture(get_renderer_tile_texture(tile));
 	destroy_renderer_base(get_renderer_tile_base(tile));
 }
 
+static int create_pacgums(struct game_renderer *self,
+			  struct renderer_base *base)
+{
+	struct rgba *rgba = &self->pacgums_rgba;
+	struct renderer_texture *texture;
+	struct data_entry *entry;
+	struct image_data *data;
+	if (initialize_rgba(rgba, LEVEL_WIDTH * 16, LEVEL_HEIGHT * 16))
+		goto fail_rgba;
+	clear_rgba(rgba, 0);
+	if (!(texture = create_renderer_texture(self->renderer, rgba)))
+		goto fail_texture;
+	self->pacgums = create_renderer_tile(self->renderer, base, 0, 0,
+					     rgba->w, rgba->h, texture);
+	if (!self->pacgums)
+		goto fail_tile;
+	self->pacgums_dirty = 0;
+	self->pacgums_x1 = self->pacgums_x2 = 0;
+	self->pacgum_rgba.w = self->pacgum_rgba.h = 0;
+	self->pacgum_rgba.p = NULL;
+	if (get_image_data(self->skin_id, GAME_PACGUM_DATA_ID, NULL, &entry,
+			   &data)) {
+		log_w(_s("cannot load pac-gum image"));
+		return 0;
+	}
+	if (!initialize_rgba(&self->pacgum_rgba, data->w, data->h))
+		copy_rgba(data->rgba, *data->x, *data->y, data->w, data->h,
+			  &self->pacgum_rgba, 0, 0);
+	else {
+		log_w(_s("out of memory"));
+		self->pacgum_rgba.w = self->pacgum_rgba.h = 0;
+		self->pacgum_rgba.p = NULL;
+	}
+	put_image_data(entry, data);
+	return 0;
+fail_tile:
+	destroy_renderer_texture(texture);
+fail_texture:
+	finalize_rgba(rgba);
+fail_rgba:
+	return -1;
+}
+
+static void destroy_pacgums(struct game_renderer *self)
+{
+	if (self->pacgum_rgba.p)
+		finalize_rgba(&self->pacgum_rgba);
+	destroy_renderer_texture(get_renderer_tile_texture(self->pacgums));
+	destroy_renderer_tile(self->pacgums);
+	finalize_rgba(&self->pacgums_rgba);
+}
+
 static int create_pacman(struct game_renderer *self, struct renderer_base *base)
 {
 	initialize_game_renderer_sprite(&self->pacman, self, base,
@@ -1384,22 +1640,36 @@ static void destroy_bonus(struct game_renderer *self)
 	finalize_game_renderer_sprite(&self->bonus);
 }
 
-static int create_ghosts(struct game_renderer *self,
-			 struct renderer_base **base)
+/* Ghosts beyond the fourth one reuse the looks of the first four. */
+static int create_ghosts(struct game_renderer *self, struct renderer_base *base)
 {
+	static const char *data_id[] = {
+		GAME_GHOST_DATA_ID(0, "normal", "n"),
+		GAME_GHOST_DATA_ID(1, "normal", "n"),
+		GAME_GHOST_DATA_ID(2, "normal", "n"),
+		GAME_GHOST_DATA_ID(3, "normal", "n"),
+	};
 	int i;
-	for (i = 0; i < b6_card_of(self->ghosts); i += 1) {
-		static const char *data_id[] = {
-			GAME_GHOST_DATA_ID(0, "normal", "n"),
-			GAME_GHOST_DATA_ID(1, "normal", "n"),
-			GAME_GHOST_DATA_ID(2, "normal", "n"),
-			GAME_GHOST_DATA_ID(3, "normal", "n"),
-		};
-		initialize_game_renderer_sprite(&self->ghosts[i], self, *base++,
-						0, 0, 32, 32);
+	b6_static_assert(b6_card_of(data_id) == b6_card_of(self->hunter));
+	self->nghosts = self->game->nghosts;
+	self->ghosts = NULL;
+	if (self->nghosts && !(self->ghosts = b6_allocate(
+			&b6_std_allocator,
+			self->nghosts * sizeof(*self->ghosts)))) {
+		log_e(_s("cannot allocate ghost sprites"));
+		self->nghosts = 0;
+		return -1;
+	}
+	for (i = 0; i < self->nghosts; i += 1) {
+		struct renderer_base *ghost_base = create_renderer_base_or_die(
+			self->renderer, base, "ghost", 0, 0);
+		initialize_game_renderer_sprite(&self->ghosts[i].sprite, self,
+						ghost_base, 0, 0, 32, 32);
+		self->ghosts[i].state = -1;
+	}
+	for (i = 0; i < b6_card_of(self->hunter); i += 1)
 		create_cartoon(&self->hunter[i], self->renderer, self->skin_id,
 			       data_id[i], 1);
-	}
 	create_cartoon(&self->afraid, self->renderer, self->skin_id,
 		       GAME_GHOST_DATA_ID(0, "afraid", "n"), 1);
 	create_cartoon(&self->locked, self->renderer, self->skin_id,
@@ -1417,8 +1687,9 @@ static void destroy_ghosts(struct game_renderer *self)
 	destroy_cartoon(&self->afraid);
 	for (i = 0; i < b6_card_of(self->hunter); i += 1)
 		destroy_cartoon(&self->hunter[i]);
-	for (i = 0; i < b6_card_of(self->ghosts); i += 1)
-		finalize_game_renderer_sprite(&self->ghosts[i]);
+	for (i = 0; i < self->nghosts; i += 1)
+		finalize_game_renderer_sprite(&self->ghosts[i].sprite);
+	b6_deallocate(&b6_std_allocator, self->ghosts);
 }
 
 int create_points_popup(struct game_renderer *self, struct renderer_base **base)
@@ -1461,15 +1732,18 @@ static int create_panel(struct game_renderer *self, struct renderer_base *base,
 	font_h = get_fixed_font_height(&self->font);
 	if ((self->top = create_renderer_tile(self->renderer, base,
 					      0, 0, 640, 80, NULL)))
-		set_renderer_tile_texture(self->top, make_texture(
+		set_renderer_tile_texture(self->top, get_texture(
 				self->renderer, self->skin_id,
 				GAME_PANEL_DATA_ID));
-	initialize_toolkit_label(&self->level, self->renderer, &self->font,
-				 3 * font_w + 2, font_h + 2, base,
-				 6, 53, 50, 18);
-	initialize_toolkit_label(&self->score, self->renderer, &self->font,
-				 8 * font_w + 2, font_h + 2, base,
-				 77, 53, 128, 18);
+	if (initialize_toolkit_glyphs(&self->glyphs, self->renderer,
+				      &self->font, 0) ||
+	    initialize_toolkit_text(&self->level, self->renderer, &self->glyphs,
+				    3 * font_w + 2, font_h + 2, base,
+				    6, 53, 50, 18) ||
+	    initialize_toolkit_text(&self->score, self->renderer, &self->glyphs,
+				    8 * font_w + 2, font_h + 2, base,
+				    77, 53, 128, 18))
+		log_p(_s("cannot create panel text"));
 	self->info_tile = create_renderer_tile(self->renderer, base,
 					       264, 53, 224, 18, NULL);
 	self->info_icon_tile = create_renderer_tile(self->renderer, base,
@@ -1601,12 +1875,12 @@ static int create_panel(struct game_renderer *self, struct renderer_base *base,
 	finalize_rgba(&scratch);
 	if ((self->bottom[0] = create_renderer_tile(self->renderer, base,
 						    0, 476, 4, 4, NULL)))
-		set_renderer_tile_texture(self->bottom[0], make_texture(
+		set_renderer_tile_texture(self->bottom[0], get_texture(
 				self->renderer, self->skin_id,
 				GAME_BOTTOM_DATA_ID("left")));
 	if ((self->bottom[1] = create_renderer_tile(self->renderer, base,
 						    636, 476, 4, 4, NULL)))
-		set_renderer_tile_texture(self->bottom[1], make_texture(
+		set_renderer_tile_texture(self->bottom[1], get_texture(
 				self->renderer, self->skin_id,
 				GAME_BOTTOM_DATA_ID("right")));
 	initialize_game_renderer_gauge(&self->booster, self, base,
@@ -1648,8 +1922,9 @@ static void destroy_panel(struct game_renderer *self)
 	for (i = 0; i < b6_card_of(self->jewel_info); i += 1)
 		finalize_game_renderer_info(&self->jewel_info[i]);
 	finalize_game_renderer_info(&self->diet_info);
-	finalize_toolkit_label(&self->score);
-	finalize_toolkit_label(&self->level);
+	finalize_toolkit_text(&self->score);
+	finalize_toolkit_text(&self->level);
+	finalize_toolkit_glyphs(&self->glyphs);
 	finalize_game_renderer_count(&self->lifes);
 	finalize_game_renderer_count(&self->shields);
 	destroy_renderer_tile(self->info_icon_tile);
@@ -1658,12 +1933,12 @@ static void destroy_panel(struct game_renderer *self)
 	finalize_game_renderer_gauge(&self->booster);
 	finalize_game_renderer_jewels(&self->jewels);
 	if (self->top) {
-		destroy_renderer_texture(get_renderer_tile_texture(self->top));
+		put_texture(get_renderer_tile_texture(self->top));
 		destroy_renderer_tile(self->top);
 	}
 	for (i = 0; i < b6_card_of(self->bottom); i += 1)
 		if (self->bottom[i]) {
-			destroy_renderer_texture(self->bottom[i]->texture);
+			put_texture(get_renderer_tile_texture(self->bottom[i]));
 			destroy_renderer_tile(self->bottom[i]);
 		}
 }
@@ -1724,8 +1999,8 @@ int initialize_game_renderer(struct game_renderer *self,
 		.on_render = game_renderer_on_render,
 	};
 	struct renderer_base *root = get_renderer_base(renderer);
-	struct renderer_base *playground_base, *ghost_base[4], *pacman_base,
-			     *bonus_base, *points_popup_base[9], *panel_base;
+	struct renderer_base *playground_base, *pacman_base, *bonus_base,
+			     *points_popup_base[9], *panel_base;
 	int i;
 	self->renderer = renderer;
 	self->clock = clock;
@@ -1733,10 +2008,9 @@ int initialize_game_renderer(struct game_renderer *self,
 	self->skin_id = skin_id;
 	reset_state_queue(&self->info_queue);
 	self->notified_score = 0;
+	self->gums = NULL;
 	initialize_fade_io(&self->fade_io, "game_fade_io", renderer, clock,
 			   0.f, 0.f, 2e-6f);
-	for (i = 0; i < b6_card_of(self->ghosts_state); i += 1)
-		self->ghosts_state[i] = -1;
 	setup_game_observer(&self->game_observer, &game_observer_ops);
 	setup_renderer_observer(&self->renderer_observer, "game_renderer",
 				&renderer_observer_ops);
@@ -1747,14 +2021,18 @@ int initialize_game_renderer(struct game_renderer *self,
 		return -1;
 	}
 	playground_base = get_renderer_tile_base(self->playground);
-	ghost_base[0] = create_renderer_base(
-		renderer, playground_base, "ghost_1", 0, 0);
-	ghost_base[1] = create_renderer_base(
-		renderer, playground_base, "ghost_2", 0, 0);
-	ghost_base[2] = create_renderer_base(
-		renderer, playground_base, "ghost_3", 0, 0);
-	ghost_base[3] = create_renderer_base(
-		renderer, playground_base, "ghost_4", 0, 0);
+	if (create_pacgums(self, playground_base)) {
+		finalize_fixed_font(&self->font);
+		destroy_playground(self->playground);
+		return -1;
+	}
+	if (create_ghosts(self, playground_base)) {
+		destroy_pacgums(self);
+		finalize_fixed_font(&self->font);
+		destroy_playground(self->playground);
+		return -1;
+	}
+	self->tiles = create_tiles(self);
 	bonus_base = create_renderer_base_or_die(
 		renderer, playground_base, "bonus", 0, 0);
 	pacman_base = create_renderer_base_or_die(
@@ -1762,23 +2040,19 @@ int initialize_game_renderer(struct game_renderer *self,
 	for (i = 0; i < b6_card_of(points_popup_base); i += 1)
 		points_popup_base[i] = create_renderer_base(
 			renderer, playground_base, "points", 0, 0);
-	panel_base = create_renderer_base(renderer, playground_base, "panel",
-					  0, -80);
+	panel_base = create_renderer_base(renderer, root, "panel", 0, 0);
 	create_cartoon(&self->won, renderer, skin_id,
 		       GAME_PACMAN_WINS_DATA_ID, 0);
 	create_cartoon(&self->lost, renderer, skin_id,
 		       GAME_PACMAN_LOSES_DATA_ID, 0);
-	for (i = 0; i < b6_card_of(self->ghosts); i += 1)
-		copy_cartoon(&self->lost, &self->wiped_out[i]);
+	for (i = 0; i < self->nghosts; i += 1)
+		copy_cartoon(&self->lost, &self->ghosts[i].wiped_out);
 	create_bonus(self, bonus_base);
 	create_panel(self, panel_base, lang);
 	create_pacman(self, pacman_base);
-	create_ghosts(self, ghost_base);
 	create_points_popup(self, points_popup_base);
-	self->pacgum_texture = make_texture(renderer, skin_id,
-					    GAME_PACGUM_DATA_ID);
-	self->super_pacgum_texture = make_texture(renderer, skin_id,
-						  GAME_SUPER_PACGUM_DATA_ID);
+	self->super_pacgum_texture = get_texture(renderer, skin_id,
+						 GAME_SUPER_PACGUM_DATA_ID);
 	add_game_observer(self->game, &self->game_observer);
 	add_renderer_observer(self->renderer, &self->renderer_observer);
 	return 0;
@@ -1788,8 +2062,9 @@ void finalize_game_renderer(struct game_renderer *self)
 {
 	del_renderer_observer(&self->renderer_observer);
 	del_game_observer(&self->game_observer);
-	destroy_renderer_texture(self->super_pacgum_texture);
-	destroy_renderer_texture(self->pacgum_texture);
+	put_texture(self->super_pacgum_texture);
+	destroy_renderer_texture(self->tiles);
+	destroy_pacgums(self);
 	destroy_points_popup(self);
 	destroy_ghosts(self);
 	destroy_pacman(self);
@@ -1798,6 +2073,7 @@ void finalize_game_renderer(struct game_renderer *self)
 	destroy_cartoon(&self->lost);
 	destroy_cartoon(&self->won);
 	destroy_playground(self->playground);
+	b6_deallocate(&b6_std_allocator, self->gums);
 	finalize_fade_io(&self->fade_io);
 	finalize_fixed_font(&self->font);
 }
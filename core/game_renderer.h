@@ -65,6 +65,12 @@ struct game_renderer_sprite {
 	struct renderer_tile *tile;
 };
 
+struct game_renderer_ghost {
+	struct game_renderer_sprite sprite;
+	struct cartoon wiped_out;
+	int state;
+};
+
 struct game_renderer_info {
 	struct state up;
 	struct game_renderer *game_renderer;
@@ -109,10 +115,19 @@ struct game_renderer {
 	const char *skin_id;
 	struct game_event hold;
 
-	struct renderer_texture *pacgum_texture;
+	struct rgba pacgum_rgba;
 	struct renderer_texture *super_pacgum_texture;
 
 	struct renderer_tile *playground;
+	/* maze tiles side by side, when the renderer can compose the
+	 * playground out of them, NULL otherwise
+	 */
+	struct renderer_texture *tiles;
+	/* all regular pac-gums are drawn as a single level-sized layer */
+	struct renderer_tile *pacgums;
+	struct rgba pacgums_rgba;
+	int pacgums_dirty; /* the whole layer needs to be uploaded */
+	unsigned short int pacgums_x1, pacgums_y1, pacgums_x2, pacgums_y2;
 
 	struct cartoon pacman_cartoons[2][4];
 	enum direction pacman_direction;
@@ -123,9 +138,8 @@ struct game_renderer {
 	struct cartoon afraid;
 	struct cartoon locked;
 	struct cartoon zombie;
-	struct cartoon wiped_out[4];
-	struct game_renderer_sprite ghosts[4];
-	int ghosts_state[4];
+	struct game_renderer_ghost *ghosts;
+	unsigned int nghosts;
 	short int afraid_state;
 	short int locked_state;
 
@@ -143,14 +157,14 @@ struct game_renderer {
 	unsigned int notified_score;
 	struct renderer_tile *top;
 	struct renderer_tile *bottom[2];
-	struct toolkit_label score;
-	struct toolkit_label level;
+	struct toolkit_glyphs glyphs;
+	struct toolkit_text score;
+	struct toolkit_text level;
 	struct game_renderer_count lifes;
 	struct game_renderer_count shields;
 	struct game_renderer_jewels jewels;
 	struct game_renderer_gauge booster;
-	struct toolkit_image gums[LEVEL_WIDTH][LEVEL_HEIGHT];
-	struct toolkit_image *pacgums;
+	struct toolkit_image *gums; /* one per level place */
 	struct toolkit_image *super_pacgums;
 	struct game_renderer_casino casino;
 	struct game_renderer_popup points[9];
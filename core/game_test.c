@@ -0,0 +1,166 @@
+/*
+ * Open Greedy - an open-source version of Edromel Studio's Greedy XP
+ *
+ * Copyright (C) 2014-2017 Arnaud TROEL
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "game.h"
+#include "level.h"
+#include "maze.h"
+
+#include "lib/init.h"
+#include "lib/rng.h"
+#include "b6/clock.h"
+#include "b6/extra/test.h"
+#include "b6/cmdline.h"
+
+#define STEP_US 10000ULL
+
+/* Mazes, with or without their ghosts den. */
+struct test_layout_provider {
+	struct layout_provider up;
+	int den;
+};
+
+static int get_test_layout(struct layout_provider *up, unsigned int n,
+			   struct layout *layout)
+{
+	struct test_layout_provider *self =
+		b6_cast_of(up, struct test_layout_provider, up);
+	int x, y, retval = generate_maze_layout(layout, n, 20, 17);
+	if (retval || self->den)
+		return retval;
+	for (x = 0; x < layout->width + 2; x += 1)
+		for (y = 0; y < layout->height + 2; y += 1)
+			if (*__get_layout(layout, x, y) == LAYOUT_GHOSTS)
+				*__get_layout(layout, x, y) = LAYOUT_EMPTY;
+	return 0;
+}
+
+struct test_game {
+	struct b6_clock clock;
+	unsigned long long int time;
+	struct game game;
+};
+
+static unsigned long long int get_test_clock_time(const struct b6_clock *up)
+{
+	return b6_cast_of(up, struct test_game, clock)->time;
+}
+
+static void start_test_game(struct test_game *self,
+			    struct test_layout_provider *layouts,
+			    unsigned int seed)
+{
+	static const struct b6_clock_ops ops = {
+		.get_time = get_test_clock_time,
+	};
+	self->clock.ops = &ops;
+	self->time = 0;
+	reset_random_number_generator(seed);
+	b6_check(!initialize_game(&self->game, &self->clock,
+				  get_default_game_config(), &layouts->up, 0));
+}
+
+/* pacman changes direction every half second until the game is over */
+static void run_test_game(struct test_game *self, unsigned long int ticks)
+{
+	unsigned long int i;
+	for (i = 0; i < ticks && play_game(&self->game); i += 1) {
+		if (!(i % 50))
+			submit_pacman_move(&self->game, (i / 50) % 4);
+		update_game(&self->game);
+		self->time += STEP_US;
+	}
+}
+
+static unsigned char *save_test_game(struct test_game *self)
+{
+	unsigned long int len = get_game_state_size(&self->game);
+	unsigned char *buf = malloc(len);
+	b6_check(buf);
+	b6_expect(!save_game_state(&self->game, buf, len));
+	return buf;
+}
+
+/* Restoring a snapshot and saving it again gives back the same bytes, and two
+ * games restored from the same snapshot stay identical.
+ */
+static void check_game_state(int den)
+{
+	static const struct layout_provider_ops ops = {
+		.get = get_test_layout,
+	};
+	static struct test_game a, b;
+	struct test_layout_provider layouts;
+	unsigned char *blob, *copy, *after_a, *after_b;
+	unsigned long int len;
+	reset_layout_provider(&layouts.up, &ops, "test",
+			      LAYOUT_PROVIDER_UNBOUNDED);
+	layouts.den = den;
+	start_test_game(&a, &layouts, 1);
+	run_test_game(&a, 300);
+	b6_expect(!a.game.level.ghosts_home == !den);
+	blob = save_test_game(&a);
+	len = get_game_state_size(&a.game);
+	start_test_game(&b, &layouts, 2);
+	run_test_game(&b, 100);
+	b6_expect(b.game.curr_ops == a.game.curr_ops);
+	b6_expect(get_game_state_size(&b.game) == len);
+	b6_expect(!restore_game_state(&b.game, blob, len));
+	copy = save_test_game(&b);
+	b6_expect(!memcmp(blob, copy, len));
+	b6_expect(!restore_game_state(&a.game, blob, len));
+	run_test_game(&a, 1000);
+	after_a = save_test_game(&a);
+	b6_expect(!restore_game_state(&b.game, blob, len));
+	run_test_game(&b, 1000);
+	after_b = save_test_game(&b);
+	b6_expect(get_game_state_size(&a.game) ==
+		  get_game_state_size(&b.game));
+	b6_expect(!memcmp(after_a, after_b, get_game_state_size(&a.game)));
+	free(after_b);
+	free(after_a);
+	free(copy);
+	free(blob);
+	finalize_game(&b.game);
+	finalize_game(&a.game);
+}
+
+static void with_den()
+{
+	check_game_state(1);
+}
+b6_test(with_den);
+
+static void without_den()
+{
+	check_game_state(0);
+}
+b6_test(without_den);
+
+int main(int argc, char *argv[])
+{
+	int retval;
+	b6_flag_parse_command_line(argc, argv, 1);
+	init_all();
+	retval = b6_test_run_all(argv[0]);
+	exit_all();
+	return retval;
+}
@@ -90,7 +90,8 @@ static void run_ghost_strategy(struct ghost_strategy *self, struct ghost *ghost)
 
 struct janitor_strategy {
 	struct ghost_strategy strategy;
-	float count[LEVEL_WIDTH][LEVEL_HEIGHT];
+	float *count;
+	unsigned int size;
 };
 
 static float evaluate_janitor(struct ghost_strategy *strategy,
@@ -99,9 +100,7 @@ static float evaluate_janitor(struct ghost_strategy *strategy,
 	struct janitor_strategy *self =
 		b6_cast_of(strategy, struct janitor_strategy, strategy);
 	struct mobile *mobile = &ghost->mobile;
-	int x, y;
-	place_location(mobile->level, place, &x, &y);
-	return 1 / self->count[x][y];
+	return 1 / self->count[place - mobile->level->places];
 }
 
 static void feedback_janitor(struct ghost_strategy *strategy,
@@ -111,9 +110,7 @@ static void feedback_janitor(struct ghost_strategy *strategy,
 		b6_cast_of(strategy, struct janitor_strategy, strategy);
 	struct mobile *mobile = &ghost->mobile;
 	struct level *level = mobile->level;
-	int x, y;
-	place_location(level, place_neighbor(level, mobile->curr, d), &x, &y);
-	self->count[x][y] += 1;
+	self->count[place_neighbor(level, mobile->curr, d) - level->places] += 1;
 }
 
 static void initialize_janitor_strategy(struct janitor_strategy *self,
@@ -123,18 +120,36 @@ static void initialize_janitor_strategy(struct janitor_strategy *self,
 		.evaluate = evaluate_janitor,
 		.feedback = feedback_janitor,
 	};
-	int x, y;
-	for (y = 0; y < LEVEL_HEIGHT; y++) for (x = 0; x < LEVEL_WIDTH; x++)
-		self->count[x][y] = 1;
+	unsigned int i, size = get_level_size(&game->level);
+	if (self->size < size) {
+		b6_deallocate(&b6_std_allocator, self->count);
+		self->count = b6_allocate(&b6_std_allocator,
+					  size * sizeof(*self->count));
+		if (!self->count)
+			log_p(_s("out of memory"));
+		self->size = size;
+	}
+	for (i = 0; i < size; i += 1)
+		self->count[i] = 1;
 	setup_ghost_strategy(&self->strategy, &ops, game);
 }
 
+static void finalize_janitor_strategy(struct janitor_strategy *self)
+{
+	b6_deallocate(&b6_std_allocator, self->count);
+	self->count = NULL;
+	self->size = 0;
+}
+
 struct astar_node {
-	unsigned short int f;
-	unsigned short int g;
-	unsigned short int r;
+	unsigned int f;
+	unsigned int g;
+	unsigned int r;
 };
 
+#define ASTAR_NODE_CLOSED 0xfffffffe
+#define ASTAR_NODE_UNSEEN 0xffffffff
+
 static unsigned int get_manhattan_distance(int x1, int y1, int x2, int y2)
 {
 	return (x2 >= x1 ? x2 - x1 : x1 - x2) + (y2 >= y1 ? y2 - y1 : y1 - y2);
@@ -142,16 +157,16 @@ static unsigned int get_manhattan_distance(int x1, int y1, int x2, int y2)
 
 static void reset_astar_node(struct astar_node *n)
 {
-	n->r = 0xffff;
+	n->r = ASTAR_NODE_UNSEEN;
 }
 
 static int astar_node_is_open(const struct astar_node *n)
 {
-	return n->r < 0xfffe;
+	return n->r < ASTAR_NODE_CLOSED;
 }
 
-static void open_astar_node(struct astar_node *node, unsigned short int g,
-			    unsigned short int f)
+static void open_astar_node(struct astar_node *node, unsigned int g,
+			    unsigned int f)
 {
 	node->g = g;
 	node->f = g + f;
@@ -159,12 +174,12 @@ static void open_astar_node(struct astar_node *node, unsigned short int g,
 
 static void close_astar_node(struct astar_node *n)
 {
-	n->r = 0xfffe;
+	n->r = ASTAR_NODE_CLOSED;
 }
 
 static int astar_node_is_closed(const struct astar_node *n)
 {
-	return n->r == 0xfffe;
+	return n->r == ASTAR_NODE_CLOSED;
 }
 
 static int astar_node_compare(void *lptr, void *rptr)
@@ -201,19 +216,45 @@ static unsigned int get_shortest_distance(const struct level *level,
 }
 
 struct astar {
-	struct astar_node nodes[b6_card_of(((struct level*)NULL)->places)];
+	struct astar_node *nodes;
+	unsigned int nnodes;
 	struct b6_array array;
 	struct b6_heap queue;
 };
 
-void initialize_astar(struct astar *self)
+/* Nodes are kept from one search to the other as there is one per place. */
+static struct astar_node *astar_nodes;
+static unsigned int astar_capacity;
+
+static void reserve_astar_nodes(unsigned int size)
+{
+	if (astar_capacity >= size)
+		return;
+	b6_deallocate(&b6_std_allocator, astar_nodes);
+	astar_nodes = b6_allocate(&b6_std_allocator, size * sizeof(*astar_nodes));
+	if (!astar_nodes)
+		log_p(_s("out of memory"));
+	astar_capacity = size;
+}
+
+static void release_astar_nodes(void)
+{
+	b6_deallocate(&b6_std_allocator, astar_nodes);
+	astar_nodes = NULL;
+	astar_capacity = 0;
+}
+
+void initialize_astar(struct astar *self, const struct level *level)
 {
 	int i;
 	b6_array_initialize(&self->array, &b6_std_allocator,
 			    sizeof(struct astar_node*));
 	b6_heap_reset(&self->queue, &self->array, astar_node_compare,
 		      astar_node_set_index);
-	for (i = 0; i < b6_card_of(self->nodes); i += 1)
+	self->nodes = astar_nodes;
+	self->nnodes = get_level_size(level);
+	b6_check(self->nnodes <= astar_capacity);
+	for (i = 0; i < self->nnodes; i += 1)
 		reset_astar_node(&self->nodes[i]);
 }
 
@@ -225,14 +266,14 @@ void finalize_astar(struct astar *self)
 static int is_legal_astar_node(const struct astar *self,
 			       const struct astar_node *node)
 {
-	return node >= self->nodes &&
-		node < self->nodes + b6_card_of(self->nodes);
+	return node >= self->nodes && node < self->nodes + self->nnodes;
 }
 
 static struct astar_node *coords_to_astar_node(const struct astar *self,
+					       const struct level *level,
 					       int x, int y)
 {
-	const struct astar_node *node = &self->nodes[x + y * LEVEL_WIDTH];
+	const struct astar_node *node = &self->nodes[x + y * level->width];
 	if (b6_unlikely(!is_legal_astar_node(self, node)))
 		return NULL;
 	return (struct astar_node*)node;
@@ -243,8 +284,7 @@ static struct place *astar_node_to_place(const struct astar *self,
 					 struct level *level)
 {
 	struct place *place = &level->places[node - self->nodes];
-	if (b6_unlikely(place < level->places ||
-			place >= level->places + b6_card_of(level->places))) {
+	if (b6_unlikely(!is_place(level, place))) {
 		log_e(_s("cannot convert astar node to level place"));
 		return NULL;
 	}
@@ -294,12 +334,13 @@ static int get_astar_distance(struct level *level, const struct items *items,
 {
 	struct astar astar;
 	struct astar_node *goal, *curr;
-	initialize_astar(&astar);
-	if (b6_unlikely(!(goal = coords_to_astar_node(&astar, xd, yd)))) {
+	initialize_astar(&astar, level);
+	if (b6_unlikely(!(goal = coords_to_astar_node(&astar, level, xd, yd)))) {
 		log_e(_s("illegal astar target"));
 		return -1;
 	}
-	if (b6_unlikely(!(curr = coords_to_astar_node(&astar, xs, ys)))) {
+	if (b6_unlikely(!(curr = coords_to_astar_node(&astar, level,
+							 xs, ys)))) {
 		log_e(_s("illegal astar source"));
 		return -1;
 	}
@@ -308,7 +349,7 @@ static int get_astar_distance(struct level *level, const struct items *items,
 		return -1;
 	for (;;) {
 		struct place *place;
-		unsigned short int f, g;
+		unsigned int f, g;
 		enum direction d;
 		curr = pop_astar_node(&astar);
 		if (b6_unlikely(curr))
@@ -329,7 +370,7 @@ static int get_astar_distance(struct level *level, const struct items *items,
 			if (is_teleport(items, n->item))
 				n = get_teleport_destination(n->item);
 			place_location(level, n, &x, &y);
-			node = coords_to_astar_node(&astar, x, y);
+			node = coords_to_astar_node(&astar, level, x, y);
 			if (astar_node_is_closed(node) && g >= node->g)
 				continue;
 			if (!astar_node_is_open(node)) {
@@ -393,7 +434,7 @@ static float get_astar_score(struct ghost_strategy *self, struct ghost *ghost,
 	place_location(level, place, &xs, &ys);
 	place_location(level, self->game->pacman.mobile.curr, &xd, &yd);
 	d = get_astar_distance(level, self->game->level.items, xs, ys, xd, yd);
-	return d < 0 ? d : 1 - (1 + d) / LEVEL_WIDTH / LEVEL_HEIGHT;
+	return d < 0 ? d : 1 - (1 + d) / get_level_size(level);
 }
 
 static float get_zombie_score(struct ghost_strategy *self, struct ghost *ghost,
@@ -409,7 +450,7 @@ static float get_zombie_score(struct ghost_strategy *self, struct ghost *ghost,
 	place_location(level, place, &xs, &ys);
 	place_location(level, level->ghosts_home, &xd, &yd);
 	d = get_astar_distance(level, self->game->level.items, xs, ys, xd, yd);
-	return d < 0 ? d : 1 - (1 + d) / LEVEL_WIDTH / LEVEL_HEIGHT;
+	return d < 0 ? d : 1 - (1 + d) / get_level_size(level);
 }
 
 struct rogue_strategy {
@@ -512,6 +553,7 @@ void initialize_ghost_strategies(struct game *game)
 	static const struct ghost_strategy_ops fallback_ops = {
 		.evaluate = get_fallback_score,
 	};
+	reserve_astar_nodes(get_level_size(&game->level));
 	setup_ghost_strategy(&zombie_ghost_strategy, &zombie_ops, game);
 	initialize_janitor_strategy(&janitor_strategy, game);
 	setup_ghost_strategy(&fallback_ghost_strategy, &fallback_ops, game);
@@ -522,6 +564,53 @@ void initialize_ghost_strategies(struct game *game)
 	setup_afraid_strategy(&afraid_ghost_strategy, game);
 }
 
+void finalize_ghost_strategies(void)
+{
+	finalize_janitor_strategy(&janitor_strategy);
+	release_astar_nodes();
+}
+
+static struct ghost_strategy *const ghost_strategies[] = {
+	&no_ghost_strategy,
+	&janitor_strategy.strategy,
+	&doggy_ghost_strategy,
+	&astar_ghost_strategy,
+	&zombie_ghost_strategy,
+	&afraid_ghost_strategy.up,
+	&rogue_ghost_strategy.up,
+	&fallback_ghost_strategy,
+};
+
+unsigned int get_ghost_strategy_index(const struct ghost *self)
+{
+	unsigned int i;
+	for (i = 0; i < b6_card_of(ghost_strategies); i += 1)
+		if (ghost_strategies[i] == self->current_strategy)
+			break;
+	return i;
+}
+
+int set_ghost_strategy_index(struct ghost *self, unsigned int index)
+{
+	if (index > b6_card_of(ghost_strategies))
+		return -1;
+	self->current_strategy = index < b6_card_of(ghost_strategies) ?
+		ghost_strategies[index] : NULL;
+	return 0;
+}
+
+unsigned long int get_janitor_visits(unsigned int index)
+{
+	b6_check(index < janitor_strategy.size);
+	return janitor_strategy.count[index];
+}
+
+void set_janitor_visits(unsigned int index, unsigned long int visits)
+{
+	b6_check(index < janitor_strategy.size);
+	janitor_strategy.count[index] = visits;
+}
+
 static void ghost_enter(struct mobile *mobile)
 {
 	struct ghost *self = b6_cast_of(mobile, struct ghost, mobile);
@@ -39,6 +39,8 @@ struct ghost {
 	enum ghost_state state;
 	struct ghost_strategy *current_strategy;
 	struct ghost_strategy *default_strategy;
+	struct b6_dref cell_dref; /* in the list of the cell it is in */
+	unsigned int cell;
 };
 
 extern void initialize_ghost(struct ghost *self, int n, float speed,
@@ -65,4 +67,17 @@ static inline int ghost_is_alive(const struct ghost *ghost)
 
 extern void initialize_ghost_strategies(struct game *game);
 
+extern void finalize_ghost_strategies(void);
+
+extern unsigned int get_ghost_strategy_index(const struct ghost *self);
+
+extern int set_ghost_strategy_index(struct ghost *self, unsigned int index);
+
+/* Visits of the janitor strategy to the place at index, which all ghosts
+ * share.
+ */
+extern unsigned long int get_janitor_visits(unsigned int index);
+
+extern void set_janitor_visits(unsigned int index, unsigned long int visits);
+
 #endif /* GHOSTS_H */
@@ -34,6 +34,7 @@
 #include "lib/init.h"
 #include "mixer.h"
 #include "renderer.h"
+#include "texture_cache.h"
 #include "toolkit.h"
 
 static const char *hof_skin = NULL;
@@ -123,8 +124,9 @@ static void on_key_pressed(struct controller_observer *observer,
 	if (b6_utf8_is_empty(&self->name.utf8))
 		return;
 	b6_assert(self->cursor_base);
-	move_renderer_base(self->cursor_base, self->cursor_base->x - 16,
-			   self->cursor_base->y);
+	move_renderer_base(self->cursor_base,
+			   get_renderer_base_x(self->cursor_base) - 16,
+			   get_renderer_base_y(self->cursor_base));
 	self->name.utf8.nchars -= 1; // FIXME: add crop API
 	self->name.utf8.nbytes -= 1; // FIXME: add crop API
 	alter_hall_of_fame_entry(self->entry, &self->name.utf8);
@@ -151,7 +153,8 @@ static void on_text_input(struct controller_observer *observer,
 	b6_append_utf8_string(&self->name, unicode);
 	b6_assert(self->cursor_base);
 	move_renderer_base(self->cursor_base,
-			   self->cursor_base->x + 16, self->cursor_base->y);
+			   get_renderer_base_x(self->cursor_base) + 16,
+			   get_renderer_base_y(self->cursor_base));
 	alter_hall_of_fame_entry(self->entry, &self->name.utf8);
 	setup_label(self, self->rank, self->entry);
 }
@@ -222,11 +225,11 @@ static int hall_of_fame_phase_init(struct phase *up, const struct phase *prev)
 
 	if ((self->background = create_renderer_tile(renderer, root, 0, 0,
 						     640, 480, NULL)))
-		set_renderer_tile_texture(self->background, make_texture(
+		set_renderer_tile_texture(self->background, get_texture(
 				renderer, skin_id, HOF_BACKGROUND_DATA_ID));
 	if ((self->panel = create_renderer_tile(renderer, root, 0, 0, 112, 480,
 						NULL)))
-		set_renderer_tile_texture(self->panel, make_texture(
+		set_renderer_tile_texture(self->panel, get_texture(
 				renderer, skin_id, HOF_PANEL_DATA_ID));
 	for (i = 0; i < b6_card_of(self->label); i += 1) {
 		const unsigned short int u = 2 + 32 * font_w, v = 2 + font_h;
@@ -249,9 +252,11 @@ static int hall_of_fame_phase_init(struct phase *up, const struct phase *prev)
 	for (; i < b6_card_of(self->label); i += 1)
 		hide_toolkit_label(&self->label[i]);
 	if (self->entry) {
-		float x = self->label[self->rank].image[0].tile->x +
+		const struct renderer_tile *tile =
+			self->label[self->rank].image[0].tile;
+		float x = get_renderer_tile_x(tile) +
 			(16 + self->name.utf8.nchars) * 16;
-		float y = self->label[self->rank].image[0].tile->y;
+		float y = get_renderer_tile_y(tile);
 		self->cursor_base = create_renderer_base_or_die(renderer, root,
 								"cursor", x, y);
 		initialize_toolkit_label(&self->cursor_label, renderer,
@@ -314,11 +319,11 @@ static void hall_of_fame_phase_exit(struct phase *up)
 	for (i = 0; i < b6_card_of(self->label); i += 1)
 		finalize_toolkit_label(&self->label[i]);
 	if (self->panel) {
-		destroy_renderer_texture(self->panel->texture);
+		put_texture(get_renderer_tile_texture(self->panel));
 		destroy_renderer_tile(self->panel);
 	}
 	if (self->background) {
-		destroy_renderer_texture(self->background->texture);
+		put_texture(get_renderer_tile_texture(self->background));
 		destroy_renderer_tile(self->background);
 	}
 	finalize_fixed_font(&self->font);
@@ -20,6 +20,7 @@
 #include "level.h"
 
 #include <b6/cmdline.h>
+#include <string.h>
 
 #include "lib/rng.h"
 #include "lib/std.h"
@@ -52,18 +53,20 @@ static char layout_to_char(int code)
 int print_layout(const struct layout *layout, struct ostream *ostream)
 {
 	int x, y;
-	char ascii[LEVEL_WIDTH + 3];
+	char ascii[LEVEL_MAX_WIDTH + 3];
+	unsigned int len = layout->width + 3;
 	long long int wsize;
-	ascii[LEVEL_WIDTH + 2] = '\n';
-	for (y = 0; y < LEVEL_HEIGHT + 2; y += 1) {
-		for (x = 0; x < LEVEL_WIDTH + 2; x += 1)
-			ascii[x] = layout_to_char(layout->data[x][y]);
-		wsize = write_ostream(ostream, ascii, sizeof(ascii));
+	ascii[len - 1] = '\n';
+	for (y = 0; y < layout->height + 2; y += 1) {
+		for (x = 0; x < layout->width + 2; x += 1)
+			ascii[x] = layout_to_char(get_layout(layout, x - 1,
+							     y - 1));
+		wsize = write_ostream(ostream, ascii, len);
 		if (wsize < 0) {
 			logf_e("i/o error #%d", (int)wsize);
 			return -1;
 		}
-		if (wsize < sizeof(ascii)) {
+		if (wsize < len) {
 			log_e(_s("truncated file"));
 			return -1;
 		}
@@ -71,23 +74,93 @@ int print_layout(const struct layout *layout, struct ostream *ostream)
 	return 0;
 }
 
+unsigned int get_layout_tile(const struct layout *l,
+			     unsigned short int x, unsigned short int y)
+{
+	static unsigned int map[] = {
+		 4, 23,  7,  2, 31,  1,  0, 11, 15, 18,  8, 20, 16, 19, 12,  3,
+		 4, 23,  7,  2, 31,  1,  0, 11, 15, 42,  8,  5, 16, 46, 12, 36,
+		 4, 23,  7, 26, 31,  1,  0, 44, 15, 18,  8, 13, 16, 19, 12, 28,
+		 4, 23,  7, 26, 31,  1,  0, 44, 15, 42,  8, 34, 16, 46, 12, 22,
+		 4, 23,  7,  2, 31,  1, 24, 45, 15, 18,  8, 20, 16, 19, 14, 27,
+		 4, 23,  7,  2, 31,  1, 24, 45, 15, 42,  8,  5, 16, 46, 14, 37,
+		 4, 23,  7, 26, 31,  1, 24, 25, 15, 18,  8, 13, 16, 19, 14, 30,
+		 4, 23,  7, 26, 31,  1, 24, 25, 15, 42,  8, 34, 16, 46, 14, 47,
+		 4, 23,  7,  2, 31,  1,  0, 11, 15, 18,  8, 20, 40, 38,  6, 35,
+		 4, 23,  7,  2, 31,  1,  0, 11, 15, 42,  8,  5, 40, 41,  6, 43,
+		 4, 23,  7, 26, 31,  1,  0, 44, 15, 18,  8, 13, 40, 38,  6, 29,
+		 4, 23,  7, 26, 31,  1,  0, 44, 15, 42,  8, 34, 40, 41,  6, 39,
+		 4, 23,  7,  2, 31,  1, 24, 45, 15, 18,  8, 20, 40, 38, 32, 21,
+		 4, 23,  7,  2, 31,  1, 24, 45, 15, 42,  8,  5, 40, 41, 32, 17,
+		 4, 23,  7, 26, 31,  1, 24, 25, 15, 18,  8, 13, 40, 38, 32, 10,
+		 4, 23,  7, 26, 31,  1, 24, 25, 15, 42,  8, 34, 40, 41, 32, 33
+	};
+	if (x > l->width || y > l->height)
+		return 33;
+	if (get_layout(l, x, y) == LAYOUT_WALL) {
+		unsigned int code = 0;
+		if (get_layout(l, x    , y - 1) == LAYOUT_WALL) code |= 1 << 0;
+		if (get_layout(l, x + 1, y    ) == LAYOUT_WALL) code |= 1 << 1;
+		if (get_layout(l, x    , y + 1) == LAYOUT_WALL) code |= 1 << 2;
+		if (get_layout(l, x - 1, y    ) == LAYOUT_WALL) code |= 1 << 3;
+		if (get_layout(l, x - 1, y - 1) == LAYOUT_WALL) code |= 1 << 4;
+		if (get_layout(l, x + 1, y - 1) == LAYOUT_WALL) code |= 1 << 5;
+		if (get_layout(l, x + 1, y + 1) == LAYOUT_WALL) code |= 1 << 6;
+		if (get_layout(l, x - 1, y + 1) == LAYOUT_WALL) code |= 1 << 7;
+		return map[code];
+	}
+	return 9;
+}
+
+static unsigned int get_layout_data_size(const struct layout *layout)
+{
+	return (layout->width + 2) * (layout->height + 2);
+}
+
+/* Layouts of the classic size are serialized as their raw data, which always
+ * starts with a wall. Other sizes are preceded by a header giving them.
+ */
+#define LAYOUT_MAGIC 'L'
+
 int serialize_layout(const struct layout *l, struct ostream *s)
 {
-	if (write_ostream(s, l->data, sizeof(l->data)) < sizeof(l->data))
+	unsigned int size = get_layout_data_size(l);
+	if (l->width != LEVEL_WIDTH || l->height != LEVEL_HEIGHT) {
+		unsigned char header[] = {
+			LAYOUT_MAGIC, l->width - 1, l->height - 1,
+		};
+		if (write_ostream(s, header, sizeof(header)) < sizeof(header))
+			return -1;
+	}
+	if (write_ostream(s, l->data, size) < size)
 		return -1;
 	return 0;
 }
 
 static void frame_layout(struct layout *layout) {
 	int x, y;
-	for (x = 0; x < LEVEL_WIDTH + 2; x += 1) {
-		layout->data[x][0] = LAYOUT_WALL;
-		layout->data[x][LEVEL_HEIGHT + 1] = LAYOUT_WALL;
+	for (x = 0; x < layout->width + 2; x += 1) {
+		*__get_layout(layout, x, 0) = LAYOUT_WALL;
+		*__get_layout(layout, x, layout->height + 1) = LAYOUT_WALL;
+	}
+	for (y = 1; y < layout->height + 1; y += 1) {
+		*__get_layout(layout, layout->width + 1, y) = LAYOUT_WALL;
+		*__get_layout(layout, 0, y) = LAYOUT_WALL;
 	}
-	for (y = 1; y < LEVEL_HEIGHT + 1; y += 1) {
-		layout->data[LEVEL_WIDTH + 1][y] = LAYOUT_WALL;
-		layout->data[0][y] = LAYOUT_WALL;
+}
+
+int reset_layout(struct layout *layout, unsigned short int width,
+		 unsigned short int height)
+{
+	if (!width || width > LEVEL_MAX_WIDTH ||
+	    !height || height > LEVEL_MAX_HEIGHT) {
+		logf_e("unsupported layout size %ux%u", width, height);
+		return -1;
 	}
+	layout->width = width;
+	layout->height = height;
+	memset(layout->data, LAYOUT_WALL, get_layout_data_size(layout));
+	return 0;
 }
 
 static unsigned char char_to_layout(char c)
@@ -107,48 +180,119 @@ static unsigned char char_to_layout(char c)
 	}
 }
 
+/* The size of the layout is that of the text: the first line gives the count of
+ * columns, shorter lines are padded with walls and longer ones are truncated.
+ * An empty line ends the layout: only empty lines may follow.
+ */
 int parse_layout(struct layout *layout, struct istream *istream)
 {
-	int x, y;
-	char ascii[LEVEL_WIDTH + 2];
+	static const unsigned int max_len = LEVEL_MAX_WIDTH + 2;
+	unsigned char *rows;
+	unsigned int len = 0, x, y;
 	long long int rsize;
-	for (y = 0; y < LEVEL_HEIGHT + 2; y += 1) {
-		rsize = read_istream(istream, ascii, sizeof(ascii));
-		if (rsize < 0) {
-			logf_e("i/o error #%d", (int)rsize);
-			return -1;
+	char c;
+	int ended = 0, retval = -1;
+	if (!(rows = b6_allocate(&b6_std_allocator,
+				 max_len * (LEVEL_MAX_HEIGHT + 2)))) {
+		log_e(_s("out of memory"));
+		return -1;
+	}
+	for (x = y = 0; (rsize = read_istream(istream, &c, 1)) > 0;) {
+		if (c == '\r')
+			continue;
+		if (c != '\n') {
+			if (ended) {
+				log_e(_s("layout row after an empty line"));
+				goto bail_out;
+			}
+			if (!y && x >= max_len) {
+				log_e(_s("layout is too wide"));
+				goto bail_out;
+			}
+			if (y >= LEVEL_MAX_HEIGHT + 2) {
+				log_e(_s("layout is too high"));
+				goto bail_out;
+			}
+			if (x < (y ? len : max_len))
+				rows[y * max_len + x] = char_to_layout(c);
+			x += 1;
+			continue;
 		}
-		if (rsize < sizeof(ascii)) {
-			log_e(_s("truncated stream"));
-			return -1;
+		if (!x) {
+			ended = 1;
+			continue;
 		}
-		for (x = 0; x < b6_card_of(ascii); x += 1)
-			layout->data[x][y] = char_to_layout(ascii[x]);
-		do
-			rsize = read_istream(istream, ascii, 1);
-		while (rsize > 0 && *ascii != '\n');
+		if (!y)
+			len = x;
+		for (; x < len; x += 1)
+			rows[y * max_len + x] = LAYOUT_WALL;
+		y += 1;
+		x = 0;
+	}
+	if (rsize < 0) {
+		logf_e("i/o error #%d", (int)rsize);
+		goto bail_out;
 	}
+	if (x) {
+		if (!y)
+			len = x;
+		for (; x < len; x += 1)
+			rows[y * max_len + x] = LAYOUT_WALL;
+		y += 1;
+	}
+	if (len < 3 || y < 3) {
+		log_e(_s("truncated stream"));
+		goto bail_out;
+	}
+	if (reset_layout(layout, len - 2, y - 2))
+		goto bail_out;
+	for (y = 0; y < layout->height + 2; y += 1)
+		for (x = 0; x < len; x += 1)
+			*__get_layout(layout, x, y) = rows[y * max_len + x];
 	frame_layout(layout);
-	return 0;
+	retval = 0;
+bail_out:
+	b6_deallocate(&b6_std_allocator, rows);
+	return retval;
 }
 
 int unserialize_layout(struct layout *l, struct istream *s)
 {
-	if (read_istream(s, l->data, sizeof(l->data)) < sizeof(l->data))
+	unsigned char header[3];
+	unsigned int size;
+	if (read_istream(s, header, 1) < 1)
 		return -1;
+	if (header[0] == LAYOUT_WALL) {
+		if (reset_layout(l, LEVEL_WIDTH, LEVEL_HEIGHT))
+			return -1;
+		size = get_layout_data_size(l) - 1;
+		if (read_istream(s, l->data + 1, size) < size)
+			return -1;
+	} else if (header[0] == LAYOUT_MAGIC) {
+		if (read_istream(s, header + 1, 2) < 2)
+			return -1;
+		if (reset_layout(l, header[1] + 1, header[2] + 1))
+			return -1;
+		size = get_layout_data_size(l);
+		if (read_istream(s, l->data, size) < size)
+			return -1;
+	} else {
+		log_e(_s("unknown layout format"));
+		return -1;
+	}
 	frame_layout(l);
 	return 0;
 }
 
 static struct place *__get_place(struct level *l, int x, int y)
 {
-	return &l->places[y * LEVEL_WIDTH + x];
+	return &l->places[y * l->width + x];
 }
 
 static struct place *get_place(struct level *l, int x, int y)
 {
 	struct place *place;
-	if (y < 0 || x < 0 || y > LEVEL_HEIGHT || x > LEVEL_WIDTH)
+	if (y < 0 || x < 0 || y > l->height || x > l->width)
 		return NULL;
 	place = __get_place(l, x, y);
 	if (!place->item)
@@ -247,14 +391,17 @@ static void mark_level_as_closed(struct level *self)
 	self->ghosts_home = NULL;
 	self->bonus_place = NULL;
 	self->nplaces = 0;
+	self->places = NULL;
+	self->width = self->height = 0;
 }
 
 void __close_level(struct level *self)
 {
 	int i;
-	for (i = 0; i < b6_card_of(self->places); i += 1)
+	for (i = 0; i < get_level_size(self); i += 1)
 		if (self->places[i].item)
 			dispose_item(self->places[i].item);
+	b6_deallocate(&b6_std_allocator, self->places);
 	mark_level_as_closed(self);
 }
 
@@ -263,7 +410,7 @@ static void recover_ghosts_den(struct level *self, struct layout *layout)
 	int xs, ys, xd, yd;
 	struct level_iterator iter;
 	struct place *closest_place = NULL;
-	unsigned int distance, min_distance = LEVEL_WIDTH + LEVEL_HEIGHT;
+	unsigned int distance, min_distance = self->width + self->height;
 	if (!self->ghosts_home)
 		return;
 	place_location(self, self->ghosts_home, &xs, &ys);
@@ -307,7 +454,15 @@ static void recover_ghosts_den(struct level *self, struct layout *layout)
 int __open_level(struct level *self, struct layout *layout)
 {
 	int i;
-	for (i = 0; i < b6_card_of(self->places); i += 1) {
+	self->places = b6_allocate(&b6_std_allocator, layout->width *
+				   layout->height * sizeof(*self->places));
+	if (!self->places) {
+		log_e(_s("out of memory"));
+		return -1;
+	}
+	self->width = layout->width;
+	self->height = layout->height;
+	for (i = 0; i < get_level_size(self); i += 1) {
 		struct place *place = &self->places[i];
 		initialize_place(self, layout, place);
 		self->nplaces += !!place->item;
@@ -389,9 +544,9 @@ static int data_layout_provider_get(struct layout_provider *up, unsigned int n,
 	return retval;
 }
 
-static void reset_layout_provider(struct layout_provider *self,
-				  const struct layout_provider_ops *ops,
-				  const char *id, unsigned int size)
+void reset_layout_provider(struct layout_provider *self,
+			   const struct layout_provider_ops *ops,
+			   const char *id, unsigned int size)
 {
 	self->ops = ops;
 	self->id = id;
@@ -417,6 +572,9 @@ static int layout_shuffler_get(struct layout_provider *up, unsigned int n,
 {
 	struct layout_shuffler *self =
 		b6_cast_of(up, struct layout_shuffler, up);
+	if (n > b6_card_of(self->index))
+		return get_layout_from_provider(self->layout_provider, n,
+						layout);
 	return get_layout_from_provider(self->layout_provider,
 					1 + self->index[n - 1], layout);
 }
@@ -427,17 +585,18 @@ void reset_layout_shuffler(struct layout_shuffler *self,
 	static const struct layout_provider_ops ops = {
 		.get = layout_shuffler_get,
 	};
-	unsigned int i;
+	/* levels past the first ones of larger providers keep their order */
+	unsigned int i, size = layout_provider->size;
+	if (size > b6_card_of(self->index))
+		size = b6_card_of(self->index);
 	reset_layout_provider(&self->up, &ops, layout_provider->id,
 			      layout_provider->size);
 	self->layout_provider = layout_provider;
-	for (i = 0; i < layout_provider->size; i += 1)
+	for (i = 0; i < size; i += 1)
 		self->index[i] = i;
 	for (i = 0 ; i < 10000; i += 1) {
-		unsigned int a = read_random_number_generator() *
-			layout_provider->size;
-		unsigned int b = read_random_number_generator() *
-			layout_provider->size;
+		unsigned int a = read_random_number_generator() * size;
+		unsigned int b = read_random_number_generator() * size;
 		unsigned int index = self->index[a];
 		self->index[a] = self->index[b];
 		self->index[b] = index;
@@ -26,9 +26,13 @@
 #include "lib/io.h"
 #include "items.h"
 
+/* Size of the classic levels, which layouts default to. */
 #define LEVEL_WIDTH 40
 #define LEVEL_HEIGHT 25
 
+#define LEVEL_MAX_WIDTH 256
+#define LEVEL_MAX_HEIGHT 256
+
 enum {
 	LAYOUT_WALL          =  0,
 	LAYOUT_PAC_GUM_1     = 17,
@@ -41,21 +45,34 @@ enum {
 	LAYOUT_TELEPORT      = 24,
 };
 
+/* Layout codes are stored column by column with a one cell frame all around,
+ * i.e. (width + 2) columns of (height + 2) cells.
+ */
 struct layout {
-	unsigned char data[LEVEL_WIDTH + 2][LEVEL_HEIGHT + 2];
+	unsigned short int width;
+	unsigned short int height;
+	unsigned char data[(LEVEL_MAX_WIDTH + 2) * (LEVEL_MAX_HEIGHT + 2)];
 };
 
+static inline unsigned char *__get_layout(struct layout *l, int x, int y)
+{
+	return &l->data[x * (l->height + 2) + y];
+}
+
 static inline int get_layout(const struct layout *l, int x, int y)
 {
 	x += 1;
 	y += 1;
 	b6_precond(x >= 0);
-	b6_precond(x <= LEVEL_WIDTH + 1);
+	b6_precond(x <= l->width + 1);
 	b6_precond(y >= 0);
-	b6_precond(y <= LEVEL_HEIGHT + 1);
-	return l->data[x][y];
+	b6_precond(y <= l->height + 1);
+	return l->data[x * (l->height + 2) + y];
 }
 
+extern int reset_layout(struct layout *l, unsigned short int width,
+			unsigned short int height);
+
 extern int serialize_layout(const struct layout *l, struct ostream *s);
 
 extern int unserialize_layout(struct layout *l, struct istream *s);
@@ -64,6 +81,12 @@ extern int print_layout(const struct layout *l, struct ostream *s);
 
 extern int parse_layout(struct layout *l, struct istream *s);
 
+/* Returns the index of the tile drawn at (x, y) among the 48 maze tiles of a
+ * skin: walls are picked after their neighbors and 9 is the floor.
+ */
+extern unsigned int get_layout_tile(const struct layout *l,
+				    unsigned short int x, unsigned short int y);
+
 struct layout_provider {
 	struct b6_entry entry;
 	const struct layout_provider_ops *ops;
@@ -108,6 +131,13 @@ struct layout_provider_ops {
 	int (*get)(struct layout_provider*, unsigned int, struct layout*);
 };
 
+/* Size of providers whose levels never run out. */
+#define LAYOUT_PROVIDER_UNBOUNDED 0xffffffffU
+
+extern void reset_layout_provider(struct layout_provider *self,
+				  const struct layout_provider_ops *ops,
+				  const char *id, unsigned int size);
+
 static inline int get_layout_from_provider(struct layout_provider *self,
 					   unsigned int n,
 					   struct layout *layout)
@@ -164,22 +194,29 @@ struct level {
 	struct place *ghosts_home;
 	struct place *bonus_place;
 	struct place *teleport_places[2];
-	struct place places[LEVEL_WIDTH*LEVEL_HEIGHT];
+	struct place *places;
+	unsigned short int width;
+	unsigned short int height;
 	unsigned int nplaces;
 	struct items *items;
 };
 
+static inline unsigned int get_level_size(const struct level *l)
+{
+	return l->width * l->height;
+}
+
 static inline int is_place(const struct level *l, const struct place *p)
 {
-	return p >= l->places && p < l->places + b6_card_of(l->places);
+	return p >= l->places && p < l->places + get_level_size(l);
 }
 
 static inline void place_location(const struct level *l, const struct place *p,
 				  int *x, int *y)
 {
 	int offset = p - l->places;
-	*x = offset % LEVEL_WIDTH;
-	*y = offset / LEVEL_WIDTH;
+	*x = offset % l->width;
+	*y = offset / l->width;
 }
 
 extern struct place *place_neighbor(struct level*, struct place*,
@@ -231,7 +268,7 @@ static inline int level_iterator_has_next(struct level_iterator *self)
 {
 	for (;;) {
 		int i = self->i;
-		if (self->i >= LEVEL_WIDTH * LEVEL_HEIGHT)
+		if (self->i >= get_level_size(self->l))
 			return 0;
 		self->i += 1;
 		if (self->l->places[i].item || &self->l->places[i] ==
@@ -0,0 +1,280 @@
+/*
+ * Open Greedy - an open-source version of Edromel Studio's Greedy XP
+ *
+ * Copyright (C) 2014-2017 Arnaud TROEL
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "maze.h"
+
+#include "lib/init.h"
+#include "lib/log.h"
+
+#include <b6/cmdline.h>
+#include <b6/utf8.h>
+#include <string.h>
+
+/* Mazes are carved in a grid of rooms of 2x2 layout cells separated by one
+ * cell thick walls, which is how the classic levels are drawn: this way every
+ * corridor is exactly one place wide.
+ */
+#define MAZE_MAX_ROOMS \
+	(((LEVEL_MAX_WIDTH + 1) / 3) * ((LEVEL_MAX_HEIGHT + 1) / 3))
+
+enum {
+	MAZE_OPEN_E  = 1 << 0,
+	MAZE_OPEN_S  = 1 << 1,
+	MAZE_VISITED = 1 << 2,
+};
+
+struct maze {
+	struct layout *layout;
+	unsigned long long int rng;
+	unsigned short int nx, ny, ox, oy;
+	unsigned char room[MAZE_MAX_ROOMS];
+	unsigned short int stack[MAZE_MAX_ROOMS];
+};
+
+static unsigned int get_maze_random(struct maze *self, unsigned int n)
+{
+	/* xorshift64*: way faster than we need, and stable across platforms */
+	self->rng ^= self->rng >> 12;
+	self->rng ^= self->rng << 25;
+	self->rng ^= self->rng >> 27;
+	return ((self->rng * 2685821657736338717ULL) >> 32) % n;
+}
+
+static void seed_maze(struct maze *self, unsigned long long int seed)
+{
+	/* splitmix64 spreads close seeds apart and never yields 0 here */
+	seed += 0x9e3779b97f4a7c15ULL;
+	seed = (seed ^ (seed >> 30)) * 0xbf58476d1ce4e5b9ULL;
+	seed = (seed ^ (seed >> 27)) * 0x94d049bb133111ebULL;
+	self->rng = (seed ^ (seed >> 31)) | 1;
+}
+
+static int get_maze_neighbors(const struct maze *self, int r, int *neighbor)
+{
+	int x = r % self->nx, y = r / self->nx, n = 0;
+	if (x > 0)
+		neighbor[n++] = r - 1;
+	if (x < self->nx - 1)
+		neighbor[n++] = r + 1;
+	if (y > 0)
+		neighbor[n++] = r - self->nx;
+	if (y < self->ny - 1)
+		neighbor[n++] = r + self->nx;
+	return n;
+}
+
+static void open_maze(struct maze *self, int r, int s)
+{
+	if (s == r + 1)
+		self->room[r] |= MAZE_OPEN_E;
+	else if (s == r - 1)
+		self->room[s] |= MAZE_OPEN_E;
+	else if (s > r)
+		self->room[r] |= MAZE_OPEN_S;
+	else
+		self->room[s] |= MAZE_OPEN_S;
+}
+
+static int is_maze_open(const struct maze *self, int r, int s)
+{
+	if (s == r + 1)
+		return self->room[r] & MAZE_OPEN_E;
+	if (s == r - 1)
+		return self->room[s] & MAZE_OPEN_E;
+	if (s > r)
+		return self->room[r] & MAZE_OPEN_S;
+	return self->room[s] & MAZE_OPEN_S;
+}
+
+/* Depth first backtracking yields a spanning tree of the rooms, which makes
+ * every room reachable from any other.
+ */
+static void dig_maze(struct maze *self)
+{
+	int neighbor[4], candidate[4];
+	unsigned int top = 0;
+	self->stack[top++] = get_maze_random(self, self->nx * self->ny);
+	self->room[self->stack[0]] |= MAZE_VISITED;
+	while (top) {
+		int r = self->stack[top - 1];
+		int i, n = get_maze_neighbors(self, r, neighbor), m = 0;
+		for (i = 0; i < n; i += 1)
+			if (!(self->room[neighbor[i]] & MAZE_VISITED))
+				candidate[m++] = neighbor[i];
+		if (!m) {
+			top -= 1;
+			continue;
+		}
+		i = candidate[get_maze_random(self, m)];
+		open_maze(self, r, i);
+		self->room[i] |= MAZE_VISITED;
+		self->stack[top++] = i;
+	}
+}
+
+/* Dead ends are no fun with ghosts around: connect each of them to another
+ * neighbor so that pacman can always run away.
+ */
+static void braid_maze(struct maze *self)
+{
+	int neighbor[4], candidate[4];
+	int r, i, n, m;
+	for (r = 0; r < self->nx * self->ny; r += 1) {
+		n = get_maze_neighbors(self, r, neighbor);
+		for (i = m = 0; i < n; i += 1)
+			if (!is_maze_open(self, r, neighbor[i]))
+				candidate[m++] = neighbor[i];
+		if (m == n - 1)
+			open_maze(self, r, candidate[get_maze_random(self, m)]);
+	}
+}
+
+static void set_maze_cell(struct maze *self, int x, int y, unsigned char code)
+{
+	*__get_layout(self->layout, self->ox + x + 1, self->oy + y + 1) = code;
+}
+
+static void set_maze_item(struct maze *self, int rx, int ry,
+			  unsigned char code)
+{
+	set_maze_cell(self, rx * 3 + 1, ry * 3, code);
+}
+
+static void draw_maze(struct maze *self)
+{
+	int rx, ry;
+	for (ry = 0; ry < self->ny; ry += 1)
+		for (rx = 0; rx < self->nx; rx += 1) {
+			int r = ry * self->nx + rx, x = rx * 3, y = ry * 3;
+			set_maze_cell(self, x, y, LAYOUT_PAC_GUM_1);
+			set_maze_cell(self, x + 1, y, LAYOUT_PAC_GUM_1);
+			set_maze_cell(self, x, y + 1, LAYOUT_PAC_GUM_1);
+			set_maze_cell(self, x + 1, y + 1, LAYOUT_PAC_GUM_1);
+			if (self->room[r] & MAZE_OPEN_E) {
+				set_maze_cell(self, x + 2, y, LAYOUT_PAC_GUM_1);
+				set_maze_cell(self, x + 2, y + 1,
+					      LAYOUT_PAC_GUM_1);
+			}
+			if (self->room[r] & MAZE_OPEN_S) {
+				set_maze_cell(self, x, y + 2, LAYOUT_PAC_GUM_1);
+				set_maze_cell(self, x + 1, y + 2,
+					      LAYOUT_PAC_GUM_1);
+			}
+		}
+}
+
+/* Items are laid out so that none of them overlap: the ghosts den sits in the
+ * middle, pacman right below, the bonus at the top, teleports on the left and
+ * right sides and super pac-gums in the corners.
+ */
+static void furnish_maze(struct maze *self)
+{
+	int nx = self->nx, ny = self->ny;
+	set_maze_item(self, nx / 2, (ny - 1) / 2, LAYOUT_GHOSTS);
+	set_maze_item(self, nx / 2, ny - 1, LAYOUT_PACMAN);
+	set_maze_item(self, nx / 2, 0, LAYOUT_BONUS);
+	set_maze_item(self, 0, 1 + get_maze_random(self, ny - 2),
+		      LAYOUT_TELEPORT);
+	set_maze_item(self, nx - 1, 1 + get_maze_random(self, ny - 2),
+		      LAYOUT_TELEPORT);
+	set_maze_item(self, 0, 0, LAYOUT_SUPER_PAC_GUM);
+	set_maze_item(self, nx - 1, 0, LAYOUT_SUPER_PAC_GUM);
+	set_maze_item(self, 0, ny - 1, LAYOUT_SUPER_PAC_GUM);
+	set_maze_item(self, nx - 1, ny - 1, LAYOUT_SUPER_PAC_GUM);
+}
+
+int generate_maze_layout(struct layout *layout, unsigned long int seed,
+			 unsigned short int width, unsigned short int height)
+{
+	struct maze self;
+	if (width < MAZE_MIN_WIDTH || height < MAZE_MIN_HEIGHT) {
+		logf_e("maze size %ux%u is too small", width, height);
+		return -1;
+	}
+	if (reset_layout(layout, width, height))
+		return -1;
+	self.layout = layout;
+	self.nx = (width + 1) / 3;
+	self.ny = (height + 1) / 3;
+	self.ox = (width + 1 - self.nx * 3) / 2;
+	self.oy = (height + 1 - self.ny * 3) / 2;
+	memset(self.room, 0, self.nx * self.ny);
+	seed_maze(&self, seed);
+	dig_maze(&self);
+	braid_maze(&self);
+	draw_maze(&self);
+	furnish_maze(&self);
+	return 0;
+}
+
+static int maze_layout_provider_get(struct layout_provider *up,
+				    unsigned int n, struct layout *layout)
+{
+	struct maze_layout_provider *self =
+		b6_cast_of(up, struct maze_layout_provider, up);
+	return generate_maze_layout(layout, self->seed * 1000003UL + n,
+				    self->width, self->height);
+}
+
+int reset_maze_layout_provider(struct maze_layout_provider *self,
+			       const char *id, unsigned long int seed,
+			       unsigned short int width,
+			       unsigned short int height)
+{
+	static const struct layout_provider_ops ops = {
+		.get = maze_layout_provider_get,
+	};
+	if (width < MAZE_MIN_WIDTH || width > LEVEL_MAX_WIDTH ||
+	    height < MAZE_MIN_HEIGHT || height > LEVEL_MAX_HEIGHT) {
+		logf_e("unsupported maze size %ux%u", width, height);
+		return -1;
+	}
+	reset_layout_provider(&self->up, &ops, id, LAYOUT_PROVIDER_UNBOUNDED);
+	self->seed = seed;
+	self->width = width;
+	self->height = height;
+	return 0;
+}
+
+static int maze = 0;
+b6_flag(maze, bool);
+
+static unsigned int maze_seed = 0;
+b6_flag(maze_seed, uint);
+
+static unsigned short int maze_width = LEVEL_WIDTH;
+b6_flag(maze_width, ushort);
+
+static unsigned short int maze_height = LEVEL_HEIGHT;
+b6_flag(maze_height, ushort);
+
+static int maze_ctor(void)
+{
+	static struct maze_layout_provider maze_layout_provider;
+	if (!maze)
+		return 0;
+	if (reset_maze_layout_provider(&maze_layout_provider, "maze",
+				       maze_seed, maze_width, maze_height))
+		log_w(_s("could not initialize mazes"));
+	else if (register_layout_provider(&maze_layout_provider.up,
+					  B6_UTF8("Maze")))
+		log_e(_s("could not register mazes"));
+	return 0;
+}
+register_init(maze_ctor);
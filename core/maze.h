@@ -0,0 +1,48 @@
+/*
+ * Open Greedy - an open-source version of Edromel Studio's Greedy XP
+ *
+ * Copyright (C) 2014-2017 Arnaud TROEL
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MAZE_H
+#define MAZE_H
+
+#include "level.h"
+
+/* Generates braided mazes of a given size: the n-th layout of a provider only
+ * depends on its seed, so that any number of levels can be reproduced.
+ */
+struct maze_layout_provider {
+	struct layout_provider up;
+	unsigned long int seed;
+	unsigned short int width;
+	unsigned short int height;
+};
+
+/* Mazes need at least 3x3 rooms, i.e. layouts of 8x8 cells. */
+#define MAZE_MIN_WIDTH 8
+#define MAZE_MIN_HEIGHT 8
+
+extern int reset_maze_layout_provider(struct maze_layout_provider *self,
+				      const char *id, unsigned long int seed,
+				      unsigned short int width,
+				      unsigned short int height);
+
+extern int generate_maze_layout(struct layout *layout, unsigned long int seed,
+				unsigned short int width,
+				unsigned short int height);
+
+#endif /* MAZE_H */
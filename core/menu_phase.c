@@ -349,7 +349,9 @@ static struct submenu *select_video_options(struct submenu *up,
 		set_pref_vsync(up->engine->pref, self->vs);
 		set_pref_fullscreen(up->engine->pref, self->fs);
 		if (self->vs == get_console_vsync() &&
-		    self->fs == get_console_fullscreen())
+		    (self->fs == get_console_fullscreen() ||
+		     !switch_console_fullscreen(up->engine->console,
+						self->fs)))
 			return up;
 		set_console_vsync(self->vs);
 		set_console_fullscreen(self->fs);
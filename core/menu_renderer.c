@@ -27,6 +27,7 @@
 #include "lib/std.h"
 #include "menu_phase.h"
 #include "data.h"
+#include "texture_cache.h"
 
 /* 512 half-degree cos table + 64 values for sin */
 const float _cosqf[] = {
@@ -239,7 +240,8 @@ static void menu_renderer_image_on_render_h(struct renderer_observer *observer)
 {
 	struct menu_renderer_image *self = b6_cast_of(
 		observer, struct menu_renderer_image, renderer_observer);
-	self->base->x = update_linear(&self->linear);
+	move_renderer_base(self->base, update_linear(&self->linear),
+			   get_renderer_base_y(self->base));
 	move_shadow(self);
 }
 
@@ -247,7 +249,8 @@ static void menu_renderer_image_on_render_v(struct renderer_observer *observer)
 {
 	struct menu_renderer_image *self = b6_cast_of(
 		observer, struct menu_renderer_image, renderer_observer);
-	self->base->y = update_linear(&self->linear);
+	move_renderer_base(self->base, get_renderer_base_x(self->base),
+			   update_linear(&self->linear));
 	move_shadow(self);
 }
 
@@ -283,9 +286,11 @@ static int initialize_menu_renderer_image(
 		0, 0, w, h, texture[0]);
 	put_image_data(entry, data);
 	if (ops->on_render == menu_renderer_image_on_render_v)
-		setup_linear(&self->linear, clock, self->base->y, pos, speed);
+		setup_linear(&self->linear, clock,
+			     get_renderer_base_y(self->base), pos, speed);
 	else
-		setup_linear(&self->linear, clock, self->base->x, pos, speed);
+		setup_linear(&self->linear, clock,
+			     get_renderer_base_x(self->base), pos, speed);
 	add_renderer_observer(renderer, setup_renderer_observer(
 			&self->renderer_observer, data_id, ops));
 	return 0;
@@ -295,8 +300,10 @@ static void finalize_menu_renderer_image(struct menu_renderer_image *self)
 {
 	if (self->base) {
 		del_renderer_observer(&self->renderer_observer);
-		destroy_renderer_texture(self->tile[1]->texture);
-		destroy_renderer_texture(self->tile[0]->texture);
+		destroy_renderer_texture(
+			get_renderer_tile_texture(self->tile[1]));
+		destroy_renderer_texture(
+			get_renderer_tile_texture(self->tile[0]));
 		destroy_renderer_base(self->base);
 	}
 }
@@ -429,7 +436,7 @@ int initialize_menu_renderer(struct menu_renderer *self,
 	make_font(&self->bright_font, skin_id, MENU_BRIGHT_FONT_DATA_ID);
 	if ((self->background = create_renderer_tile(renderer, root, 0, 0,
 						     640, 480, NULL)))
-		set_renderer_tile_texture(self->background, make_texture(
+		set_renderer_tile_texture(self->background, get_texture(
 			renderer, skin_id, MENU_BACKGROUND_DATA_ID));
 	initialize_menu_renderer_image(&self->title, renderer, self->clock,
 				       70, -118, 500, 150, 32, 3e-4,
@@ -457,7 +464,7 @@ void finalize_menu_renderer(struct menu_renderer *self)
 	finalize_menu_renderer_image(&self->pacman);
 	finalize_menu_renderer_image(&self->title);
 	if (self->background) {
-		destroy_renderer_texture(self->background->texture);
+		put_texture(get_renderer_tile_texture(self->background));
 		destroy_renderer_tile(self->background);
 	}
 	finalize_fixed_font(&self->bright_font);
@@ -0,0 +1,189 @@
+/*
+ * Open Greedy - an open-source version of Edromel Studio's Greedy XP
+ *
+ * Copyright (C) 2014-2017 Arnaud TROEL
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "overlay.h"
+
+#include <b6/cmdline.h>
+#include <b6/utf8.h>
+#include <stdarg.h>
+#include <stdio.h>
+
+#include "game.h"
+#include "game_phase.h"
+
+static int overlay = 0;
+b6_flag(overlay, bool);
+
+void set_overlay_game(struct overlay *self, const struct game *game)
+{
+	self->game = game;
+	self->ticks = game ? game->ticks : 0;
+}
+
+/* Lines are padded so that they stay left aligned once centered. */
+static void set_overlay_line(struct overlay *self, int i,
+			     const char *format, ...)
+{
+	struct toolkit_text *text = &self->text[i];
+	struct b6_utf8 utf8;
+	char s[64];
+	va_list ap;
+	int n;
+	va_start(ap, format);
+	n = vsnprintf(s, sizeof(s), format, ap);
+	va_end(ap);
+	if (n < 0)
+		return;
+	if (n > text->length)
+		n = text->length;
+	while (n < text->length)
+		s[n++] = ' ';
+	s[n] = '\0';
+	set_toolkit_text(text, b6_utf8_from_ascii(&utf8, s));
+}
+
+static void refresh_overlay(struct overlay *self)
+{
+	const struct renderer *r = self->renderer;
+	set_overlay_line(self, 0, "frame %5.1fms avg %5.1fms",
+			 self->frame_time / 1e3,
+			 self->total_time / 1e3 / self->nframes);
+	if (self->game)
+		set_overlay_line(self, 1, "ticks %4.2f/frame catch-ups %lu",
+				 (double)(self->game->ticks - self->ticks) /
+				 self->nframes, self->game->catch_ups);
+	else
+		set_overlay_line(self, 1, "ticks -");
+	set_overlay_line(self, 2, "tex %lu tiles %lu bases %lu",
+			 r->ntextures - self->ntextures,
+			 r->ntiles - self->ntiles, r->nbases - self->nbases);
+	set_overlay_line(self, 3, "texture memory %lukB",
+			 (r->texture_bytes - self->texture_bytes) / 1024);
+	set_overlay_line(self, 4, "draws %lu rebuilds %lu",
+			 r->ndraws, r->nrebuilds);
+}
+
+static void on_render(struct renderer_observer *observer)
+{
+	struct overlay *self =
+		b6_cast_of(observer, struct overlay, renderer_observer);
+	unsigned long long int now = b6_get_clock_time(self->clock);
+	self->frame_time = now - self->time;
+	self->total_time += self->frame_time;
+	self->nframes += 1;
+	self->time = now;
+	if (now - self->since < 500000)
+		return;
+	refresh_overlay(self);
+	self->since = now;
+	self->total_time = 0;
+	self->nframes = 0;
+	if (self->game)
+		self->ticks = self->game->ticks;
+}
+
+static int create_overlay(struct overlay *self)
+{
+	struct renderer *r = self->renderer;
+	unsigned short int font_w, font_h;
+	int i;
+	if (make_font(&self->font, "default", GAME_FONT_DATA_ID))
+		goto fail_font;
+	if (initialize_toolkit_glyphs(&self->glyphs, r, &self->font, 1))
+		goto fail_glyphs;
+	if (!(self->base = create_renderer_base(r, get_renderer_base(r),
+						"overlay", 4, 4)))
+		goto fail_base;
+	font_w = get_fixed_font_width(&self->font);
+	font_h = get_fixed_font_height(&self->font);
+	for (i = 0; i < OVERLAY_LINES; i += 1)
+		if (initialize_toolkit_text(&self->text[i], r, &self->glyphs,
+					    32 * font_w, font_h, self->base,
+					    0, i * font_h, 32 * font_w,
+					    font_h))
+			goto fail_text;
+	return 0;
+fail_text:
+	while (i--)
+		finalize_toolkit_text(&self->text[i]);
+	destroy_renderer_base(self->base);
+	self->base = NULL;
+fail_base:
+	finalize_toolkit_glyphs(&self->glyphs);
+fail_glyphs:
+	finalize_fixed_font(&self->font);
+fail_font:
+	return -1;
+}
+
+int open_overlay(struct overlay *self, struct renderer *renderer,
+		 const struct b6_clock *clock)
+{
+	static const struct renderer_observer_ops ops = {
+		.on_render = on_render,
+	};
+	self->renderer = renderer;
+	self->clock = clock;
+	self->base = NULL;
+	if (!overlay)
+		return 0;
+	self->ntextures = renderer->ntextures;
+	self->ntiles = renderer->ntiles;
+	self->nbases = renderer->nbases;
+	self->texture_bytes = renderer->texture_bytes;
+	if (create_overlay(self)) {
+		log_w(_s("cannot create overlay"));
+		return -1;
+	}
+	self->ntextures = renderer->ntextures - self->ntextures;
+	self->ntiles = renderer->ntiles - self->ntiles;
+	self->nbases = renderer->nbases - self->nbases;
+	self->texture_bytes = renderer->texture_bytes - self->texture_bytes;
+	self->time = self->since = b6_get_clock_time(clock);
+	self->total_time = self->frame_time = 0;
+	self->nframes = 0;
+	if (self->game)
+		self->ticks = self->game->ticks;
+	add_renderer_observer(renderer, setup_renderer_observer(
+			&self->renderer_observer, "overlay", &ops));
+	return 0;
+}
+
+void close_overlay(struct overlay *self)
+{
+	int i;
+	if (!self->base)
+		return;
+	del_renderer_observer(&self->renderer_observer);
+	for (i = 0; i < OVERLAY_LINES; i += 1)
+		finalize_toolkit_text(&self->text[i]);
+	destroy_renderer_base(self->base);
+	self->base = NULL;
+	finalize_toolkit_glyphs(&self->glyphs);
+	finalize_fixed_font(&self->font);
+}
+
+void toggle_overlay(struct overlay *self)
+{
+	overlay = !overlay;
+	if (overlay)
+		open_overlay(self, self->renderer, self->clock);
+	else
+		close_overlay(self);
+}
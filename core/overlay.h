@@ -0,0 +1,65 @@
+/*
+ * Open Greedy - an open-source version of Edromel Studio's Greedy XP
+ *
+ * Copyright (C) 2014-2017 Arnaud TROEL
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef OVERLAY_H
+#define OVERLAY_H
+
+#include <b6/clock.h>
+
+#include "renderer.h"
+#include "toolkit.h"
+
+struct game;
+
+#define OVERLAY_LINES 5
+
+/* Performance figures drawn above the current phase. The resources of the
+ * overlay itself are left out of the renderer figures it shows.
+ */
+struct overlay {
+	struct renderer_observer renderer_observer;
+	struct renderer *renderer;
+	const struct b6_clock *clock;
+	struct renderer_base *base; /* NULL when closed */
+	struct fixed_font font;
+	struct toolkit_glyphs glyphs;
+	struct toolkit_text text[OVERLAY_LINES];
+	unsigned long int ntextures, ntiles, nbases, texture_bytes; /* own */
+	unsigned long long int time; /* of the last frame */
+	unsigned long long int since; /* start of the period shown next */
+	unsigned long long int frame_time; /* duration of the last frame */
+	unsigned long long int total_time; /* of the frames in the period */
+	unsigned long int nframes; /* in the period */
+	const struct game *game; /* NULL outside of games */
+	unsigned long int ticks; /* of the game when the period started */
+};
+
+/* Shows the simulation counters of game, or none when game is NULL. */
+extern void set_overlay_game(struct overlay *self, const struct game *game);
+
+/* Does nothing unless the overlay is enabled. */
+extern int open_overlay(struct overlay *self, struct renderer *renderer,
+			const struct b6_clock *clock);
+
+extern void close_overlay(struct overlay *self);
+
+/* Enables or disables the overlay, opening or closing it accordingly. */
+extern void toggle_overlay(struct overlay *self);
+
+#endif /* OVERLAY_H */
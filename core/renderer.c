@@ -19,12 +19,283 @@
 
 #include "renderer.h"
 
+#include "lib/std.h"
+
 #define __notify_renderer_observers(_self, _op, _args...) \
 	b6_notify_observers(&(_self)->observers, renderer_observer, _op, \
 			   ##_args)
 
 B6_REGISTRY_DEFINE(__base_registry);
 
+void initialize_renderer_scene(struct renderer_scene *self)
+{
+	b6_array_initialize(&self->tile_x, &b6_std_allocator, sizeof(float));
+	b6_array_initialize(&self->tile_y, &b6_std_allocator, sizeof(float));
+	b6_array_initialize(&self->tile_w, &b6_std_allocator, sizeof(float));
+	b6_array_initialize(&self->tile_h, &b6_std_allocator, sizeof(float));
+	b6_array_initialize(&self->tile_uv, &b6_std_allocator,
+			    4 * sizeof(float));
+	b6_array_initialize(&self->tile_texture, &b6_std_allocator,
+			    sizeof(struct renderer_texture*));
+	b6_array_initialize(&self->tile_base, &b6_std_allocator,
+			    sizeof(unsigned int));
+	b6_array_initialize(&self->free_tiles, &b6_std_allocator,
+			    sizeof(unsigned int));
+	b6_array_initialize(&self->base_x, &b6_std_allocator, sizeof(float));
+	b6_array_initialize(&self->base_y, &b6_std_allocator, sizeof(float));
+	b6_array_initialize(&self->base_parent, &b6_std_allocator,
+			    sizeof(unsigned int));
+	b6_array_initialize(&self->base_visible, &b6_std_allocator,
+			    sizeof(unsigned char));
+	b6_array_initialize(&self->free_bases, &b6_std_allocator,
+			    sizeof(unsigned int));
+	b6_array_initialize(&self->base_offset, &b6_std_allocator,
+			    2 * sizeof(float));
+	b6_array_initialize(&self->base_shown, &b6_std_allocator,
+			    sizeof(unsigned char));
+	b6_array_initialize(&self->order, &b6_std_allocator,
+			    sizeof(unsigned int));
+	self->reordered = 1;
+}
+
+void finalize_renderer_scene(struct renderer_scene *self)
+{
+	b6_array_finalize(&self->order);
+	b6_array_finalize(&self->base_shown);
+	b6_array_finalize(&self->base_offset);
+	b6_array_finalize(&self->free_bases);
+	b6_array_finalize(&self->base_visible);
+	b6_array_finalize(&self->base_parent);
+	b6_array_finalize(&self->base_y);
+	b6_array_finalize(&self->base_x);
+	b6_array_finalize(&self->free_tiles);
+	b6_array_finalize(&self->tile_base);
+	b6_array_finalize(&self->tile_texture);
+	b6_array_finalize(&self->tile_uv);
+	b6_array_finalize(&self->tile_h);
+	b6_array_finalize(&self->tile_w);
+	b6_array_finalize(&self->tile_y);
+	b6_array_finalize(&self->tile_x);
+}
+
+/* Adds a row to all the arrays, or to none of them. */
+static int extend_renderer_scene(struct b6_array *const *arrays,
+				 unsigned int n)
+{
+	unsigned int i;
+	for (i = 0; i < n; i += 1)
+		if (!b6_array_extend(arrays[i], 1)) {
+			while (i--)
+				b6_array_reduce(arrays[i], 1);
+			return -1;
+		}
+	return 0;
+}
+
+static void free_renderer_scene_row(struct b6_array *free,
+				    unsigned long int handle)
+{
+	unsigned int *row = b6_array_extend(free, 1);
+	if (row)
+		*row = handle;
+	else
+		log_w(_s("leaking a scene row"));
+}
+
+/* Bases get a row after that of their parent, so that sweeping rows in order
+ * meets parents first.
+ */
+static long int add_renderer_scene_base(struct renderer_scene *self,
+					unsigned int parent)
+{
+	struct b6_array *const arrays[] = {
+		&self->base_x, &self->base_y, &self->base_parent,
+		&self->base_visible, &self->base_offset, &self->base_shown,
+	};
+	unsigned long int n = b6_array_length(&self->free_bases);
+	unsigned int *free = n ? b6_array_get(&self->free_bases, 0) : NULL;
+	while (n--)
+		if (free[n] > parent) {
+			unsigned int row = free[n];
+			free[n] = free[b6_array_length(&self->free_bases) - 1];
+			b6_array_reduce(&self->free_bases, 1);
+			return row;
+		}
+	if (extend_renderer_scene(arrays, b6_card_of(arrays)))
+		return -1;
+	return b6_array_length(&self->base_x) - 1;
+}
+
+int __setup_renderer_base(struct renderer_base *self,
+			  struct renderer *renderer,
+			  struct renderer_base *parent,
+			  const char *name, double x, double y,
+			  const struct renderer_base_ops *ops)
+{
+	struct renderer_scene *scene = &renderer->scene;
+	unsigned int up = parent ? parent->handle : 0;
+	long int handle = add_renderer_scene_base(scene, up);
+	if (handle < 0)
+		return -1;
+	self->ops = ops;
+	self->renderer = renderer;
+	self->parent = parent;
+	self->handle = handle;
+	*(float*)b6_array_get(&scene->base_x, handle) = x;
+	*(float*)b6_array_get(&scene->base_y, handle) = y;
+	*(unsigned int*)b6_array_get(&scene->base_parent, handle) = up;
+	*(unsigned char*)b6_array_get(&scene->base_visible, handle) = 1;
+	b6_list_initialize(&self->bases);
+	b6_list_initialize(&self->tiles);
+	if (parent)
+		b6_list_add_last(&parent->bases, &self->dref);
+	self->name = name;
+	return 0;
+}
+
+void del_renderer_scene_base(struct renderer_scene *self,
+			     unsigned long int handle)
+{
+	*(unsigned char*)b6_array_get(&self->base_visible, handle) = 0;
+	free_renderer_scene_row(&self->free_bases, handle);
+}
+
+static long int add_renderer_scene_tile(struct renderer_scene *self)
+{
+	struct b6_array *const arrays[] = {
+		&self->tile_x, &self->tile_y, &self->tile_w, &self->tile_h,
+		&self->tile_uv, &self->tile_texture, &self->tile_base,
+	};
+	unsigned long int n = b6_array_length(&self->free_tiles);
+	if (n) {
+		unsigned int row =
+			*(unsigned int*)b6_array_get(&self->free_tiles, n - 1);
+		b6_array_reduce(&self->free_tiles, 1);
+		return row;
+	}
+	if (extend_renderer_scene(arrays, b6_card_of(arrays)))
+		return -1;
+	return b6_array_length(&self->tile_x) - 1;
+}
+
+void set_renderer_scene_texture(struct renderer_scene *self,
+				unsigned long int handle,
+				struct renderer_texture *texture)
+{
+	float *uv = b6_array_get(&self->tile_uv, handle);
+	*(struct renderer_texture**)b6_array_get(&self->tile_texture,
+						 handle) = texture;
+	if (texture) {
+		uv[0] = texture->u1;
+		uv[1] = texture->v1;
+		uv[2] = texture->u2;
+		uv[3] = texture->v2;
+	} else {
+		uv[0] = uv[1] = 0.;
+		uv[2] = uv[3] = 1.;
+	}
+}
+
+int __setup_renderer_tile(struct renderer_tile *self,
+			  struct renderer_base *parent,
+			  double x, double y, double w, double h,
+			  struct renderer_texture *texture,
+			  const struct renderer_tile_ops *ops)
+{
+	struct renderer_scene *scene = &parent->renderer->scene;
+	long int handle = add_renderer_scene_tile(scene);
+	if (handle < 0)
+		return -1;
+	self->ops = ops;
+	self->renderer = parent->renderer;
+	self->parent = parent;
+	self->handle = handle;
+	*(float*)b6_array_get(&scene->tile_x, handle) = x;
+	*(float*)b6_array_get(&scene->tile_y, handle) = y;
+	*(float*)b6_array_get(&scene->tile_w, handle) = w;
+	*(float*)b6_array_get(&scene->tile_h, handle) = h;
+	*(unsigned int*)b6_array_get(&scene->tile_base, handle) =
+		parent->handle;
+	set_renderer_scene_texture(scene, handle, texture);
+	b6_list_add_last(&parent->tiles, &self->dref);
+	scene->reordered = 1;
+	return 0;
+}
+
+/* The texture is forgotten, so that sweeps over all rows never meet a
+ * texture that was destroyed.
+ */
+void del_renderer_scene_tile(struct renderer_scene *self,
+			     unsigned long int handle)
+{
+	set_renderer_scene_texture(self, handle, NULL);
+	free_renderer_scene_row(&self->free_tiles, handle);
+	self->reordered = 1;
+}
+
+void retexture_renderer_scene(struct renderer_scene *self)
+{
+	unsigned long int i, n = b6_array_length(&self->tile_texture);
+	for (i = 0; i < n; i += 1)
+		set_renderer_scene_texture(self, i, *(struct renderer_texture**)
+					   b6_array_get(&self->tile_texture,
+							i));
+}
+
+static int order_renderer_base(struct renderer_scene *self,
+			       const struct renderer_base *base)
+{
+	struct b6_dref *dref;
+	for (dref = b6_list_first(&base->tiles);
+	     dref != b6_list_tail(&base->tiles);
+	     dref = b6_list_walk(dref, B6_NEXT)) {
+		unsigned int *row = b6_array_extend(&self->order, 1);
+		if (!row)
+			return -1;
+		*row = b6_cast_of(dref, struct renderer_tile, dref)->handle;
+	}
+	for (dref = b6_list_first(&base->bases);
+	     dref != b6_list_tail(&base->bases);
+	     dref = b6_list_walk(dref, B6_NEXT))
+		if (order_renderer_base(self, b6_cast_of(dref,
+							 struct renderer_base,
+							 dref)))
+			return -1;
+	return 0;
+}
+
+/* The lists of the bases are only walked when tiles came or went: every other
+ * frame is a single pass over the rows of bases.
+ */
+int sweep_renderer_scene(struct renderer *self)
+{
+	struct renderer_scene *scene = &self->scene;
+	unsigned long int i, n = b6_array_length(&scene->base_x);
+	const float *x = b6_array_get(&scene->base_x, 0);
+	const float *y = b6_array_get(&scene->base_y, 0);
+	const unsigned int *parent = b6_array_get(&scene->base_parent, 0);
+	const unsigned char *visible = b6_array_get(&scene->base_visible, 0);
+	float *offset = b6_array_get(&scene->base_offset, 0);
+	unsigned char *shown = b6_array_get(&scene->base_shown, 0);
+	/* the root */
+	offset[0] = x[0];
+	offset[1] = y[0];
+	shown[0] = visible[0];
+	for (i = 1; i < n; i += 1) {
+		const float *from = &offset[2 * parent[i]];
+		offset[2 * i] = from[0] + x[i];
+		offset[2 * i + 1] = from[1] + y[i];
+		shown[i] = shown[parent[i]] & visible[i];
+	}
+	if (!scene->reordered)
+		return 0;
+	b6_array_clear(&scene->order);
+	if (order_renderer_base(scene, get_renderer_base(self)))
+		return -1;
+	scene->reordered = 0;
+	return 0;
+}
+
 void destroy_renderer_base_tiles(struct renderer_base *self)
 {
 	struct b6_dref *dref = b6_list_first(&self->tiles);
@@ -50,5 +321,6 @@ void destroy_renderer_base_children(struct renderer_base *self)
 void show_renderer(struct renderer *self)
 {
 	__notify_renderer_observers(self, on_render);
+	self->ndraws = 0;
 	self->ops->render(self);
 }
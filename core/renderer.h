@@ -20,6 +20,7 @@
 #ifndef RENDERER_H
 #define RENDERER_H
 
+#include <b6/array.h>
 #include <b6/deque.h>
 #include <b6/list.h>
 #include <b6/observer.h>
@@ -28,13 +29,40 @@
 #include "lib/log.h"
 #include "rgba.h"
 
+struct renderer;
+struct renderer_texture;
+
+/* Tiles and bases are handles on rows of the scene of their renderer, which
+ * keeps their geometry, texture and visibility in parallel arrays: a frame is
+ * laid out by sweeping these rather than by walking the tree of bases. Rows
+ * of deleted tiles and bases are recycled, and a handle stays valid for the
+ * lifetime of its tile or base.
+ */
+struct renderer_scene {
+	/* tiles */
+	struct b6_array tile_x, tile_y, tile_w, tile_h; /* float */
+	struct b6_array tile_uv; /* 4 floats: u1, v1, u2, v2 */
+	struct b6_array tile_texture; /* struct renderer_texture* */
+	struct b6_array tile_base; /* unsigned int: row of the base */
+	struct b6_array free_tiles; /* unsigned int */
+	/* bases, whose parents always sit in a lower row */
+	struct b6_array base_x, base_y; /* float, relative to the parent */
+	struct b6_array base_parent; /* unsigned int */
+	struct b6_array base_visible; /* unsigned char */
+	struct b6_array free_bases; /* unsigned int */
+	/* computed by sweep_renderer_scene */
+	struct b6_array base_offset; /* 2 floats: absolute position */
+	struct b6_array base_shown; /* unsigned char: ancestors visible too */
+	struct b6_array order; /* unsigned int: tiles in drawing order */
+	int reordered; /* tiles came or went since order was computed */
+};
+
 struct renderer_base {
 	struct b6_dref dref;
 	const struct renderer_base_ops *ops;
 	struct renderer *renderer;
 	struct renderer_base *parent;
-	double x, y;
-	int visible;
+	unsigned long int handle; /* row in the scene */
 	struct b6_list bases;
 	struct b6_list tiles;
 	const char *name;
@@ -45,81 +73,76 @@ struct renderer_base_ops {
 	void (*dtor)(struct renderer_base*);
 };
 
-static inline void __setup_renderer_base(struct renderer_base *self,
-					 struct renderer_base *parent,
-					 const char *name, double x, double y,
-					 const struct renderer_base_ops *ops)
-{
-	self->ops = ops;
-	self->parent = parent;
-	self->x = x;
-	self->y = y;
-	self->visible = 1;
-	b6_list_initialize(&self->bases);
-	b6_list_initialize(&self->tiles);
-	if (parent)
-		b6_list_add_last(&parent->bases, &self->dref);
-	self->name = name;
-}
-
-static inline void move_renderer_base(struct renderer_base *self,
-				      double x, double y)
-{
-	self->x = x;
-	self->y = y;
-}
-
-static inline void show_renderer_base(struct renderer_base *self)
-{
-	self->visible = 1;
-}
-
-static inline void hide_renderer_base(struct renderer_base *self)
-{
-	self->visible = 0;
-}
+/* Returns -1 when the scene could not make room for the base. The root of a
+ * renderer is set up without a parent before any other base.
+ */
+extern int __setup_renderer_base(struct renderer_base *self,
+				 struct renderer *renderer,
+				 struct renderer_base *parent,
+				 const char *name, double x, double y,
+				 const struct renderer_base_ops *ops);
 
 struct renderer_tile {
 	struct b6_dref dref;
 	const struct renderer_tile_ops *ops;
 	struct renderer *renderer;
 	struct renderer_base *parent;
-	struct renderer_texture *texture;
-	double x, y, w, h;
+	unsigned long int handle; /* row in the scene */
 	void *userdata;
 };
 
 struct renderer_tile_ops {
 	void (*dtor)(struct renderer_tile*);
+	/* optional: called with the previous texture whenever one is set */
+	void (*retexture)(struct renderer_tile*, struct renderer_texture*);
+	/* optional: called whenever the size of the tile changes */
+	void (*resize)(struct renderer_tile*);
 };
 
-static inline void __setup_renderer_tile(struct renderer_tile *self,
-					 struct renderer_base *parent,
-					 double x, double y, double w, double h,
-					 struct renderer_texture *texture,
-					 const struct renderer_tile_ops *ops)
-{
-	self->ops = ops;
-	self->texture = texture;
-	self->parent = parent;
-	self->x = x;
-	self->y = y;
-	self->w = w;
-	self->h = h;
-	b6_list_add_last(&parent->tiles, &self->dref);
-}
+/* Returns -1 when the scene could not make room for the tile. */
+extern int __setup_renderer_tile(struct renderer_tile *self,
+				 struct renderer_base *parent,
+				 double x, double y, double w, double h,
+				 struct renderer_texture *texture,
+				 const struct renderer_tile_ops *ops);
 
 struct renderer_texture {
 	const struct renderer_texture_ops *ops;
 	struct renderer *renderer;
+	unsigned long int size; /* in bytes of the pixels last uploaded */
+	float u1, v1, u2, v2; /* part of the storage showing the image */
 	void *userdata;
 };
 
 struct renderer_texture_ops {
 	void (*update)(struct renderer_texture*, const struct rgba*);
+	/* optional: uploads the w x h rectangle at (x, y) of an image that has
+	 * the same size as the texture, falling back to update otherwise.
+	 */
+	void (*patch)(struct renderer_texture*, const struct rgba*,
+		      unsigned short int x, unsigned short int y,
+		      unsigned short int w, unsigned short int h);
+	/* optional: fills the texture with the w x h cells of map, cell
+	 * (x, y) showing tile map[x + y * w] of tileset, whose tiles of
+	 * tw x th pixels sit side by side. Returns -1 when this could not be
+	 * done, the caller then has to upload the pixels itself.
+	 */
+	int (*compose)(struct renderer_texture*,
+		       struct renderer_texture *tileset,
+		       const unsigned char *map,
+		       unsigned short int w, unsigned short int h,
+		       unsigned short int tw, unsigned short int th);
 	void (*dtor)(struct renderer_texture*);
 };
 
+static inline void __setup_renderer_texture(
+	struct renderer_texture *self, const struct renderer_texture_ops *ops)
+{
+	self->ops = ops;
+	self->u1 = self->v1 = 0.;
+	self->u2 = self->v2 = 1.;
+}
+
 struct renderer_observer {
 	struct b6_dref dref;
 	const struct renderer_observer_ops *ops;
@@ -140,17 +163,98 @@ struct renderer {
 	unsigned long int max_textures;
 	unsigned long int max_tiles;
 	unsigned long int max_bases;
+	unsigned long int texture_bytes;
+	unsigned long int ndraws; /* in the last frame rendered */
+	unsigned long int nrebuilds; /* of vertex buffers since started */
 	unsigned short int internal_width;
 	unsigned short int internal_height;
 	unsigned short int external_width;
 	unsigned short int external_height;
+	struct renderer_scene scene;
 };
 
+extern void initialize_renderer_scene(struct renderer_scene *self);
+
+extern void finalize_renderer_scene(struct renderer_scene *self);
+
+/* Brings the absolute position and the visibility of every base up to date,
+ * as well as the drawing order of the tiles when they came or went. Returns
+ * -1 when out of memory.
+ */
+extern int sweep_renderer_scene(struct renderer *self);
+
+/* Copies the texture coordinates of every tile from its texture again, once
+ * textures moved in their storage.
+ */
+extern void retexture_renderer_scene(struct renderer_scene *self);
+
 static inline void __setup_renderer(struct renderer *self,
 				    const struct renderer_ops *ops)
 {
 	self->ops = ops;
 	b6_list_initialize(&self->observers);
+	initialize_renderer_scene(&self->scene);
+}
+
+static inline void __finalize_renderer(struct renderer *self)
+{
+	finalize_renderer_scene(&self->scene);
+}
+
+static inline void move_renderer_base(struct renderer_base *self,
+				      double x, double y)
+{
+	struct renderer_scene *scene = &self->renderer->scene;
+	*(float*)b6_array_get(&scene->base_x, self->handle) = x;
+	*(float*)b6_array_get(&scene->base_y, self->handle) = y;
+}
+
+static inline double get_renderer_base_x(const struct renderer_base *self)
+{
+	return *(float*)b6_array_get(&self->renderer->scene.base_x,
+				     self->handle);
+}
+
+static inline double get_renderer_base_y(const struct renderer_base *self)
+{
+	return *(float*)b6_array_get(&self->renderer->scene.base_y,
+				     self->handle);
+}
+
+static inline void show_renderer_base(struct renderer_base *self)
+{
+	*(unsigned char*)b6_array_get(&self->renderer->scene.base_visible,
+				      self->handle) = 1;
+}
+
+static inline void hide_renderer_base(struct renderer_base *self)
+{
+	*(unsigned char*)b6_array_get(&self->renderer->scene.base_visible,
+				      self->handle) = 0;
+}
+
+static inline double get_renderer_tile_x(const struct renderer_tile *self)
+{
+	return *(float*)b6_array_get(&self->renderer->scene.tile_x,
+				     self->handle);
+}
+
+static inline double get_renderer_tile_y(const struct renderer_tile *self)
+{
+	return *(float*)b6_array_get(&self->renderer->scene.tile_y,
+				     self->handle);
+}
+
+static inline double get_renderer_tile_w(const struct renderer_tile *self)
+{
+	return *(float*)b6_array_get(&self->renderer->scene.tile_w,
+				     self->handle);
+}
+
+static inline double get_renderer_tile_h(const struct renderer_tile *self)
+{
+	return *(float*)b6_array_get(&self->renderer->scene.tile_h,
+				     self->handle);
 }
 
 struct renderer_ops {
@@ -191,6 +295,7 @@ static inline void start_renderer(struct renderer *self,
 	self->ntextures = self->max_textures = 0;
 	self->ntiles = self->max_tiles = 0;
 	self->nbases = self->max_bases = 0;
+	self->texture_bytes = self->ndraws = self->nrebuilds = 0;
 	self->internal_width = width;
 	self->internal_height = height;
 	if (self->ops->start)
@@ -229,7 +334,6 @@ static inline struct renderer_base *create_renderer_base(
 		log_e(_s("could not allocate base "), _s(name));
 		return NULL;
 	}
-	base->renderer = self;
 	self->nbases += 1;
 	if (self->nbases > self->max_bases)
 		self->max_bases = self->nbases;
@@ -250,18 +354,29 @@ static inline struct renderer_base *create_renderer_base_or_die(
 extern void destroy_renderer_base_tiles(struct renderer_base *self);
 extern void destroy_renderer_base_children(struct renderer_base *self);
 
+/* Rows are given back once the renderer is done with the tile or base. */
+extern void del_renderer_scene_base(struct renderer_scene *self,
+				    unsigned long int handle);
+extern void del_renderer_scene_tile(struct renderer_scene *self,
+				    unsigned long int handle);
+
 static inline void destroy_renderer_base(struct renderer_base *self)
 {
+	struct renderer *renderer;
+	unsigned long int handle;
 	if (!self)
 		return;
-	if (b6_unlikely(!self->renderer->nbases))
+	renderer = self->renderer;
+	handle = self->handle;
+	if (b6_unlikely(!renderer->nbases))
 		log_p(_s("double free"));
-	self->renderer->nbases -= 1;
+	renderer->nbases -= 1;
 	destroy_renderer_base_tiles(self);
 	destroy_renderer_base_children(self);
 	b6_list_del(&self->dref);
 	if (self->ops->dtor)
 		self->ops->dtor(self);
+	del_renderer_scene_base(&renderer->scene, handle);
 }
 
 static inline struct renderer_tile *create_renderer_tile(
@@ -275,7 +390,6 @@ static inline struct renderer_tile *create_renderer_tile(
 		      _s(parent->name));
 		return NULL;
 	}
-	tile->renderer = self;
 	self->ntiles += 1;
 	if (self->ntiles > self->max_tiles)
 		self->max_tiles = self->ntiles;
@@ -295,14 +409,19 @@ static inline struct renderer_tile *create_renderer_tile_or_die(
 
 static inline void destroy_renderer_tile(struct renderer_tile *self)
 {
+	struct renderer *renderer;
+	unsigned long int handle;
 	if (!self)
 		return;
-	if (b6_unlikely(!self->renderer->ntiles))
+	renderer = self->renderer;
+	handle = self->handle;
+	if (b6_unlikely(!renderer->ntiles))
 		log_p(_s("double free"));
-	self->renderer->ntiles -= 1;
+	renderer->ntiles -= 1;
 	b6_list_del(&self->dref);
 	if (self->ops->dtor)
 		self->ops->dtor(self);
+	del_renderer_scene_tile(&renderer->scene, handle);
 }
 
 static inline struct renderer_base *get_renderer_tile_base(
@@ -311,16 +430,35 @@ static inline struct renderer_base *get_renderer_tile_base(
 	return self->parent;
 }
 
+extern void set_renderer_scene_texture(struct renderer_scene *self,
+				       unsigned long int handle,
+				       struct renderer_texture *texture);
+
+static inline struct renderer_texture *get_renderer_tile_texture(
+	const struct renderer_tile *self)
+{
+	return *(struct renderer_texture**)b6_array_get(
+		&self->renderer->scene.tile_texture, self->handle);
+}
+
 static inline void set_renderer_tile_texture(struct renderer_tile *self,
 					     struct renderer_texture *texture)
 {
-	self->texture = texture;
+	struct renderer_texture *previous = get_renderer_tile_texture(self);
+	set_renderer_scene_texture(&self->renderer->scene, self->handle,
+				   texture);
+	if (self->ops->retexture)
+		self->ops->retexture(self, previous);
 }
 
-static inline struct renderer_texture *get_renderer_tile_texture(
-	const struct renderer_tile *self) 
+static inline void resize_renderer_tile(struct renderer_tile *self,
+					double w, double h)
 {
-	return self->texture;
+	struct renderer_scene *scene = &self->renderer->scene;
+	*(float*)b6_array_get(&scene->tile_w, self->handle) = w;
+	*(float*)b6_array_get(&scene->tile_h, self->handle) = h;
+	if (self->ops->resize)
+		self->ops->resize(self);
 }
 
 static inline struct renderer_texture *create_renderer_texture(
@@ -332,6 +470,8 @@ static inline struct renderer_texture *create_renderer_texture(
 		return NULL;
 	}
 	texture->renderer = self;
+	texture->size = rgba ? 4UL * rgba->w * rgba->h : 0;
+	self->texture_bytes += texture->size;
 	self->ntextures += 1;
 	if (self->ntextures > self->max_textures)
 		self->max_textures = self->ntextures;
@@ -350,9 +490,44 @@ static inline struct renderer_texture *create_renderer_texture_or_die(
 static inline void update_renderer_texture(struct renderer_texture *self,
 					   const struct rgba *rgba)
 {
+	self->renderer->texture_bytes -= self->size;
+	self->size = 4UL * rgba->w * rgba->h;
+	self->renderer->texture_bytes += self->size;
 	self->ops->update(self, rgba);
 }
 
+static inline void patch_renderer_texture(struct renderer_texture *self,
+					  const struct rgba *rgba,
+					  unsigned short int x,
+					  unsigned short int y,
+					  unsigned short int w,
+					  unsigned short int h)
+{
+	if (self->ops->patch)
+		self->ops->patch(self, rgba, x, y, w, h);
+	else
+		self->ops->update(self, rgba);
+}
+
+static inline int renderer_texture_can_compose(
+	const struct renderer_texture *self)
+{
+	return !!self->ops->compose;
+}
+
+static inline int compose_renderer_texture(struct renderer_texture *self,
+					   struct renderer_texture *tileset,
+					   const unsigned char *map,
+					   unsigned short int w,
+					   unsigned short int h,
+					   unsigned short int tw,
+					   unsigned short int th)
+{
+	if (!self->ops->compose)
+		return -1;
+	return self->ops->compose(self, tileset, map, w, h, tw, th);
+}
+
 static inline void destroy_renderer_texture(struct renderer_texture *self)
 {
 	if (!self)
@@ -360,9 +535,30 @@ static inline void destroy_renderer_texture(struct renderer_texture *self)
 	if (b6_unlikely(!self->renderer->ntextures))
 		log_p(_s("double free"));
 	self->renderer->ntextures -= 1;
+	self->renderer->texture_bytes -= self->size;
 	return self->ops->dtor(self);
 }
 
+/* Parked textures stay alive but are left out of the renderer counts, so
+ * that they can be kept across phases.
+ */
+static inline void park_renderer_texture(struct renderer_texture *self)
+{
+	if (b6_unlikely(!self->renderer->ntextures))
+		log_p(_s("double free"));
+	self->renderer->ntextures -= 1;
+	self->renderer->texture_bytes -= self->size;
+}
+
+static inline void unpark_renderer_texture(struct renderer_texture *self)
+{
+	struct renderer *renderer = self->renderer;
+	renderer->texture_bytes += self->size;
+	renderer->ntextures += 1;
+	if (renderer->ntextures > renderer->max_textures)
+		renderer->max_textures = renderer->ntextures;
+}
+
 static inline void dim_renderer(struct renderer *self, float value)
 {
 	if (self->ops->dim)
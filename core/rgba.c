@@ -23,8 +23,10 @@
 
 #include "b6/allocator.h"
 #include "b6/assert.h"
+#include "b6/utils.h"
 #include "lib/std.h"
 #include "lib/io.h"
+#include "rgba_kernels.h"
 
 int initialize_rgba(struct rgba *self,
 		    unsigned short int w, unsigned short int h)
@@ -51,10 +53,8 @@ void finalize_rgba(struct rgba *self)
 
 void clear_rgba(struct rgba *self, unsigned int color)
 {
-	unsigned int *p = (unsigned int*)self->p;
-	unsigned int i = self->w * self->h;
-	b6_static_assert(sizeof(*p) == 4);
-	while (i--) *p++ = color;
+	get_rgba_kernels()->clear(self->p, (unsigned long int)self->w * self->h,
+				  color);
 }
 
 static int clip_rgba(unsigned short int *x, unsigned short int *y,
@@ -92,6 +92,18 @@ static int clip_rgba(unsigned short int *x, unsigned short int *y,
 	return 1;
 }
 
+void fill_rgba(struct rgba *self,
+	       unsigned short int x, unsigned short int y,
+	       unsigned short int w, unsigned short int h, unsigned int color)
+{
+	const struct rgba_kernels *kernels = get_rgba_kernels();
+	unsigned char *p;
+	if (!clip_rgba(&x, &y, &w, &h, 0, 0, self->w, self->h))
+		return;
+	for (p = &self->p[4 * (x + y * self->w)]; h--; p += 4 * self->w)
+		kernels->clear(p, w, color);
+}
+
 static void do_copy_rgba(const struct rgba *src,
 			 unsigned short int x, unsigned short int y,
 			 unsigned short int w, unsigned short int h,
@@ -118,17 +130,57 @@ void copy_rgba(const struct rgba *src,
 		do_copy_rgba(src, x + u - p, y + v - q, w, h, dst, p, q);
 }
 
-void make_shadow_rgba(struct rgba *rgba)
+void blend_rgba(const struct rgba *src, struct rgba *dst,
+		int x, int y, int w, int h)
 {
-	unsigned int len = rgba->w * rgba->h;
-	unsigned int *ptr = (unsigned int*)rgba->p;
-	b6_static_assert(sizeof(*ptr) == 4);
-	while (len--) {
-		unsigned char a = *ptr >> 24;
-		*ptr++ = a <= 0x80 ? 0x00000000 : 0x7f1f1f1f;
+	const struct rgba_kernels *kernels = get_rgba_kernels();
+	int i, j, i1 = 0, j1 = 0, i2 = w, j2 = h;
+	if (w <= 0 || h <= 0 || !src->w || !src->h)
+		return;
+	if (x < 0)
+		i1 = -x;
+	if (y < 0)
+		j1 = -y;
+	if (x + i2 > dst->w)
+		i2 = dst->w - x;
+	if (y + j2 > dst->h)
+		j2 = dst->h - y;
+	if (i1 >= i2 || j1 >= j2)
+		return;
+	for (j = j1; j < j2; j += 1) {
+		const unsigned char *s = &src->p[4 * (j * src->h / h) * src->w];
+		unsigned char *d = &dst->p[4 * ((y + j) * dst->w + x + i1)];
+		if (w == src->w) {
+			kernels->blend(d, &s[4 * i1], i2 - i1);
+			continue;
+		}
+		for (i = i1; i < i2; i += 1, d += 4) {
+			const unsigned char *t = &s[4 * (i * src->w / w)];
+			unsigned int a = t[3], b = 255 - a;
+			if (!a)
+				continue;
+			d[0] = (t[0] * a + d[0] * b + 127) / 255;
+			d[1] = (t[1] * a + d[1] * b + 127) / 255;
+			d[2] = (t[2] * a + d[2] * b + 127) / 255;
+			d[3] = (a * a + d[3] * b + 127) / 255;
+		}
 	}
 }
 
+void dim_rgba(struct rgba *self, unsigned char level)
+{
+	if (level == 255)
+		return;
+	get_rgba_kernels()->dim(self->p, (unsigned long int)self->w * self->h,
+				level);
+}
+
+void make_shadow_rgba(struct rgba *rgba)
+{
+	get_rgba_kernels()->shadow(rgba->p,
+				   (unsigned long int)rgba->w * rgba->h);
+}
+
 struct tga_header {
 	/* length of a string located after the header */
 	unsigned char id_length;
@@ -194,7 +246,6 @@ struct tga_to_rgba {
 	struct tga_header header;
 	unsigned char r, g, b, a;
 	unsigned char *p;
-	unsigned char get_count;
 	unsigned short int put_count;
 	unsigned char r_palette[256];
 	unsigned char g_palette[256];
@@ -202,25 +253,6 @@ struct tga_to_rgba {
 	unsigned char a_palette[256];
 };
 
-static int get_tga_10(struct tga_to_rgba *self,
-		      int (*get_tga)(struct tga_to_rgba*),
-		      int (*get_raw)(struct tga_to_rgba*),
-		      int (*get_rle)(struct tga_to_rgba*))
-{
-	char rle;
-	if (!read_istream(self->istream, &rle, sizeof(rle)))
-		return -1;
-	if (rle & 0x80) {
-		int retval = get_tga(self);
-		if (retval)
-			return retval;
-		self->get = get_rle;
-	} else
-		self->get = get_raw;
-	self->get_count = rle & 0x7f;
-	return self->get(self);
-}
-
 static int get_tga_1(struct tga_to_rgba *self)
 {
 	unsigned char index;
@@ -236,71 +268,6 @@ static int get_tga_1(struct tga_to_rgba *self)
 	return 0;
 }
 
-static int get_tga_2_24(struct tga_to_rgba *self)
-{
-	unsigned char pixel[3];
-	if (!read_istream(self->istream, pixel, sizeof(pixel)))
-		return -1;
-	self->r = pixel[2];
-	self->g = pixel[1];
-	self->b = pixel[0];
-	return 0;
-}
-
-static int get_tga_10_24(struct tga_to_rgba*);
-
-static int get_tga_10_24_rle(struct tga_to_rgba *self)
-{
-	if (!self->get_count--)
-		self->get = get_tga_10_24;
-	return 0;
-}
-
-static int get_tga_10_24_raw(struct tga_to_rgba *self)
-{
-	int retval = get_tga_2_24(self);
-	return retval ? retval : get_tga_10_24_rle(self);
-}
-
-static int get_tga_10_24(struct tga_to_rgba *self)
-{
-	return get_tga_10(self, get_tga_2_24, get_tga_10_24_raw,
-			  get_tga_10_24_rle);
-}
-
-static int get_tga_2_32(struct tga_to_rgba *self)
-{
-	unsigned char pixel[4];
-	if (!read_istream(self->istream, pixel, sizeof(pixel)))
-		return -1;
-	self->r = pixel[2];
-	self->g = pixel[1];
-	self->b = pixel[0];
-	self->a = pixel[3];
-	return 0;
-}
-
-static int get_tga_10_32(struct tga_to_rgba*);
-
-static int get_tga_10_32_rle(struct tga_to_rgba *self)
-{
-	if (!self->get_count--)
-		self->get = get_tga_10_32;
-	return 0;
-}
-
-static int get_tga_10_32_raw(struct tga_to_rgba *self)
-{
-	int retval = get_tga_2_32(self);
-	return retval ? retval : get_tga_10_32_rle(self);
-}
-
-static int get_tga_10_32(struct tga_to_rgba *self)
-{
-	return get_tga_10(self, get_tga_2_32, get_tga_10_32_raw,
-			  get_tga_10_32_rle);
-}
-
 static void put_tga_upper_left(struct tga_to_rgba *self)
 {
 	*self->p++ = self->r;
@@ -383,6 +350,120 @@ static int write_tga_header(const struct tga_header *h, struct ostream *s)
 	return 0;
 }
 
+/* True color images, uncompressed or RLE, are read at once and decoded in
+ * memory in file order, rows being flipped afterwards when stored bottom up.
+ * Color mapped images are decoded pixel per pixel by the generic path.
+ */
+static void convert_tga_pixels(unsigned char *d, const unsigned char *s,
+			       unsigned long int n, unsigned int depth)
+{
+	if (depth == 4)
+		for (; n--; d += 4, s += 4) {
+			unsigned char b = s[0], g = s[1], r = s[2], a = s[3];
+			d[0] = r;
+			d[1] = g;
+			d[2] = b;
+			d[3] = a;
+		}
+	else
+		for (; n--; d += 4, s += 3) {
+			unsigned char b = s[0], g = s[1], r = s[2];
+			d[0] = r;
+			d[1] = g;
+			d[2] = b;
+			d[3] = 255;
+		}
+}
+
+static int decode_tga_rle(unsigned char *d, unsigned long int n,
+			  unsigned int depth,
+			  const unsigned char *s, unsigned long int len)
+{
+	const unsigned char *end = s + len;
+	while (n) {
+		unsigned long int count;
+		int rle;
+		if (s == end)
+			return -1;
+		rle = *s & 0x80;
+		count = (*s++ & 0x7f) + 1;
+		if (count > n)
+			count = n;
+		n -= count;
+		if (rle) {
+			unsigned int pixel;
+			if ((unsigned long int)(end - s) < depth)
+				return -1;
+			convert_tga_pixels((unsigned char*)&pixel, s, 1, depth);
+			s += depth;
+			for (; count--; d += 4)
+				memcpy(d, &pixel, 4);
+		} else {
+			if ((unsigned long int)(end - s) < count * depth)
+				return -1;
+			convert_tga_pixels(d, s, count, depth);
+			s += count * depth;
+			d += count * 4;
+		}
+	}
+	return 0;
+}
+
+static void flip_rgba(struct rgba *self)
+{
+	unsigned int *p = (unsigned int*)self->p, *q;
+	b6_static_assert(sizeof(*p) == 4);
+	if (self->h < 2)
+		return;
+	q = p + (unsigned long int)self->w * (self->h - 1);
+	for (; p < q; q -= 2 * self->w) {
+		unsigned short int i;
+		for (i = 0; i < self->w; i += 1, p += 1, q += 1) {
+			unsigned int t = *p;
+			*p = *q;
+			*q = t;
+		}
+	}
+}
+
+static int read_tga_true_color(struct rgba *rgba,
+			       const struct tga_header *header,
+			       struct istream *istream)
+{
+	unsigned long int n = (unsigned long int)rgba->w * rgba->h;
+	unsigned int depth = header->bits_per_pixel / 8;
+	unsigned long int len = n * depth;
+	unsigned char *buf;
+	long long int size;
+	int retval;
+	if (header->data_type_code == 2 && depth == 4) {
+		/* pixels are converted in place */
+		if (read_istream(istream, rgba->p, len) < len)
+			return -1;
+		convert_tga_pixels(rgba->p, rgba->p, n, depth);
+		retval = 0;
+	} else {
+		if (header->data_type_code == 10)
+			len += n; /* a packet per pixel at worst */
+		if (!(buf = b6_allocate(&b6_std_allocator, len)))
+			return -1;
+		size = read_istream(istream, buf, len);
+		if (header->data_type_code == 10)
+			retval = decode_tga_rle(rgba->p, n, depth, buf,
+						size < 0 ? 0 : size);
+		else if (size < len)
+			retval = -1;
+		else {
+			convert_tga_pixels(rgba->p, buf, n, depth);
+			retval = 0;
+		}
+		b6_deallocate(&b6_std_allocator, buf);
+	}
+	if (!retval && !(header->image_descriptor & 32))
+		flip_rgba(rgba);
+	return retval;
+}
+
 int initialize_rgba_from_tga(struct rgba *rgba, struct istream *istream)
 {
 	struct tga_to_rgba tga_to_rgba;
@@ -391,24 +472,17 @@ int initialize_rgba_from_tga(struct rgba *rgba, struct istream *istream)
 	if (read_tga_header(header, istream))
 		return -1;
 	switch (header->data_type_code) {
-	case 1:
+	case 1: /* decoded pixel per pixel */
 		tga_to_rgba.get = get_tga_1;
 		if (header->bits_per_pixel != 8)
 			return -2;
 		break;
 	case 2:
-		switch (header->bits_per_pixel) {
-		case 24: tga_to_rgba.get = get_tga_2_24; break;
-		case 32: tga_to_rgba.get = get_tga_2_32; break;
-		default: return -2;
-		}
-		break;
-	case 10:
-		switch (header->bits_per_pixel) {
-		case 24: tga_to_rgba.get = get_tga_10_24; break;
-		case 32: tga_to_rgba.get = get_tga_10_32; break;
-		default: return -2;
-		}
+	case 10: /* decoded in bulk by read_tga_true_color */
+		tga_to_rgba.get = NULL;
+		if (header->bits_per_pixel != 24 &&
+		    header->bits_per_pixel != 32)
+			return -2;
 		break;
 	default:
 		return -2;
@@ -453,6 +527,14 @@ int initialize_rgba_from_tga(struct rgba *rgba, struct istream *istream)
 		default: return -2;
 		}
 	}
+	if (!tga_to_rgba.get) {
+		int retval;
+		if (initialize_rgba(rgba, header->width, header->height))
+			return -1;
+		if ((retval = read_tga_true_color(rgba, header, istream)))
+			finalize_rgba(rgba);
+		return retval;
+	}
 	initialize_rgba(rgba, header->width, header->height);
 	tga_to_rgba.r = tga_to_rgba.g = tga_to_rgba.b = tga_to_rgba.a = 255;
 	if (header->image_descriptor & 32) {
@@ -498,13 +580,21 @@ int write_rgba_as_tga(const struct rgba *rgba, struct ostream *ostream)
 		return -1;
 	b6_static_assert(sizeof(*ptr) == 4);
 	b6_static_assert(sizeof(i) >= sizeof(rgba->w) + sizeof(rgba->h));
-	for (i = rgba->w * rgba->h, ptr = (unsigned int*)rgba->p; i--; ptr++) {
-		unsigned int abgr = (*ptr & 0xff00ff00) |
-			((*ptr & 0x000000ff) << 16) |
-			((*ptr & 0x00ff0000) >> 16);
-		b6_static_assert(sizeof(*ptr) == sizeof(abgr));
-		if (write_ostream(ostream, &abgr, sizeof(abgr)) < sizeof(abgr))
+	i = rgba->w * rgba->h;
+	ptr = (unsigned int*)rgba->p;
+	while (i) {
+		/* pixels are converted and written by blocks */
+		unsigned int abgr[256];
+		unsigned int j, n = i < b6_card_of(abgr) ? i : b6_card_of(abgr);
+		b6_static_assert(sizeof(*ptr) == sizeof(*abgr));
+		for (j = 0; j < n; j += 1, ptr++)
+			abgr[j] = (*ptr & 0xff00ff00) |
+				((*ptr & 0x000000ff) << 16) |
+				((*ptr & 0x00ff0000) >> 16);
+		if (write_ostream(ostream, abgr, n * sizeof(*abgr)) <
+		    n * sizeof(*abgr))
 			return -1;
+		i -= n;
 	}
 	return 0;
 }
@@ -41,6 +41,12 @@ extern void finalize_rgba(struct rgba *self);
 
 extern void clear_rgba(struct rgba *self, unsigned int color);
 
+/* clipped fill of a sub-rectangle. */
+extern void fill_rgba(struct rgba *self,
+		      unsigned short int x, unsigned short int y,
+		      unsigned short int w, unsigned short int h,
+		      unsigned int color);
+
 extern int write_rgba_as_tga(const struct rgba *rgba, struct ostream *ostream);
 
 /* clipped blit without overlap test. */
@@ -50,6 +56,15 @@ extern void copy_rgba(const struct rgba *from,
 		      struct rgba *to,
 		      unsigned short int u, unsigned short int v);
 
+/* alpha blends src stretched to w x h at (x, y) in dst, with nearest
+ * sampling and clipping.
+ */
+extern void blend_rgba(const struct rgba *src, struct rgba *dst,
+		       int x, int y, int w, int h);
+
+/* scales color channels by level / 255. */
+extern void dim_rgba(struct rgba *self, unsigned char level);
+
 extern void make_shadow_rgba(struct rgba *rgba);
 
 #endif /* RGBA_H */
@@ -0,0 +1,356 @@
+/*
+ * Open Greedy - an open-source version of Edromel Studio's Greedy XP
+ *
+ * Copyright (C) 2014-2017 Arnaud TROEL
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "rgba_kernels.h"
+
+#include "b6/utils.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define RGBA_AVX2 1
+#endif
+#if defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+static void clear_portable(unsigned char *p, unsigned long int n,
+			   unsigned int color)
+{
+	unsigned int *q = (unsigned int*)p;
+	b6_static_assert(sizeof(*q) == 4);
+	while (n--)
+		*q++ = color;
+}
+
+static void shadow_portable(unsigned char *p, unsigned long int n)
+{
+	unsigned int *q = (unsigned int*)p;
+	while (n--) {
+		unsigned char a = *q >> 24;
+		*q++ = a <= 0x80 ? 0x00000000 : 0x7f1f1f1f;
+	}
+}
+
+static void dim_portable(unsigned char *p, unsigned long int n,
+			 unsigned char level)
+{
+	for (; n--; p += 4) {
+		p[0] = (p[0] * level + 127) / 255;
+		p[1] = (p[1] * level + 127) / 255;
+		p[2] = (p[2] * level + 127) / 255;
+	}
+}
+
+static void blend_portable(unsigned char *d, const unsigned char *s,
+			   unsigned long int n)
+{
+	for (; n--; d += 4, s += 4) {
+		unsigned int a = s[3], b = 255 - a;
+		if (!a)
+			continue;
+		d[0] = (s[0] * a + d[0] * b + 127) / 255;
+		d[1] = (s[1] * a + d[1] * b + 127) / 255;
+		d[2] = (s[2] * a + d[2] * b + 127) / 255;
+		d[3] = (a * a + d[3] * b + 127) / 255;
+	}
+}
+
+const struct rgba_kernels portable_rgba_kernels = {
+	.name = "portable",
+	.clear = clear_portable,
+	.shadow = shadow_portable,
+	.dim = dim_portable,
+	.blend = blend_portable,
+};
+
+/* SIMD versions divide by 255 with (v + 128 + ((v + 128) >> 8)) >> 8, which
+ * equals (v + 127) / 255 for any v up to 255 * 255. Blending a transparent
+ * pixel then leaves the destination as is, and dimming alpha by 255 / 255
+ * too: neither needs a test of its own.
+ */
+
+#if defined(__SSE2__)
+static __m128i div255_sse2(__m128i v)
+{
+	v = _mm_add_epi16(v, _mm_set1_epi16(128));
+	return _mm_srli_epi16(_mm_add_epi16(v, _mm_srli_epi16(v, 8)), 8);
+}
+
+static void clear_sse2(unsigned char *p, unsigned long int n,
+		       unsigned int color)
+{
+	const __m128i c = _mm_set1_epi32(color);
+	for (; n >= 4; n -= 4, p += 16)
+		_mm_storeu_si128((__m128i*)p, c);
+	clear_portable(p, n, color);
+}
+
+static void shadow_sse2(unsigned char *p, unsigned long int n)
+{
+	const __m128i k = _mm_set1_epi32(0x7f1f1f1f);
+	const __m128i t = _mm_set1_epi32(0x80);
+	for (; n >= 4; n -= 4, p += 16) {
+		__m128i v = _mm_loadu_si128((const __m128i*)p);
+		v = _mm_cmpgt_epi32(_mm_srli_epi32(v, 24), t);
+		_mm_storeu_si128((__m128i*)p, _mm_and_si128(v, k));
+	}
+	shadow_portable(p, n);
+}
+
+static void dim_sse2(unsigned char *p, unsigned long int n,
+		     unsigned char level)
+{
+	const __m128i z = _mm_setzero_si128();
+	const __m128i l = _mm_set_epi16(255, level, level, level,
+					255, level, level, level);
+	for (; n >= 4; n -= 4, p += 16) {
+		__m128i v = _mm_loadu_si128((const __m128i*)p);
+		__m128i lo = _mm_mullo_epi16(_mm_unpacklo_epi8(v, z), l);
+		__m128i hi = _mm_mullo_epi16(_mm_unpackhi_epi8(v, z), l);
+		v = _mm_packus_epi16(div255_sse2(lo), div255_sse2(hi));
+		_mm_storeu_si128((__m128i*)p, v);
+	}
+	dim_portable(p, n, level);
+}
+
+static __m128i blend_sse2_half(__m128i s, __m128i d)
+{
+	__m128i a = _mm_shufflehi_epi16(_mm_shufflelo_epi16(s, 0xff), 0xff);
+	__m128i b = _mm_sub_epi16(_mm_set1_epi16(255), a);
+	return div255_sse2(_mm_add_epi16(_mm_mullo_epi16(s, a),
+					 _mm_mullo_epi16(d, b)));
+}
+
+static void blend_sse2(unsigned char *d, const unsigned char *s,
+		       unsigned long int n)
+{
+	const __m128i z = _mm_setzero_si128();
+	for (; n >= 4; n -= 4, d += 16, s += 16) {
+		__m128i u = _mm_loadu_si128((const __m128i*)s);
+		__m128i v = _mm_loadu_si128((const __m128i*)d);
+		__m128i lo = blend_sse2_half(_mm_unpacklo_epi8(u, z),
+					     _mm_unpacklo_epi8(v, z));
+		__m128i hi = blend_sse2_half(_mm_unpackhi_epi8(u, z),
+					     _mm_unpackhi_epi8(v, z));
+		_mm_storeu_si128((__m128i*)d, _mm_packus_epi16(lo, hi));
+	}
+	blend_portable(d, s, n);
+}
+
+static const struct rgba_kernels sse2_rgba_kernels = {
+	.name = "sse2",
+	.clear = clear_sse2,
+	.shadow = shadow_sse2,
+	.dim = dim_sse2,
+	.blend = blend_sse2,
+};
+#endif
+
+#if defined(RGBA_AVX2)
+#define avx2_target __attribute__((target("avx2")))
+
+static avx2_target __m256i div255_avx2(__m256i v)
+{
+	v = _mm256_add_epi16(v, _mm256_set1_epi16(128));
+	return _mm256_srli_epi16(_mm256_add_epi16(v, _mm256_srli_epi16(v, 8)),
+				 8);
+}
+
+static avx2_target void clear_avx2(unsigned char *p, unsigned long int n,
+			      unsigned int color)
+{
+	const __m256i c = _mm256_set1_epi32(color);
+	for (; n >= 8; n -= 8, p += 32)
+		_mm256_storeu_si256((__m256i*)p, c);
+	clear_portable(p, n, color);
+}
+
+static avx2_target void shadow_avx2(unsigned char *p, unsigned long int n)
+{
+	const __m256i k = _mm256_set1_epi32(0x7f1f1f1f);
+	const __m256i t = _mm256_set1_epi32(0x80);
+	for (; n >= 8; n -= 8, p += 32) {
+		__m256i v = _mm256_loadu_si256((const __m256i*)p);
+		v = _mm256_cmpgt_epi32(_mm256_srli_epi32(v, 24), t);
+		_mm256_storeu_si256((__m256i*)p, _mm256_and_si256(v, k));
+	}
+	shadow_portable(p, n);
+}
+
+/* unpacking and packing work within 128-bit lanes, so pixels stay in place */
+static avx2_target void dim_avx2(unsigned char *p, unsigned long int n,
+			    unsigned char level)
+{
+	const __m256i z = _mm256_setzero_si256();
+	const __m256i l = _mm256_set_epi16(255, level, level, level,
+					   255, level, level, level,
+					   255, level, level, level,
+					   255, level, level, level);
+	for (; n >= 8; n -= 8, p += 32) {
+		__m256i v = _mm256_loadu_si256((const __m256i*)p);
+		__m256i lo = _mm256_mullo_epi16(_mm256_unpacklo_epi8(v, z), l);
+		__m256i hi = _mm256_mullo_epi16(_mm256_unpackhi_epi8(v, z), l);
+		v = _mm256_packus_epi16(div255_avx2(lo), div255_avx2(hi));
+		_mm256_storeu_si256((__m256i*)p, v);
+	}
+	dim_portable(p, n, level);
+}
+
+static avx2_target __m256i blend_avx2_half(__m256i s, __m256i d)
+{
+	__m256i a = _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(s, 0xff),
+					   0xff);
+	__m256i b = _mm256_sub_epi16(_mm256_set1_epi16(255), a);
+	return div255_avx2(_mm256_add_epi16(_mm256_mullo_epi16(s, a),
+					    _mm256_mullo_epi16(d, b)));
+}
+
+static avx2_target void blend_avx2(unsigned char *d, const unsigned char *s,
+			      unsigned long int n)
+{
+	const __m256i z = _mm256_setzero_si256();
+	for (; n >= 8; n -= 8, d += 32, s += 32) {
+		__m256i u = _mm256_loadu_si256((const __m256i*)s);
+		__m256i v = _mm256_loadu_si256((const __m256i*)d);
+		__m256i lo = blend_avx2_half(_mm256_unpacklo_epi8(u, z),
+					     _mm256_unpacklo_epi8(v, z));
+		__m256i hi = blend_avx2_half(_mm256_unpackhi_epi8(u, z),
+					     _mm256_unpackhi_epi8(v, z));
+		_mm256_storeu_si256((__m256i*)d, _mm256_packus_epi16(lo, hi));
+	}
+	blend_portable(d, s, n);
+}
+
+static const struct rgba_kernels avx2_rgba_kernels = {
+	.name = "avx2",
+	.clear = clear_avx2,
+	.shadow = shadow_avx2,
+	.dim = dim_avx2,
+	.blend = blend_avx2,
+};
+#endif
+
+#if defined(__ARM_NEON)
+static uint8x8_t div255_neon(uint16x8_t v)
+{
+	return vrshrn_n_u16(vrsraq_n_u16(v, v, 8), 8);
+}
+
+static void clear_neon(unsigned char *p, unsigned long int n,
+		       unsigned int color)
+{
+	const uint32x4_t c = vdupq_n_u32(color);
+	for (; n >= 4; n -= 4, p += 16)
+		vst1q_u32((uint32_t*)p, c);
+	clear_portable(p, n, color);
+}
+
+static void shadow_neon(unsigned char *p, unsigned long int n)
+{
+	const uint32x4_t k = vdupq_n_u32(0x7f1f1f1f);
+	const uint32x4_t t = vdupq_n_u32(0x80);
+	for (; n >= 4; n -= 4, p += 16) {
+		uint32x4_t v = vld1q_u32((const uint32_t*)p);
+		v = vcgtq_u32(vshrq_n_u32(v, 24), t);
+		vst1q_u32((uint32_t*)p, vandq_u32(v, k));
+	}
+	shadow_portable(p, n);
+}
+
+static uint8x16_t scale_neon(uint8x16_t x, uint8x16_t a,
+			     uint8x16_t y, uint8x16_t b)
+{
+	uint16x8_t lo = vmull_u8(vget_low_u8(x), vget_low_u8(a));
+	uint16x8_t hi = vmull_u8(vget_high_u8(x), vget_high_u8(a));
+	lo = vmlal_u8(lo, vget_low_u8(y), vget_low_u8(b));
+	hi = vmlal_u8(hi, vget_high_u8(y), vget_high_u8(b));
+	return vcombine_u8(div255_neon(lo), div255_neon(hi));
+}
+
+/* channels are loaded in planes of 16 pixels */
+static void dim_neon(unsigned char *p, unsigned long int n,
+		     unsigned char level)
+{
+	const uint8x16_t l = vdupq_n_u8(level), z = vdupq_n_u8(0);
+	for (; n >= 16; n -= 16, p += 64) {
+		uint8x16x4_t v = vld4q_u8(p);
+		v.val[0] = scale_neon(v.val[0], l, z, z);
+		v.val[1] = scale_neon(v.val[1], l, z, z);
+		v.val[2] = scale_neon(v.val[2], l, z, z);
+		vst4q_u8(p, v);
+	}
+	dim_portable(p, n, level);
+}
+
+static void blend_neon(unsigned char *d, const unsigned char *s,
+		       unsigned long int n)
+{
+	for (; n >= 16; n -= 16, d += 64, s += 64) {
+		uint8x16x4_t u = vld4q_u8(s), v = vld4q_u8(d);
+		uint8x16_t a = u.val[3], b = vmvnq_u8(a);
+		v.val[0] = scale_neon(u.val[0], a, v.val[0], b);
+		v.val[1] = scale_neon(u.val[1], a, v.val[1], b);
+		v.val[2] = scale_neon(u.val[2], a, v.val[2], b);
+		v.val[3] = scale_neon(u.val[3], a, v.val[3], b);
+		vst4q_u8(d, v);
+	}
+	blend_portable(d, s, n);
+}
+
+static const struct rgba_kernels neon_rgba_kernels = {
+	.name = "neon",
+	.clear = clear_neon,
+	.shadow = shadow_neon,
+	.dim = dim_neon,
+	.blend = blend_neon,
+};
+#endif
+
+int get_supported_rgba_kernels(
+	const struct rgba_kernels *kernels[RGBA_KERNELS_MAX])
+{
+	int n = 0;
+#if defined(RGBA_AVX2)
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx2"))
+		kernels[n++] = &avx2_rgba_kernels;
+#endif
+#if defined(__SSE2__)
+	kernels[n++] = &sse2_rgba_kernels;
+#endif
+#if defined(__ARM_NEON)
+	kernels[n++] = &neon_rgba_kernels;
+#endif
+	kernels[n++] = &portable_rgba_kernels;
+	return n;
+}
+
+const struct rgba_kernels *get_rgba_kernels(void)
+{
+	static const struct rgba_kernels *kernels = NULL;
+	if (b6_unlikely(!kernels)) {
+		const struct rgba_kernels *supported[RGBA_KERNELS_MAX];
+		get_supported_rgba_kernels(supported);
+		kernels = supported[0];
+	}
+	return kernels;
+}
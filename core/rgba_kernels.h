@@ -0,0 +1,53 @@
+/*
+ * Open Greedy - an open-source version of Edromel Studio's Greedy XP
+ *
+ * Copyright (C) 2014-2017 Arnaud TROEL
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef RGBA_KERNELS_H
+#define RGBA_KERNELS_H
+
+/* Pixel loops of rgba.c over runs of n pixels. The portable version is the
+ * reference that SIMD versions have to match bit for bit.
+ */
+struct rgba_kernels {
+	const char *name;
+	void (*clear)(unsigned char *p, unsigned long int n,
+		      unsigned int color);
+	/* alpha above 0x80 becomes a translucent dark gray, else cleared */
+	void (*shadow)(unsigned char *p, unsigned long int n);
+	/* scales color channels by level / 255 */
+	void (*dim)(unsigned char *p, unsigned long int n,
+		    unsigned char level);
+	/* alpha blends s over d */
+	void (*blend)(unsigned char *d, const unsigned char *s,
+		      unsigned long int n);
+};
+
+extern const struct rgba_kernels portable_rgba_kernels;
+
+#define RGBA_KERNELS_MAX 4
+
+/* Fills kernels with all the versions the processor supports, fastest first
+ * and portable last, and returns how many there are.
+ */
+extern int get_supported_rgba_kernels(
+	const struct rgba_kernels *kernels[RGBA_KERNELS_MAX]);
+
+/* Returns the fastest kernels the processor supports. */
+extern const struct rgba_kernels *get_rgba_kernels(void);
+
+#endif /* RGBA_KERNELS_H */
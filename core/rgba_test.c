@@ -0,0 +1,159 @@
+/*
+ * Open Greedy - an open-source version of Edromel Studio's Greedy XP
+ *
+ * Copyright (C) 2014-2017 Arnaud TROEL
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "rgba_kernels.h"
+
+#include "b6/extra/test.h"
+#include "b6/cmdline.h"
+
+#define MAX_RUN 300 /* pixels, enough to cover all vector widths and tails */
+
+static unsigned char ref[4 * MAX_RUN], out[4 * MAX_RUN], src[4 * MAX_RUN];
+
+static void randomize(unsigned char *p, unsigned long int n)
+{
+	while (n--)
+		*p++ = rand();
+}
+
+/* Both kernels start from the same pixels, with both extremes of alpha. */
+static void reset(unsigned long int n)
+{
+	unsigned long int i;
+	randomize(ref, 4 * n);
+	randomize(src, 4 * n);
+	for (i = 0; i < n; i += 3)
+		src[4 * i + 3] = i & 1 ? 0 : 255;
+	memcpy(out, ref, 4 * n);
+}
+
+/* SIMD versions the processor supports, portable excluded */
+static const struct rgba_kernels *simd[RGBA_KERNELS_MAX];
+static int nsimd;
+
+static void exact_kernels(const struct rgba_kernels *k)
+{
+	const struct rgba_kernels *p = &portable_rgba_kernels;
+	unsigned long int n;
+	int level;
+	printf("testing %s kernels\n", k->name);
+	for (n = 0; n <= MAX_RUN; n += 1) {
+		reset(n);
+		p->clear(ref, n, 0x80402010);
+		k->clear(out, n, 0x80402010);
+		b6_expect(!memcmp(ref, out, 4 * n));
+		reset(n);
+		p->shadow(ref, n);
+		k->shadow(out, n);
+		b6_expect(!memcmp(ref, out, 4 * n));
+		reset(n);
+		p->blend(ref, src, n);
+		k->blend(out, src, n);
+		b6_expect(!memcmp(ref, out, 4 * n));
+		for (level = 0; level < 256; level += 1) {
+			reset(n);
+			p->dim(ref, n, level);
+			k->dim(out, n, level);
+			b6_expect(!memcmp(ref, out, 4 * n));
+		}
+	}
+}
+
+static void exact()
+{
+	int i;
+	for (i = 0; i < nsimd; i += 1)
+		exact_kernels(simd[i]);
+}
+b6_test(exact);
+
+/* Every source value is blended with every destination value at every alpha:
+ * a run has a pixel per destination value.
+ */
+static void blend_kernels(const struct rgba_kernels *k)
+{
+	int a, s, d;
+	for (a = 0; a < 256; a += 1)
+		for (s = 0; s < 256; s += 1) {
+			for (d = 0; d < 256; d += 1) {
+				src[4 * d + 0] = s;
+				src[4 * d + 1] = 255 - s;
+				src[4 * d + 2] = s ^ d;
+				src[4 * d + 3] = a;
+				ref[4 * d + 0] = ref[4 * d + 3] = d;
+				ref[4 * d + 1] = ref[4 * d + 2] = 255 - d;
+			}
+			memcpy(out, ref, 4 * 256);
+			portable_rgba_kernels.blend(ref, src, 256);
+			k->blend(out, src, 256);
+			b6_expect(!memcmp(ref, out, 4 * 256));
+		}
+}
+
+static void blend()
+{
+	int i;
+	for (i = 0; i < nsimd; i += 1)
+		blend_kernels(simd[i]);
+}
+b6_test(blend);
+
+static double measure(const struct rgba_kernels *k, unsigned char *frame,
+		      const unsigned char *sprite, unsigned long int n)
+{
+	clock_t t = clock();
+	int i;
+	for (i = 0; i < 100; i += 1) {
+		k->blend(frame, sprite, n);
+		k->dim(frame, n, 200);
+		k->shadow(frame, n);
+		k->clear(frame, n, 0xff000000);
+	}
+	return (double)(clock() - t) / CLOCKS_PER_SEC;
+}
+
+static void throughput()
+{
+	const unsigned long int n = 640 * 480;
+	unsigned char *frame = malloc(4 * n), *sprite = malloc(4 * n);
+	int i;
+	b6_check(frame && sprite);
+	randomize(sprite, 4 * n);
+	printf("640x480 x 100: portable %.3fs",
+	       measure(&portable_rgba_kernels, frame, sprite, n));
+	for (i = 0; i < nsimd; i += 1)
+		printf(", %s %.3fs", simd[i]->name,
+		       measure(simd[i], frame, sprite, n));
+	printf("\n");
+	free(sprite);
+	free(frame);
+}
+b6_test(throughput);
+
+int main(int argc, char *argv[])
+{
+	b6_flag_parse_command_line(argc, argv, 1);
+	nsimd = get_supported_rgba_kernels(simd) - 1;
+	return b6_test_run_all(argv[0]);
+}
@@ -0,0 +1,153 @@
+/*
+ * Open Greedy - an open-source version of Edromel Studio's Greedy XP
+ *
+ * Copyright (C) 2014-2017 Arnaud TROEL
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <b6/clock.h>
+#include <b6/cmdline.h>
+#include <b6/utf8.h>
+#include <stdio.h>
+
+#include "console.h"
+#include "controller.h"
+#include "soft_renderer.h"
+#include "lib/init.h"
+#include "lib/io.h"
+#include "lib/log.h"
+#include "lib/std.h"
+
+/* Frames are written as <prefix>NNNNNN.tga when a prefix is given. */
+static const char *soft_dump = NULL;
+b6_flag(soft_dump, string);
+
+static unsigned int soft_dump_period = 1;
+b6_flag(soft_dump_period, uint);
+
+/* Quits after that many frames when not zero. */
+static unsigned int soft_frames = 0;
+b6_flag(soft_frames, uint);
+
+/* The soft clock only moves forward a fixed step per frame and when waited
+ * for, so that runs do not depend on the speed of the host.
+ */
+static unsigned int soft_fps = 60;
+b6_flag(soft_fps, uint);
+
+static unsigned long long int soft_time = 0;
+
+static unsigned long long int get_soft_clock_time(const struct b6_clock *up)
+{
+	return soft_time;
+}
+
+static void wait_soft_clock(const struct b6_clock *up,
+			    unsigned long long int delay_us)
+{
+	soft_time += delay_us;
+}
+
+b6_ctor(register_soft_clock);
+void register_soft_clock(void)
+{
+	static const struct b6_clock_ops soft_clock_ops = {
+		.get_time = get_soft_clock_time,
+		.wait = wait_soft_clock,
+	};
+	static struct b6_clock soft_clock = { .ops = &soft_clock_ops, };
+	static struct b6_named_clock soft_named_clock = {
+		.clock = &soft_clock,
+	};
+	b6_register_named_clock(&soft_named_clock, B6_UTF8("soft"));
+}
+
+struct soft_console {
+	struct console up;
+	struct controller controller;
+	struct soft_renderer soft_renderer;
+	unsigned long int frames;
+};
+
+static void dump_soft_frame(struct soft_console *self)
+{
+	const struct rgba *frame =
+		get_soft_renderer_frame(&self->soft_renderer);
+	struct ofstream ofs;
+	char path[512];
+	if (!frame)
+		return;
+	snprintf(path, sizeof(path), "%s%06lu.tga", soft_dump, self->frames);
+	if (initialize_ofstream(&ofs, path)) {
+		log_e(_s("cannot open "), _s(path));
+		return;
+	}
+	if (write_rgba_as_tga(frame, &ofs.ostream))
+		log_e(_s("cannot write "), _s(path));
+	finalize_ofstream(&ofs);
+}
+
+static int soft_console_open(struct console *up)
+{
+	struct soft_console *self = b6_cast_of(up, struct soft_console, up);
+	int retval;
+	if ((retval = open_soft_renderer(&self->soft_renderer)))
+		return retval;
+	up->default_renderer = &self->soft_renderer.renderer;
+	resize_renderer(up->default_renderer, get_console_width(),
+			get_console_height());
+	up->default_controller = setup_controller(&self->controller);
+	self->frames = 0;
+	return 0;
+}
+
+static void soft_console_poll(struct console *up)
+{
+	struct soft_console *self = b6_cast_of(up, struct soft_console, up);
+	if (soft_frames && self->frames >= soft_frames)
+		__notify_controller_quit(up->default_controller);
+}
+
+static void soft_console_show(struct console *up)
+{
+	struct soft_console *self = b6_cast_of(up, struct soft_console, up);
+	show_renderer(up->default_renderer);
+	if (soft_dump && soft_dump_period &&
+	    !(self->frames % soft_dump_period))
+		dump_soft_frame(self);
+	self->frames += 1;
+	if (soft_fps)
+		soft_time += 1000000 / soft_fps;
+}
+
+static void soft_console_close(struct console *up)
+{
+	struct soft_console *self = b6_cast_of(up, struct soft_console, up);
+	close_soft_renderer(&self->soft_renderer);
+	logf_i("rendered %lu frames", self->frames);
+}
+
+static int soft_console_register(void)
+{
+	static const struct console_ops ops = {
+		.open = soft_console_open,
+		.poll = soft_console_poll,
+		.show = soft_console_show,
+		.close = soft_console_close,
+	};
+	static struct soft_console instance = { .up = { .ops = &ops, }, };
+	return register_console(&instance.up, B6_UTF8("soft"));
+}
+register_init(soft_console_register);
@@ -0,0 +1,246 @@
+/*
+ * Open Greedy - an open-source version of Edromel Studio's Greedy XP
+ *
+ * Copyright (C) 2014-2017 Arnaud TROEL
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "soft_renderer.h"
+
+#include <b6/allocator.h>
+#include <math.h>
+#include <string.h>
+
+#include "lib/log.h"
+#include "lib/std.h"
+
+struct soft_texture {
+	struct renderer_texture texture;
+	struct rgba rgba;
+};
+
+static struct soft_texture *to_soft_texture(struct renderer_texture *up)
+{
+	return b6_cast_of(up, struct soft_texture, texture);
+}
+
+static struct soft_renderer *to_soft_renderer(struct renderer *up)
+{
+	return b6_cast_of(up, struct soft_renderer, renderer);
+}
+
+static struct renderer_base *get_soft_root(struct renderer *up)
+{
+	return &to_soft_renderer(up)->root;
+}
+
+static void delete_soft_base(struct renderer_base *up)
+{
+	b6_deallocate(&b6_std_allocator, up);
+}
+
+static struct renderer_base *new_soft_base(struct renderer *up,
+					   struct renderer_base *parent,
+					   const char *name,
+					   double x, double y)
+{
+	static const struct renderer_base_ops ops = {
+		.dtor = delete_soft_base,
+	};
+	struct renderer_base *self = b6_allocate(&b6_std_allocator,
+						 sizeof(*self));
+	if (self && __setup_renderer_base(self, up, parent, name, x, y, &ops)) {
+		b6_deallocate(&b6_std_allocator, self);
+		return NULL;
+	}
+	return self;
+}
+
+static void delete_soft_tile(struct renderer_tile *up)
+{
+	b6_deallocate(&b6_std_allocator, up);
+}
+
+static struct renderer_tile *new_soft_tile(struct renderer *up,
+					   struct renderer_base *base,
+					   double x, double y,
+					   double w, double h,
+					   struct renderer_texture *texture)
+{
+	static const struct renderer_tile_ops ops = {
+		.dtor = delete_soft_tile,
+	};
+	struct renderer_tile *self = b6_allocate(&b6_std_allocator,
+						 sizeof(*self));
+	if (self &&
+	    __setup_renderer_tile(self, base, x, y, w, h, texture, &ops)) {
+		b6_deallocate(&b6_std_allocator, self);
+		return NULL;
+	}
+	return self;
+}
+
+static void delete_soft_texture(struct renderer_texture *up)
+{
+	struct soft_texture *self = to_soft_texture(up);
+	finalize_rgba(&self->rgba);
+	b6_deallocate(&b6_std_allocator, self);
+}
+
+static void update_soft_texture(struct renderer_texture *up,
+				const struct rgba *rgba)
+{
+	struct soft_texture *self = to_soft_texture(up);
+	if (self->rgba.w == rgba->w && self->rgba.h == rgba->h) {
+		memcpy(self->rgba.p, rgba->p, 4 * rgba->w * rgba->h);
+		return;
+	}
+	finalize_rgba(&self->rgba);
+	if (initialize_rgba_from(&self->rgba, rgba->p, rgba->w, rgba->h)) {
+		log_e(_s("out of memory"));
+		self->rgba.w = self->rgba.h = 0;
+		self->rgba.p = NULL;
+	}
+}
+
+static void patch_soft_texture(struct renderer_texture *up,
+			       const struct rgba *rgba,
+			       unsigned short int x, unsigned short int y,
+			       unsigned short int w, unsigned short int h)
+{
+	struct soft_texture *self = to_soft_texture(up);
+	if (self->rgba.w == rgba->w && self->rgba.h == rgba->h)
+		copy_rgba(rgba, x, y, w, h, &self->rgba, x, y);
+	else
+		update_soft_texture(up, rgba);
+}
+
+static struct renderer_texture *new_soft_texture(struct renderer *up,
+						 const struct rgba *rgba)
+{
+	static const struct renderer_texture_ops ops = {
+		.update = update_soft_texture,
+		.patch = patch_soft_texture,
+		.dtor = delete_soft_texture,
+	};
+	struct soft_texture *self = b6_allocate(&b6_std_allocator,
+						sizeof(*self));
+	if (!self)
+		return NULL;
+	if (initialize_rgba_from(&self->rgba, rgba->p, rgba->w, rgba->h)) {
+		b6_deallocate(&b6_std_allocator, self);
+		return NULL;
+	}
+	__setup_renderer_texture(&self->texture, &ops);
+	return &self->texture;
+}
+
+/* Edges are rounded separately so that adjacent tiles neither overlap nor
+ * leave gaps.
+ */
+static void soft_render_tiles(struct soft_renderer *self)
+{
+	const struct renderer_scene *scene = &self->renderer.scene;
+	unsigned long int i, n = b6_array_length(&scene->order);
+	const unsigned int *order = b6_array_get(&scene->order, 0);
+	const unsigned int *base = b6_array_get(&scene->tile_base, 0);
+	struct renderer_texture *const *texture =
+		b6_array_get(&scene->tile_texture, 0);
+	const float *x = b6_array_get(&scene->tile_x, 0);
+	const float *y = b6_array_get(&scene->tile_y, 0);
+	const float *w = b6_array_get(&scene->tile_w, 0);
+	const float *h = b6_array_get(&scene->tile_h, 0);
+	const float *offset = b6_array_get(&scene->base_offset, 0);
+	const unsigned char *shown = b6_array_get(&scene->base_shown, 0);
+	for (i = 0; i < n; i += 1) {
+		unsigned int j = order[i], k = base[j];
+		int x1, y1, x2, y2;
+		if (!texture[j] || !shown[k])
+			continue;
+		x1 = floor(offset[2 * k] + x[j] + .5);
+		y1 = floor(offset[2 * k + 1] + y[j] + .5);
+		x2 = floor(offset[2 * k] + x[j] + w[j] + .5);
+		y2 = floor(offset[2 * k + 1] + y[j] + h[j] + .5);
+		blend_rgba(&to_soft_texture(texture[j])->rgba, &self->frame,
+			   x1, y1, x2 - x1, y2 - y1);
+		self->renderer.ndraws += 1;
+	}
+}
+
+static void soft_render(struct renderer *up)
+{
+	struct soft_renderer *self = to_soft_renderer(up);
+	if (!self->frame.p)
+		return;
+	if (sweep_renderer_scene(up)) {
+		log_e(_s("out of memory"));
+		return;
+	}
+	clear_rgba(&self->frame, 0xff000000);
+	soft_render_tiles(self);
+	dim_rgba(&self->frame, self->dim * 255 + .5);
+}
+
+static void soft_start(struct renderer *up)
+{
+	struct soft_renderer *self = to_soft_renderer(up);
+	if (initialize_rgba(&self->frame, up->internal_width,
+			    up->internal_height))
+		log_p(_s("out of memory"));
+}
+
+static void soft_stop(struct renderer *up)
+{
+	struct soft_renderer *self = to_soft_renderer(up);
+	finalize_rgba(&self->frame);
+	self->frame.p = NULL;
+}
+
+static void soft_dim(struct renderer *up, float value)
+{
+	struct soft_renderer *self = to_soft_renderer(up);
+	self->dim = value < 0 ? 0 : value > 1 ? 1 : value;
+}
+
+int open_soft_renderer(struct soft_renderer *self)
+{
+	static const struct renderer_ops ops = {
+		.get_root = get_soft_root,
+		.new_base = new_soft_base,
+		.new_tile = new_soft_tile,
+		.new_texture = new_soft_texture,
+		.start = soft_start,
+		.stop = soft_stop,
+		.render = soft_render,
+		.dim = soft_dim,
+	};
+	__setup_renderer(&self->renderer, &ops);
+	if (__setup_renderer_base(&self->root, &self->renderer, NULL,
+				  "soft_root", 0, 0, NULL)) {
+		__finalize_renderer(&self->renderer);
+		return -1;
+	}
+	self->frame.p = NULL;
+	self->frame.w = self->frame.h = 0;
+	self->dim = 1.f;
+	return 0;
+}
+
+void close_soft_renderer(struct soft_renderer *self)
+{
+	if (self->frame.p)
+		soft_stop(&self->renderer);
+	__finalize_renderer(&self->renderer);
+}
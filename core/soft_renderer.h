@@ -0,0 +1,47 @@
+/*
+ * Open Greedy - an open-source version of Edromel Studio's Greedy XP
+ *
+ * Copyright (C) 2014-2017 Arnaud TROEL
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef SOFT_RENDERER_H
+#define SOFT_RENDERER_H
+
+#include "renderer.h"
+#include "rgba.h"
+
+/* Rasterizes the scene into an in-memory frame of the internal size, with
+ * nearest sampling and integer blending: frames are the same on every host.
+ */
+struct soft_renderer {
+	struct renderer renderer;
+	struct renderer_base root;
+	struct rgba frame;
+	float dim;
+};
+
+extern int open_soft_renderer(struct soft_renderer *self);
+
+extern void close_soft_renderer(struct soft_renderer *self);
+
+/* Returns NULL until the renderer is started. */
+static inline const struct rgba *get_soft_renderer_frame(
+	const struct soft_renderer *self)
+{
+	return self->frame.p ? &self->frame : NULL;
+}
+
+#endif /* SOFT_RENDERER_H */
@@ -0,0 +1,153 @@
+/*
+ * Open Greedy - an open-source version of Edromel Studio's Greedy XP
+ *
+ * Copyright (C) 2014-2017 Arnaud TROEL
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "texture_cache.h"
+
+#include <b6/allocator.h>
+#include <b6/cmdline.h>
+#include <b6/list.h>
+#include <string.h>
+
+#include "lib/init.h"
+#include "toolkit.h"
+
+static unsigned int texture_cache = 16384; /* in kilobytes */
+b6_flag(texture_cache, uint);
+
+struct texture_cache_entry {
+	struct b6_dref dref; /* least recently used first */
+	struct renderer_texture *texture;
+	const char *skin_id;
+	const char *data_id;
+	unsigned long int refs;
+};
+
+static struct b6_list entries;
+static unsigned long int parked_bytes = 0; /* of textures no longer used */
+
+static struct texture_cache_entry *find_texture_cache_entry(
+	const struct renderer_texture *texture)
+{
+	struct b6_dref *dref;
+	for (dref = b6_list_first(&entries); dref != b6_list_tail(&entries);
+	     dref = b6_list_walk(dref, B6_NEXT)) {
+		struct texture_cache_entry *entry =
+			b6_cast_of(dref, struct texture_cache_entry, dref);
+		if (entry->texture == texture)
+			return entry;
+	}
+	return NULL;
+}
+
+static void evict_texture_cache_entry(struct texture_cache_entry *entry)
+{
+	parked_bytes -= entry->texture->size;
+	unpark_renderer_texture(entry->texture);
+	destroy_renderer_texture(entry->texture);
+	b6_list_del(&entry->dref);
+	b6_deallocate(&b6_std_allocator, entry);
+}
+
+static void trim_texture_cache(unsigned long int budget)
+{
+	struct b6_dref *dref = b6_list_first(&entries);
+	while (parked_bytes > budget && dref != b6_list_tail(&entries)) {
+		struct texture_cache_entry *entry =
+			b6_cast_of(dref, struct texture_cache_entry, dref);
+		dref = b6_list_walk(dref, B6_NEXT);
+		if (!entry->refs)
+			evict_texture_cache_entry(entry);
+	}
+}
+
+struct renderer_texture *get_texture(struct renderer *renderer,
+				     const char *skin_id, const char *data_id)
+{
+	struct texture_cache_entry *entry;
+	struct b6_dref *dref;
+	for (dref = b6_list_first(&entries); dref != b6_list_tail(&entries);
+	     dref = b6_list_walk(dref, B6_NEXT)) {
+		entry = b6_cast_of(dref, struct texture_cache_entry, dref);
+		if (entry->texture->renderer != renderer ||
+		    strcmp(entry->data_id, data_id) ||
+		    strcmp(entry->skin_id, skin_id))
+			continue;
+		if (!entry->refs++) {
+			parked_bytes -= entry->texture->size;
+			unpark_renderer_texture(entry->texture);
+		}
+		return entry->texture;
+	}
+	if (!(entry = b6_allocate(&b6_std_allocator, sizeof(*entry)))) {
+		log_w(_s("out of memory"));
+		return make_texture(renderer, skin_id, data_id);
+	}
+	if (!(entry->texture = make_texture(renderer, skin_id, data_id))) {
+		b6_deallocate(&b6_std_allocator, entry);
+		return NULL;
+	}
+	entry->skin_id = skin_id;
+	entry->data_id = data_id;
+	entry->refs = 1;
+	b6_list_add_last(&entries, &entry->dref);
+	return entry->texture;
+}
+
+void put_texture(struct renderer_texture *texture)
+{
+	struct texture_cache_entry *entry;
+	if (!texture)
+		return;
+	if (!(entry = find_texture_cache_entry(texture))) {
+		destroy_renderer_texture(texture);
+		return;
+	}
+	if (b6_unlikely(!entry->refs))
+		log_p(_s("double free"));
+	if (--entry->refs)
+		return;
+	park_renderer_texture(texture);
+	parked_bytes += texture->size;
+	b6_list_del(&entry->dref);
+	b6_list_add_last(&entries, &entry->dref);
+	trim_texture_cache(texture_cache * 1024UL);
+}
+
+void flush_texture_cache(struct renderer *renderer)
+{
+	struct b6_dref *dref = b6_list_first(&entries);
+	while (dref != b6_list_tail(&entries)) {
+		struct texture_cache_entry *entry =
+			b6_cast_of(dref, struct texture_cache_entry, dref);
+		dref = b6_list_walk(dref, B6_NEXT);
+		if (entry->texture->renderer != renderer)
+			continue;
+		if (entry->refs)
+			logf_w("texture %s still in use", entry->data_id);
+		else
+			evict_texture_cache_entry(entry);
+	}
+}
+
+static int texture_cache_ctor(void)
+{
+	b6_list_initialize(&entries);
+	return 0;
+}
+register_init(texture_cache_ctor);
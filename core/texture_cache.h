@@ -0,0 +1,43 @@
+/*
+ * Open Greedy - an open-source version of Edromel Studio's Greedy XP
+ *
+ * Copyright (C) 2014-2017 Arnaud TROEL
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TEXTURE_CACHE_H
+#define TEXTURE_CACHE_H
+
+#include "renderer.h"
+
+/* Textures of skin images are shared, and kept across phases once no longer
+ * used until the memory they take exceeds a budget. Identifiers are compared
+ * as strings but only pointers to them are kept: they have to be static.
+ */
+
+/* Returns a texture to give back with put_texture, or NULL. */
+extern struct renderer_texture *get_texture(struct renderer *renderer,
+					    const char *skin_id,
+					    const char *data_id);
+
+/* Also accepts NULL, and textures that did not come from get_texture that it
+ * destroys.
+ */
+extern void put_texture(struct renderer_texture *texture);
+
+/* Destroys all unused textures of the renderer, e.g. before it is closed. */
+extern void flush_texture_cache(struct renderer *renderer);
+
+#endif /* TEXTURE_CACHE_H */
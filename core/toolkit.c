@@ -19,6 +19,7 @@
 
 #include "toolkit.h"
 
+#include <b6/allocator.h>
 #include <b6/utf8.h>
 #include <b6/utils.h>
 
@@ -143,7 +144,7 @@ void enable_toolkit_label_shadow(struct toolkit_label *self)
 	make_shadow_rgba(&self->rgba);
 	self->image[1].texture = create_renderer_texture_or_die(self->renderer,
 								&self->rgba);
-	if (self->image[0].tile->texture)
+	if (get_renderer_tile_texture(self->image[0].tile))
 		show_toolkit_image(&self->image[1]);
 }
 
@@ -174,6 +175,140 @@ int set_toolkit_label(struct toolkit_label *self, const struct b6_utf8 *utf8)
 	return 0;
 }
 
+int initialize_toolkit_glyphs(struct toolkit_glyphs *self,
+			      struct renderer *renderer,
+			      const struct fixed_font *font, int shadow)
+{
+	struct rgba rgba;
+	int i;
+	self->font = font;
+	for (i = 0; i < b6_card_of(self->glyph); i += 1)
+		self->glyph[i] = self->shadow[i] = NULL;
+	if (shadow && initialize_rgba(&rgba, get_fixed_font_width(font),
+				      get_fixed_font_height(font)))
+		return -1;
+	for (i = 0; i < b6_card_of(self->glyph); i += 1) {
+		const struct rgba *from = &font->rgba[i];
+		if (!(self->glyph[i] = create_renderer_texture(renderer, from)))
+			goto fail;
+		if (!shadow)
+			continue;
+		copy_rgba(from, 0, 0, from->w, from->h, &rgba, 0, 0);
+		make_shadow_rgba(&rgba);
+		if (!(self->shadow[i] = create_renderer_texture(renderer,
+								&rgba)))
+			goto fail;
+	}
+	if (shadow)
+		finalize_rgba(&rgba);
+	return 0;
+fail:
+	if (shadow)
+		finalize_rgba(&rgba);
+	finalize_toolkit_glyphs(self);
+	return -1;
+}
+
+void finalize_toolkit_glyphs(struct toolkit_glyphs *self)
+{
+	int i;
+	for (i = 0; i < b6_card_of(self->glyph); i += 1) {
+		destroy_renderer_texture(self->shadow[i]);
+		destroy_renderer_texture(self->glyph[i]);
+	}
+}
+
+int initialize_toolkit_text(struct toolkit_text *self,
+			    struct renderer *renderer,
+			    const struct toolkit_glyphs *glyphs,
+			    unsigned short int u, unsigned short int v,
+			    struct renderer_base *base,
+			    float x, float y, float w, float h)
+{
+	unsigned short int font_w = get_fixed_font_width(glyphs->font);
+	unsigned short int font_h = get_fixed_font_height(glyphs->font);
+	unsigned short int i, j, nlayers = glyphs->shadow[0] ? 2 : 1;
+	self->glyphs = glyphs;
+	self->length = u / font_w;
+	self->u = u;
+	self->v = v;
+	self->x = x;
+	self->y = y;
+	self->sx = w / u;
+	self->sy = h / v;
+	self->tiles = b6_allocate(&b6_std_allocator, nlayers * self->length *
+				  sizeof(*self->tiles));
+	if (!self->tiles)
+		return -1;
+	if (!(self->base = create_renderer_base(renderer, base, "text", x, y)))
+		goto fail_base;
+	for (j = 0; j < nlayers; j += 1)
+		for (i = 0; i < self->length; i += 1) {
+			struct renderer_tile **tile =
+				&self->tiles[j * self->length + i];
+			/* shadows are 3 pixels away, as with labels */
+			float d = j + 1 < nlayers ? 3 : 0;
+			*tile = create_renderer_tile(renderer, self->base,
+						     i * font_w * self->sx + d,
+						     d, font_w * self->sx,
+						     font_h * self->sy, NULL);
+			if (!*tile)
+				goto fail_tile;
+		}
+	return 0;
+fail_tile:
+	destroy_renderer_base(self->base);
+fail_base:
+	b6_deallocate(&b6_std_allocator, self->tiles);
+	return -1;
+}
+
+void finalize_toolkit_text(struct toolkit_text *self)
+{
+	destroy_renderer_base(self->base);
+	b6_deallocate(&b6_std_allocator, self->tiles);
+}
+
+static void set_toolkit_text_tile(struct renderer_tile *tile,
+				  struct renderer_texture *texture)
+{
+	if (get_renderer_tile_texture(tile) != texture)
+		set_renderer_tile_texture(tile, texture);
+}
+
+int set_toolkit_text(struct toolkit_text *self, const struct b6_utf8 *utf8)
+{
+	const struct toolkit_glyphs *glyphs = self->glyphs;
+	struct renderer_tile **glyph_tiles = self->tiles;
+	struct b6_utf8_iterator iter;
+	unsigned short int i = 0;
+	int x = self->u - get_fixed_font_text_width(glyphs->font, utf8);
+	int y = self->v - get_fixed_font_height(glyphs->font);
+	if (x < 0 || y < 0)
+		return -1;
+	move_renderer_base(self->base, self->x + x / 2 * self->sx,
+			   self->y + y / 2 * self->sy);
+	if (glyphs->shadow[0])
+		glyph_tiles += self->length;
+	b6_setup_utf8_iterator(&iter, utf8);
+	while (b6_utf8_iterator_has_next(&iter) && i < self->length) {
+		int c = b6_utf8_iterator_get_next(&iter) - ' ';
+		if (c < 0 || c >= b6_card_of(glyphs->glyph))
+			continue;
+		if (glyphs->shadow[0])
+			set_toolkit_text_tile(self->tiles[i],
+					      glyphs->shadow[c]);
+		set_toolkit_text_tile(glyph_tiles[i], glyphs->glyph[c]);
+		i += 1;
+	}
+	for (; i < self->length; i += 1) {
+		if (glyphs->shadow[0])
+			set_toolkit_text_tile(self->tiles[i], NULL);
+		set_toolkit_text_tile(glyph_tiles[i], NULL);
+	}
+	return 0;
+}
+
 void initialize_toolkit_image(struct toolkit_image *self,
 			      struct renderer *renderer, struct renderer_base *base,
 			      float x, float y, float w, float h,
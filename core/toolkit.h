@@ -111,4 +111,57 @@ static inline void hide_toolkit_label(struct toolkit_label *self)
 	hide_toolkit_image(&self->image[1]);
 }
 
+/* Glyphs of a fixed font uploaded once as textures of their own, that the
+ * renderer may pack together.
+ */
+struct toolkit_glyphs {
+	const struct fixed_font *font;
+	struct renderer_texture *glyph[96];
+	struct renderer_texture *shadow[96]; /* NULL without shadows */
+};
+
+extern int initialize_toolkit_glyphs(struct toolkit_glyphs *self,
+				     struct renderer *renderer,
+				     const struct fixed_font *font,
+				     int shadow);
+
+extern void finalize_toolkit_glyphs(struct toolkit_glyphs *self);
+
+/* A line of text drawn as a run of glyph tiles: changing it only changes the
+ * textures of a few tiles, and nothing is rendered into images.
+ */
+struct toolkit_text {
+	const struct toolkit_glyphs *glyphs;
+	struct renderer_base *base;
+	struct renderer_tile **tiles; /* shadows first if any, then glyphs */
+	unsigned short int length; /* maximum number of glyphs */
+	unsigned short int u, v;
+	float x, y, sx, sy;
+};
+
+/* Same geometry as toolkit labels: the text is centered in a u x v box of
+ * font pixels that is displayed as w x h at (x, y).
+ */
+extern int initialize_toolkit_text(struct toolkit_text *self,
+				   struct renderer *renderer,
+				   const struct toolkit_glyphs *glyphs,
+				   unsigned short int u, unsigned short int v,
+				   struct renderer_base *base,
+				   float x, float y, float w, float h);
+
+extern void finalize_toolkit_text(struct toolkit_text *self);
+
+extern int set_toolkit_text(struct toolkit_text *self,
+			    const struct b6_utf8 *utf8);
+
+static inline void show_toolkit_text(struct toolkit_text *self)
+{
+	show_renderer_base(self->base);
+}
+
+static inline void hide_toolkit_text(struct toolkit_text *self)
+{
+	hide_renderer_base(self->base);
+}
+
 #endif /* TOOLKIT_H */
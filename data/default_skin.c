@@ -72,58 +72,29 @@ static const struct image_data_ops default_image_data_ops = {
 	.dtor = default_image_data_entry_dtor,
 };
 
-static unsigned int default_game_tile(const struct layout *l,
-				      unsigned short int x,
-				      unsigned short int y)
-{
-	static unsigned int map[] = {
-		 4, 23,  7,  2, 31,  1,  0, 11, 15, 18,  8, 20, 16, 19, 12,  3,
-		 4, 23,  7,  2, 31,  1,  0, 11, 15, 42,  8,  5, 16, 46, 12, 36,
-		 4, 23,  7, 26, 31,  1,  0, 44, 15, 18,  8, 13, 16, 19, 12, 28,
-		 4, 23,  7, 26, 31,  1,  0, 44, 15, 42,  8, 34, 16, 46, 12, 22,
-		 4, 23,  7,  2, 31,  1, 24, 45, 15, 18,  8, 20, 16, 19, 14, 27,
-		 4, 23,  7,  2, 31,  1, 24, 45, 15, 42,  8,  5, 16, 46, 14, 37,
-		 4, 23,  7, 26, 31,  1, 24, 25, 15, 18,  8, 13, 16, 19, 14, 30,
-		 4, 23,  7, 26, 31,  1, 24, 25, 15, 42,  8, 34, 16, 46, 14, 47,
-		 4, 23,  7,  2, 31,  1,  0, 11, 15, 18,  8, 20, 40, 38,  6, 35,
-		 4, 23,  7,  2, 31,  1,  0, 11, 15, 42,  8,  5, 40, 41,  6, 43,
-		 4, 23,  7, 26, 31,  1,  0, 44, 15, 18,  8, 13, 40, 38,  6, 29,
-		 4, 23,  7, 26, 31,  1,  0, 44, 15, 42,  8, 34, 40, 41,  6, 39,
-		 4, 23,  7,  2, 31,  1, 24, 45, 15, 18,  8, 20, 40, 38, 32, 21,
-		 4, 23,  7,  2, 31,  1, 24, 45, 15, 42,  8,  5, 40, 41, 32, 17,
-		 4, 23,  7, 26, 31,  1, 24, 25, 15, 18,  8, 13, 40, 38, 32, 10,
-		 4, 23,  7, 26, 31,  1, 24, 25, 15, 42,  8, 34, 40, 41, 32, 33
-	};
-	if (x > LEVEL_WIDTH || y > LEVEL_HEIGHT)
-		return 33;
-	if (get_layout(l, x, y) == LAYOUT_WALL) {
-		unsigned int code = 0;
-		if (get_layout(l, x    , y - 1) == LAYOUT_WALL) code |= 1 << 0;
-		if (get_layout(l, x + 1, y    ) == LAYOUT_WALL) code |= 1 << 1;
-		if (get_layout(l, x    , y + 1) == LAYOUT_WALL) code |= 1 << 2;
-		if (get_layout(l, x - 1, y    ) == LAYOUT_WALL) code |= 1 << 3;
-		if (get_layout(l, x - 1, y - 1) == LAYOUT_WALL) code |= 1 << 4;
-		if (get_layout(l, x + 1, y - 1) == LAYOUT_WALL) code |= 1 << 5;
-		if (get_layout(l, x + 1, y + 1) == LAYOUT_WALL) code |= 1 << 6;
-		if (get_layout(l, x - 1, y + 1) == LAYOUT_WALL) code |= 1 << 7;
-		return map[code];
-	}
-	return 9;
-}
-
 static struct rgba layout_rgba;
 
 static int default_layout_ctor(struct image_data *up, void *layout)
 {
 	static const unsigned short int w = 16, h = 16;
+	const struct layout *l = layout;
 	unsigned short int x, y;
 	struct data_entry *data_entry;
 	struct image_data *image_data;
+	if (layout_rgba.w != w * l->width || layout_rgba.h != h * l->height) {
+		finalize_rgba(&layout_rgba);
+		if (initialize_rgba(&layout_rgba, w * l->width, h * l->height)) {
+			layout_rgba.w = layout_rgba.h = 0;
+			return -1;
+		}
+		up->w = layout_rgba.w;
+		up->h = layout_rgba.h;
+	}
 	if (get_image_data("default", "private.default_game.tga", NULL,
 			   &data_entry, &image_data))
 		return -1;
-	for (y = 0; y < LEVEL_HEIGHT; ++y) for (x = 0; x < LEVEL_WIDTH; ++x) {
-		unsigned int n = default_game_tile(layout, x, y);
+	for (y = 0; y < l->height; ++y) for (x = 0; x < l->width; ++x) {
+		unsigned int n = get_layout_tile(layout, x, y);
 		copy_rgba(image_data->rgba, 544 + (n / 8) * w, 96 + (n % 8) * h,
 			  w, h, &layout_rgba, x * w, y * h);
 	}
@@ -211,8 +182,7 @@ do { \
 	static struct cached_image_data data; \
 	struct embedded *embedded; \
 	if ((embedded = lookup_embedded(path))) { \
-		register_cached_image_data( \
-			&data, embedded->buf, embedded->len, &utf8); \
+		register_embedded_image_data(&data, embedded, &utf8); \
 	} else \
 		log_p(_s("embedded image path not found: "), _t(path)); \
 } while (0)
@@ -270,6 +240,7 @@ static int default_skin_ctor(void)
 	static unsigned short int booster_x[] = { 0, 264 };
 	static unsigned short int booster_y[] = { 80, 80 };
 	static unsigned short int casino_x[48], casino_y[48];
+	static unsigned short int tiles_x[48], tiles_y[48];
 	int i, j;
 
 	register_cached_image(B6_UTF8("default_font.tga"), IMAGE_DATA_ID(
@@ -288,6 +259,14 @@ static int default_skin_ctor(void)
 						       GAME_LAYOUT_DATA_ID)))))
 		log_e(_s("cannot register image data " GAME_LAYOUT_DATA_ID));
 
+	register_default_image_data(GAME_TILES_DATA_ID, "default_game.tga",
+				    tiles_x, tiles_y, 16, 16,
+				    b6_card_of(tiles_x), 0);
+	for (i = 0; i < b6_card_of(tiles_x); i += 1) {
+		tiles_x[i] = 544 + (i / 8) * 16;
+		tiles_y[i] = 96 + (i % 8) * 16;
+	}
+
 	register_default_single_image_data(GAME_PANEL_DATA_ID,
 					   "default_game.tga", 0, 0, 640, 80);
 	register_default_single_image_data(GAME_PACGUM_DATA_ID,
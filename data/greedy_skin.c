@@ -76,56 +76,19 @@ static const struct image_data_ops greedy_image_ops = {
 	.dtor = greedy_image_data_entry_dtor,
 };
 
-static unsigned int greedy_game_tile(const struct layout *l,
-				     unsigned short int x, unsigned short int y)
-{
-	static unsigned int map[] = {
-		 4, 23,  7,  2, 31,  1,  0, 11, 15, 18,  8, 20, 16, 19, 12,  3,
-		 4, 23,  7,  2, 31,  1,  0, 11, 15, 42,  8,  5, 16, 46, 12, 36,
-		 4, 23,  7, 26, 31,  1,  0, 44, 15, 18,  8, 13, 16, 19, 12, 28,
-		 4, 23,  7, 26, 31,  1,  0, 44, 15, 42,  8, 34, 16, 46, 12, 22,
-		 4, 23,  7,  2, 31,  1, 24, 45, 15, 18,  8, 20, 16, 19, 14, 27,
-		 4, 23,  7,  2, 31,  1, 24, 45, 15, 42,  8,  5, 16, 46, 14, 37,
-		 4, 23,  7, 26, 31,  1, 24, 25, 15, 18,  8, 13, 16, 19, 14, 30,
-		 4, 23,  7, 26, 31,  1, 24, 25, 15, 42,  8, 34, 16, 46, 14, 47,
-		 4, 23,  7,  2, 31,  1,  0, 11, 15, 18,  8, 20, 40, 38,  6, 35,
-		 4, 23,  7,  2, 31,  1,  0, 11, 15, 42,  8,  5, 40, 41,  6, 43,
-		 4, 23,  7, 26, 31,  1,  0, 44, 15, 18,  8, 13, 40, 38,  6, 29,
-		 4, 23,  7, 26, 31,  1,  0, 44, 15, 42,  8, 34, 40, 41,  6, 39,
-		 4, 23,  7,  2, 31,  1, 24, 45, 15, 18,  8, 20, 40, 38, 32, 21,
-		 4, 23,  7,  2, 31,  1, 24, 45, 15, 42,  8,  5, 40, 41, 32, 17,
-		 4, 23,  7, 26, 31,  1, 24, 25, 15, 18,  8, 13, 40, 38, 32, 10,
-		 4, 23,  7, 26, 31,  1, 24, 25, 15, 42,  8, 34, 40, 41, 32, 33
-	};
-	if (x > LEVEL_WIDTH || y > LEVEL_HEIGHT)
-		return 33;
-	if (get_layout(l, x, y) == LAYOUT_WALL) {
-		unsigned int code = 0;
-		if (get_layout(l, x    , y - 1) == LAYOUT_WALL) code |= 1 << 0;
-		if (get_layout(l, x + 1, y    ) == LAYOUT_WALL) code |= 1 << 1;
-		if (get_layout(l, x    , y + 1) == LAYOUT_WALL) code |= 1 << 2;
-		if (get_layout(l, x - 1, y    ) == LAYOUT_WALL) code |= 1 << 3;
-		if (get_layout(l, x - 1, y - 1) == LAYOUT_WALL) code |= 1 << 4;
-		if (get_layout(l, x + 1, y - 1) == LAYOUT_WALL) code |= 1 << 5;
-		if (get_layout(l, x + 1, y + 1) == LAYOUT_WALL) code |= 1 << 6;
-		if (get_layout(l, x - 1, y + 1) == LAYOUT_WALL) code |= 1 << 7;
-		return map[code];
-	}
-	return 9;
-}
-
 static int greedy_layout_ctor(struct image_data *up, void *layout)
 {
 	static const unsigned short int w = 16, h = 16;
 	struct greedy_image_data *self =
 		b6_cast_of(up, struct greedy_image_data, image_data);
+	const struct layout *l = layout;
 	struct rgba *layout_rgba = (struct rgba*)up->rgba;
 	struct data_entry *data_entry;
 	struct image_data *image_data;
 	unsigned short int x, y;
 	if (self->count)
 		goto done;
-	if (initialize_rgba(layout_rgba, w * LEVEL_WIDTH, h * LEVEL_HEIGHT)) {
+	if (initialize_rgba(layout_rgba, w * l->width, h * l->height)) {
 		self->count = 0;
 		return -1;
 	}
@@ -134,8 +97,8 @@ static int greedy_layout_ctor(struct image_data *up, void *layout)
 		finalize_rgba(layout_rgba);
 		return -1;
 	}
-	for (y = 0; y < LEVEL_HEIGHT; ++y) for (x = 0; x < LEVEL_WIDTH; ++x) {
-		unsigned n = greedy_game_tile(layout, x, y);
+	for (y = 0; y < l->height; ++y) for (x = 0; x < l->width; ++x) {
+		unsigned n = get_layout_tile(layout, x, y);
 		copy_rgba(image_data->rgba, (n / 8) * w, (n % 8) * h, w, h,
 			  layout_rgba, x * w, y * h);
 	}
@@ -646,6 +609,18 @@ static int greedy_skin_ctor(void)
 	       	0, 0, 0, 0);
 	layout_data.image_data.rgba = &layout_rgba;
 
+	static struct greedy_image_data tiles_data;
+	static unsigned short int tiles_x[48], tiles_y[48];
+	register_greedy_image_data(
+		&tiles_data,
+		B6_UTF8(IMAGE_DATA_ID("greedy", GAME_TILES_DATA_ID)),
+		GREEDY_GAME_PATTERN, &greedy_image_ops, tiles_x, tiles_y,
+		16, 16, b6_card_of(tiles_x), 0);
+	for (i = 0; i < b6_card_of(tiles_x); i += 1) {
+		tiles_x[i] = (i / 8) * 16;
+		tiles_y[i] = (i % 8) * 16;
+	}
+
 	static struct greedy_image_data pacman_wins_data;
 	static unsigned short int pacman_wins_x[20], pacman_wins_y[20];
 	register_greedy_image_data(
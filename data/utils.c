@@ -144,6 +144,30 @@ static B6_LIST_DEFINE(image_cache);
 static unsigned int cache_count = 0;
 static unsigned int cache_limit = 2;
 
+static int read_embedded_rgba(struct rgba *rgba,
+			      const struct embedded *embedded)
+{
+	unsigned long int len = 4UL * embedded->tw * embedded->th;
+	struct izbstream eis;
+	long long int size;
+	if (!(embedded->flags & EMBEDDED_DEFLATED))
+		return initialize_rgba_from(rgba, embedded->buf,
+					    embedded->tw, embedded->th);
+	if (initialize_rgba(rgba, embedded->tw, embedded->th))
+		return -1;
+	if (initialize_izbstream(&eis, embedded->buf, embedded->len)) {
+		finalize_rgba(rgba);
+		return -1;
+	}
+	size = read_istream(izbstream_as_istream(&eis), rgba->p, len);
+	finalize_izbstream(&eis);
+	if (size < len) {
+		finalize_rgba(rgba);
+		return -1;
+	}
+	return 0;
+}
+
 static int cached_image_data_ctor(struct image_data *up, void *param)
 {
 	struct cached_image_data *self =
@@ -173,19 +197,29 @@ static int cached_image_data_ctor(struct image_data *up, void *param)
 		if (dref == b6_list_head(&image_cache))
 			return -1;
 	}
-	if (initialize_izbstream(&eis, self->buffered_data_entry.buf,
-				 self->buffered_data_entry.len))
-		return -1;
-	retval = initialize_rgba_from_tga(&self->shared_rgba.rgba,
-					  izbstream_as_istream(&eis));
-	finalize_izbstream(&eis);
-	if (retval) {
-		logf_e("inflating failed with error %d", retval);
-		return -1;
+	if (self->embedded) {
+		if (read_embedded_rgba(&self->shared_rgba.rgba,
+				       self->embedded)) {
+			log_e(_s("inflating embedded pixels failed"));
+			return -1;
+		}
+		self->image_data.w = self->embedded->w;
+		self->image_data.h = self->embedded->h;
+	} else {
+		if (initialize_izbstream(&eis, self->buffered_data_entry.buf,
+					 self->buffered_data_entry.len))
+			return -1;
+		retval = initialize_rgba_from_tga(&self->shared_rgba.rgba,
+						  izbstream_as_istream(&eis));
+		finalize_izbstream(&eis);
+		if (retval) {
+			logf_e("inflating failed with error %d", retval);
+			return -1;
+		}
+		self->image_data.w = self->shared_rgba.rgba.w;
+		self->image_data.h = self->shared_rgba.rgba.h;
 	}
 	self->image_data.rgba = &self->shared_rgba.rgba;
-	self->image_data.w = self->shared_rgba.rgba.w;
-	self->image_data.h = self->shared_rgba.rgba.h;
 	cache_count += 1;
 done:
 	self->shared_rgba.count += 1;
@@ -218,9 +252,21 @@ int register_cached_image_data(struct cached_image_data *self,
 	setup_image_data(&self->image_data, &image_ops, NULL,
 			 &zero, &zero, 0, 0, 1, 0);
 	self->dref.ref[0] = NULL;
+	self->embedded = NULL;
 	return register_data(&self->buffered_data_entry.up, &entry_ops, id);
 }
 
+int register_embedded_image_data(struct cached_image_data *self,
+				 const struct embedded *embedded,
+				 const struct b6_utf8 *id)
+{
+	int retval = register_cached_image_data(self, embedded->buf,
+						embedded->len, id);
+	if (!retval && embedded->w)
+		self->embedded = embedded;
+	return retval;
+}
+
 void unregister_cached_image_data(struct cached_image_data *self)
 {
 	unregister_data(&self->buffered_data_entry.up);
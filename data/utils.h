@@ -36,11 +36,14 @@ struct shared_rgba {
 	unsigned int count;
 };
 
+struct embedded;
+
 struct cached_image_data {
 	struct buffered_data_entry buffered_data_entry;
 	struct image_data image_data;
 	struct b6_dref dref;
 	struct shared_rgba shared_rgba;
+	const struct embedded *embedded; /* NULL unless pixels are embedded */
 };
 
 extern int register_buffered_data(struct buffered_data_entry *self,
@@ -53,6 +56,10 @@ extern int register_cached_image_data(struct cached_image_data *self,
 				      const void *buf, unsigned int len,
 				      const struct b6_utf8 *id);
 
+extern int register_embedded_image_data(struct cached_image_data *self,
+					const struct embedded *embedded,
+					const struct b6_utf8 *id);
+
 void unregister_cached_image_data(struct cached_image_data *self);
 
 extern int load_external_data(struct membuf *self, const char *path);
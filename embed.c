@@ -21,6 +21,8 @@
 #include <stdlib.h>
 #include <string.h>
 #include <b6/cmdline.h>
+#include "core/rgba.h"
+#include "lib/embedded.h"
 #include "lib/io.h"
 
 static void write_head(struct ostream *ostream)
@@ -49,25 +51,79 @@ static ssize_t write_body(struct istream *is, struct ostream *os,
 	return size;
 }
 
-static void write_foot(struct ostream *ostream, char *name, size_t size)
+static void write_number(struct ostream *ostream, unsigned long int n)
+{
+	char s[24];
+	write_ostream(ostream, s, snprintf(s, sizeof(s), "%lu", n));
+}
+
+static void write_foot(struct ostream *ostream, char *name, size_t size,
+		       const struct rgba *rgba, unsigned short int w,
+		       unsigned short int h, unsigned int flags)
 {
 	static const char a[] = "};\npublish_embedded(data, ";
 	static const char b[] = ", B6_UTF8(\"";
 	static const char c[] = "\"));\n";
-	char s[16];
-	int n;
-	write_ostream(ostream, a, sizeof(a) - 1);
-#ifdef _WIN32
-	n = snprintf(s, sizeof(s), "%u", size);
-#else
-	n = snprintf(s, sizeof(s), "%zu", size);
-#endif
-	write_ostream(ostream, s, n);
+	static const char d[] = "};\npublish_embedded_image(data, ";
+	static const char e[] = ", ";
+	if (rgba) {
+		write_ostream(ostream, d, sizeof(d) - 1);
+		write_number(ostream, size);
+		write_ostream(ostream, e, sizeof(e) - 1);
+		write_number(ostream, w);
+		write_ostream(ostream, e, sizeof(e) - 1);
+		write_number(ostream, h);
+		write_ostream(ostream, e, sizeof(e) - 1);
+		write_number(ostream, rgba->w);
+		write_ostream(ostream, e, sizeof(e) - 1);
+		write_number(ostream, rgba->h);
+		write_ostream(ostream, e, sizeof(e) - 1);
+		write_number(ostream, flags);
+	} else {
+		write_ostream(ostream, a, sizeof(a) - 1);
+		write_number(ostream, size);
+	}
 	write_ostream(ostream, b, sizeof(b) - 1);
 	write_ostream(ostream, name, strlen(name));
 	write_ostream(ostream, c, sizeof(c) - 1);
 }
 
+static unsigned short int round_up_to_pot(unsigned short int n)
+{
+	unsigned short int pot = 1;
+	while (pot && pot < n)
+		pot <<= 1;
+	return pot;
+}
+
+/* Decodes the image read from istream into the layout renderers upload. */
+static int convert_image(struct rgba *rgba,
+			 unsigned short int *w, unsigned short int *h,
+			 struct istream *istream, int pot)
+{
+	struct rgba tmp;
+	unsigned short int tw, th;
+	if (initialize_rgba_from_tga(rgba, istream))
+		return -1;
+	*w = rgba->w;
+	*h = rgba->h;
+	if (!pot)
+		return 0;
+	tw = round_up_to_pot(rgba->w);
+	th = round_up_to_pot(rgba->h);
+	if (tw == rgba->w && th == rgba->h)
+		return 0;
+	if (!tw || !th || initialize_rgba(&tmp, tw, th)) {
+		finalize_rgba(rgba);
+		return -1;
+	}
+	clear_rgba(&tmp, 0);
+	copy_rgba(rgba, 0, 0, rgba->w, rgba->h, &tmp, 0, 0);
+	finalize_rgba(rgba);
+	*rgba = tmp;
+	return 0;
+}
+
 static unsigned char zbuf[128 * 1024]; /* FIXME: 8 + 0 * 128 * 1024 */
 
 static unsigned char buf[16384];
@@ -75,30 +131,64 @@ static unsigned char buf[16384];
 static int use_zlib = 1;
 b6_flag_named(use_zlib, bool, "compress");
 
+/* "straight" embeds a TGA image as decoded RGBA pixels, renderers blending
+ * colors that are not scaled by alpha.
+ */
+static const char *image = "";
+b6_flag(image, string);
+
+/* pads embedded images to power-of-two dimensions with transparent pixels */
+static int pot = 0;
+b6_flag(pot, bool);
+
 int main(int argc, char *argv[])
 {
 	struct ifstream ifs;
+	struct ibstream ibs;
 	struct ohstream ohs;
 	struct ofstream ofs;
+	struct istream *is;
+	struct rgba rgba;
+	unsigned short int w = 0, h = 0;
+	unsigned int flags = 0;
 	size_t size;
 	int argf = b6_parse_command_line_flags(argc, argv, 0);
 	if (argf >= argc)
 		return EXIT_FAILURE;
 	set_binary_mode(stdin);
 	initialize_ifstream_with_fp(&ifs, stdin, 0);
+	is = &ifs.istream;
+	if (*image) {
+		if (strcmp(image, "straight")) {
+			fprintf(stderr, "unknown image layout: %s\n", image);
+			return EXIT_FAILURE;
+		}
+		if (convert_image(&rgba, &w, &h, is, pot)) {
+			fprintf(stderr, "cannot decode image: %s\n",
+				argv[argf]);
+			return EXIT_FAILURE;
+		}
+		initialize_ibstream(&ibs, rgba.p, 4UL * rgba.w * rgba.h);
+		is = &ibs.istream;
+		if (use_zlib)
+			flags |= EMBEDDED_DEFLATED;
+	}
 	initialize_ofstream_with_fp(&ofs, stdout, 0);
 	write_head(&ofs.ostream);
 	initialize_ohstream_hex(&ohs, &ofs.ostream);
 	if (use_zlib) {
 		struct ozstream ozs;
 		initialize_ozstream(&ozs, &ohs.ostream, zbuf, sizeof(zbuf));
-		size = write_body(&ifs.istream, &ozs.up, buf, sizeof(buf));
+		size = write_body(is, &ozs.up, buf, sizeof(buf));
 		finalize_ozstream(&ozs);
 	} else
-		size = write_body(&ifs.istream, &ohs.ostream, buf, sizeof(buf));
+		size = write_body(is, &ohs.ostream, buf, sizeof(buf));
 	finalize_ohstream_hex(&ohs);
-	write_foot(&ofs.ostream, argv[argf], size);
+	write_foot(&ofs.ostream, argv[argf], size, *image ? &rgba : NULL,
+		   w, h, flags);
 	finalize_ofstream(&ofs);
+	if (*image)
+		finalize_rgba(&rgba);
 	finalize_ifstream(&ifs);
 	return EXIT_SUCCESS;
 }
@@ -18,4 +18,5 @@
 #
 
 libs+=lib.a
-lib.a:=gl_utils.o gl_renderer.o
+lib.a:=gl_utils.o gl_atlas.o gl_renderer.o gl3_renderer.o gl_capture.o \
+	gl_frame.o
@@ -0,0 +1,793 @@
+/*
+ * Open Greedy - an open-source version of Edromel Studio's Greedy XP
+ *
+ * Copyright (C) 2014-2017 Arnaud TROEL
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "gl3_renderer.h"
+
+#include "core/renderer.h"
+#include "gl_utils.h"
+#include "lib/std.h"
+
+struct gl3_run {
+	GLuint texture;
+	GLint first;
+	GLsizei count;
+};
+
+/* The slot of a tile in the vertex buffer is its handle. */
+struct gl3_tile {
+	struct renderer_tile tile;
+};
+
+static struct gl3_tile *to_gl3_tile(struct renderer_tile *up)
+{
+	return b6_cast_of(up, struct gl3_tile, tile);
+}
+
+struct gl3_base {
+	struct renderer_base base;
+};
+
+static struct gl3_base *to_gl3_base(struct renderer_base *up)
+{
+	return b6_cast_of(up, struct gl3_base, base);
+}
+
+static struct gl3_renderer *to_gl3_renderer(struct renderer *up)
+{
+	return b6_cast_of(up, struct gl3_renderer, renderer);
+}
+
+static const char gl3_vertex_shader[] =
+	"#version 330 core\n"
+	"layout(location = 0) in vec2 position;\n"
+	"layout(location = 1) in vec2 texcoord;\n"
+	"uniform samplerBuffer offsets;\n"
+	"uniform usamplerBuffer bases;\n"
+	"uniform vec2 scale;\n"
+	"out vec2 uv;\n"
+	"void main() {\n"
+	"	int base = int(texelFetch(bases, gl_VertexID / 6).r);\n"
+	"	vec2 p = position + texelFetch(offsets, base).xy;\n"
+	"	gl_Position = vec4(p.x * scale.x - 1., 1. - p.y * scale.y,\n"
+	"			   0., 1.);\n"
+	"	uv = texcoord;\n"
+	"}\n";
+
+static const char gl3_fragment_shader[] =
+	"#version 330 core\n"
+	"in vec2 uv;\n"
+	"uniform sampler2D image;\n"
+	"uniform float dim;\n"
+	"out vec4 color;\n"
+	"void main() {\n"
+	"	vec4 c = texture(image, uv);\n"
+	"	color = vec4(c.rgb * dim, c.a);\n"
+	"}\n";
+
+/* A single triangle covers the viewport, and every fragment picks its pixel
+ * in the tile its cell of the map refers to.
+ */
+static const char gl3_tilemap_vertex_shader[] =
+	"#version 330 core\n"
+	"void main() {\n"
+	"	vec2 p = vec2(gl_VertexID & 1, gl_VertexID >> 1) * 4. - 1.;\n"
+	"	gl_Position = vec4(p, 0., 1.);\n"
+	"}\n";
+
+static const char gl3_tilemap_fragment_shader[] =
+	"#version 330 core\n"
+	"uniform sampler2D tileset;\n"
+	"uniform usampler2D map;\n"
+	"uniform vec2 tile;\n"
+	"uniform vec2 origin;\n"
+	"out vec4 color;\n"
+	"void main() {\n"
+	"	ivec2 size = ivec2(tile);\n"
+	"	ivec2 p = ivec2(gl_FragCoord.xy);\n"
+	"	ivec2 cell = p / size;\n"
+	"	int n = int(texelFetch(map, cell, 0).r);\n"
+	"	color = texelFetch(tileset, ivec2(origin) + p - cell * size +\n"
+	"			   ivec2(n * size.x, 0), 0);\n"
+	"}\n";
+
+static GLuint compile_gl3_shader(GLenum type, const char *source)
+{
+	GLuint id;
+	GLint status;
+	gl_call(id = gl_ext_create_shader(type));
+	if (!id)
+		return 0;
+	gl_call(gl_ext_shader_source(id, 1, &source, NULL));
+	gl_call(gl_ext_compile_shader(id));
+	gl_call(gl_ext_get_shader_iv(id, GL_COMPILE_STATUS, &status));
+	if (!status) {
+		char log[512];
+		gl_call(gl_ext_get_shader_info_log(id, sizeof(log), NULL, log));
+		logf_e("could not compile shader: %s", log);
+		gl_call(gl_ext_delete_shader(id));
+		return 0;
+	}
+	return id;
+}
+
+static GLuint link_gl3_program(const char *vertex_shader,
+				const char *fragment_shader)
+{
+	GLuint vs, fs, id = 0;
+	GLint status;
+	if (!(vs = compile_gl3_shader(GL_VERTEX_SHADER, vertex_shader)))
+		goto bail_out;
+	if (!(fs = compile_gl3_shader(GL_FRAGMENT_SHADER, fragment_shader)))
+		goto delete_vs;
+	gl_call(id = gl_ext_create_program());
+	if (!id)
+		goto delete_fs;
+	gl_call(gl_ext_attach_shader(id, vs));
+	gl_call(gl_ext_attach_shader(id, fs));
+	gl_call(gl_ext_link_program(id));
+	gl_call(gl_ext_get_program_iv(id, GL_LINK_STATUS, &status));
+	if (!status) {
+		char log[512];
+		gl_call(gl_ext_get_program_info_log(id, sizeof(log), NULL,
+						    log));
+		logf_e("could not link program: %s", log);
+		gl_call(gl_ext_delete_program(id));
+		id = 0;
+	}
+delete_fs:
+	gl_call(gl_ext_delete_shader(fs));
+delete_vs:
+	gl_call(gl_ext_delete_shader(vs));
+bail_out:
+	return id;
+}
+
+static struct renderer_base *get_gl3_root(struct renderer *up)
+{
+	return &to_gl3_renderer(up)->root;
+}
+
+static void delete_gl3_base(struct renderer_base *up)
+{
+	struct gl3_base *self = to_gl3_base(up);
+	b6_deallocate(to_gl3_renderer(up->renderer)->base_allocator, self);
+}
+
+static struct renderer_base *new_gl3_base(struct renderer *up,
+					  struct renderer_base *parent,
+					  const char *name, double x, double y)
+{
+	static const struct renderer_base_ops ops = {
+		.dtor = delete_gl3_base,
+	};
+	struct gl3_renderer *renderer = to_gl3_renderer(up);
+	struct gl3_base *self = b6_allocate(renderer->base_allocator,
+					    sizeof(*self));
+	if (!self)
+		return NULL;
+	if (__setup_renderer_base(&self->base, up, parent, name, x, y, &ops)) {
+		b6_deallocate(renderer->base_allocator, self);
+		return NULL;
+	}
+	return &self->base;
+}
+
+static void delete_gl3_tile(struct renderer_tile *up)
+{
+	struct gl3_tile *self = to_gl3_tile(up);
+	b6_deallocate(to_gl3_renderer(up->renderer)->tile_allocator, self);
+}
+
+static void retexture_gl3_tile(struct renderer_tile *up,
+			       struct renderer_texture *previous)
+{
+	struct gl3_renderer *renderer = to_gl3_renderer(up->renderer);
+	set_gl_buffer_tile_uv(&renderer->srv_buffer.gl_buffer, up);
+}
+
+static void resize_gl3_tile(struct renderer_tile *up)
+{
+	struct gl3_renderer *renderer = to_gl3_renderer(up->renderer);
+	set_gl_buffer_tile(&renderer->srv_buffer.gl_buffer, up);
+}
+
+/* The base of a tile is sent with the next frame. */
+static void touch_gl3_bases(struct gl3_renderer *self, unsigned long int tile)
+{
+	if (self->bases_lo == self->bases_hi) {
+		self->bases_lo = tile;
+		self->bases_hi = tile + 1;
+		return;
+	}
+	if (self->bases_lo > tile)
+		self->bases_lo = tile;
+	if (self->bases_hi < tile + 1)
+		self->bases_hi = tile + 1;
+}
+
+static struct renderer_tile *new_gl3_tile(struct renderer *up,
+					  struct renderer_base *base,
+					  double x, double y,
+					  double w, double h,
+					  struct renderer_texture *texture)
+{
+	static const struct renderer_tile_ops ops = {
+		.dtor = delete_gl3_tile,
+		.retexture = retexture_gl3_tile,
+		.resize = resize_gl3_tile,
+	};
+	struct gl3_renderer *renderer = to_gl3_renderer(up);
+	struct gl3_tile *self;
+	/* the handle either is recycled or comes next */
+	if (fit_gl_buffer(&renderer->srv_buffer.gl_buffer,
+			  b6_array_length(&up->scene.tile_x) + 1))
+		return NULL;
+	if (!(self = b6_allocate(renderer->tile_allocator, sizeof(*self))))
+		return NULL;
+	if (__setup_renderer_tile(&self->tile, base, x, y, w, h, texture,
+				  &ops)) {
+		b6_deallocate(renderer->tile_allocator, self);
+		return NULL;
+	}
+	set_gl_buffer_tile(&renderer->srv_buffer.gl_buffer, &self->tile);
+	touch_gl3_bases(renderer, self->tile.handle);
+	return &self->tile;
+}
+
+static void delete_gl3_texture(struct renderer_texture *up)
+{
+	struct gl_texture *self = to_gl_texture(up);
+	if (self->page)
+		remove_gl_atlas_texture(self);
+	else {
+		gl_call(glDeleteTextures(1, &self->id));
+		unbind_gl_texture();
+	}
+	b6_deallocate(to_gl3_renderer(up->renderer)->texture_allocator, self);
+}
+
+static void update_gl3_texture(struct renderer_texture *up,
+			       const struct rgba *rgba)
+{
+	struct gl_texture *self = to_gl_texture(up);
+	gl_call(bind_gl_texture(self->id));
+	if (rgba->w == self->w && rgba->h == self->h) {
+		upload_gl_texture_rect(NULL, rgba, 0, 0, rgba->w, rgba->h,
+				       0, 0);
+		return;
+	}
+	self->w = rgba->w;
+	self->h = rgba->h;
+	gl_call(glPixelStorei(GL_UNPACK_ROW_LENGTH, 0));
+	gl_call(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER,
+				GL_LINEAR));
+	gl_call(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER,
+				GL_LINEAR));
+	gl_call(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S,
+				GL_CLAMP_TO_EDGE));
+	gl_call(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T,
+				GL_CLAMP_TO_EDGE));
+	gl_call(glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, rgba->w, rgba->h, 0,
+			     GL_RGBA, GL_UNSIGNED_BYTE, rgba->p));
+}
+
+static void patch_gl3_texture(struct renderer_texture *up,
+			      const struct rgba *rgba,
+			      unsigned short int x, unsigned short int y,
+			      unsigned short int w, unsigned short int h)
+{
+	struct gl_texture *self = to_gl_texture(up);
+	if (rgba->w != self->w || rgba->h != self->h) {
+		update_gl3_texture(up, rgba);
+		return;
+	}
+	gl_call(bind_gl_texture(self->id));
+	upload_gl_texture_rect(NULL, rgba, x, y, w, h, x, y);
+}
+static int setup_gl3_tilemap(struct gl3_tilemap *self)
+{
+	self->state = -1;
+	if (!gl_framebuffer_extension_is_supported())
+		return -1;
+	if (!(self->program = link_gl3_program(gl3_tilemap_vertex_shader,
+					       gl3_tilemap_fragment_shader)))
+		return -1;
+	gl_call(gl_ext_use_program(self->program));
+	gl_call(gl_ext_uniform_1i(gl_ext_get_uniform_location(self->program,
+							      "tileset"), 0));
+	gl_call(gl_ext_uniform_1i(gl_ext_get_uniform_location(self->program,
+							      "map"), 2));
+	gl_call(self->tile_location =
+		gl_ext_get_uniform_location(self->program, "tile"));
+	gl_call(self->origin_location =
+		gl_ext_get_uniform_location(self->program, "origin"));
+	gl_call(gl_ext_gen_vertex_arrays(1, &self->vao));
+	gl_call(gl_ext_gen_framebuffers(1, &self->fbo));
+	gl_call(glGenTextures(1, &self->map));
+	gl_call(gl_ext_active_texture(GL_TEXTURE2));
+	gl_call(glBindTexture(GL_TEXTURE_2D, self->map));
+	gl_call(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER,
+				GL_NEAREST));
+	gl_call(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER,
+				GL_NEAREST));
+	gl_call(gl_ext_active_texture(GL_TEXTURE0));
+	self->state = 1;
+	return 0;
+}
+
+static void finalize_gl3_tilemap(struct gl3_tilemap *self)
+{
+	if (self->state <= 0)
+		return;
+	gl_call(glDeleteTextures(1, &self->map));
+	gl_call(gl_ext_delete_framebuffers(1, &self->fbo));
+	gl_call(gl_ext_delete_vertex_arrays(1, &self->vao));
+	gl_call(gl_ext_delete_program(self->program));
+}
+
+/* Only the map is uploaded: the tiles are drawn into the texture by the
+ * tilemap program.
+ */
+static int compose_gl3_texture(struct renderer_texture *up,
+			       struct renderer_texture *tileset,
+			       const unsigned char *map,
+			       unsigned short int w, unsigned short int h,
+			       unsigned short int tw, unsigned short int th)
+{
+	struct gl_texture *self = to_gl_texture(up);
+	struct gl_texture *tiles = to_gl_texture(tileset);
+	struct gl3_renderer *renderer = to_gl3_renderer(up->renderer);
+	struct gl3_tilemap *tilemap = &renderer->tilemap;
+	/* past the border of the tileset when it lies in an atlas page */
+	GLfloat x = tiles->page ? tiles->x + 1 : 0;
+	GLfloat y = tiles->page ? tiles->y + 1 : 0;
+	GLint viewport[4];
+	GLenum status;
+	if (self->w != w * tw || self->h != h * th)
+		return -1;
+	if (!tilemap->state)
+		setup_gl3_tilemap(tilemap);
+	if (tilemap->state < 0)
+		return -1;
+	gl_call(gl_ext_bind_framebuffer(GL_FRAMEBUFFER, tilemap->fbo));
+	gl_call(gl_ext_framebuffer_texture_2d(GL_FRAMEBUFFER,
+					      GL_COLOR_ATTACHMENT0,
+					      GL_TEXTURE_2D, self->id, 0));
+	gl_call(status = gl_ext_check_framebuffer_status(GL_FRAMEBUFFER));
+	if (status != GL_FRAMEBUFFER_COMPLETE) {
+		logf_e("incomplete framebuffer 0x%04x", status);
+		gl_call(gl_ext_bind_framebuffer(GL_FRAMEBUFFER, 0));
+		return -1;
+	}
+	gl_call(gl_ext_active_texture(GL_TEXTURE2));
+	gl_call(glBindTexture(GL_TEXTURE_2D, tilemap->map));
+	gl_call(glPixelStorei(GL_UNPACK_ALIGNMENT, 1));
+	gl_call(glPixelStorei(GL_UNPACK_ROW_LENGTH, 0));
+	gl_call(glTexImage2D(GL_TEXTURE_2D, 0, GL_R8UI, w, h, 0,
+			     GL_RED_INTEGER, GL_UNSIGNED_BYTE, map));
+	gl_call(glPixelStorei(GL_UNPACK_ALIGNMENT, 4));
+	gl_call(gl_ext_active_texture(GL_TEXTURE0));
+	gl_call(bind_gl_texture(tiles->id));
+	gl_call(glGetIntegerv(GL_VIEWPORT, viewport));
+	gl_call(glViewport(0, 0, self->w, self->h));
+	gl_call(glDisable(GL_BLEND));
+	gl_call(gl_ext_use_program(tilemap->program));
+	gl_call(gl_ext_uniform_2f(tilemap->tile_location, tw, th));
+	gl_call(gl_ext_uniform_2f(tilemap->origin_location, x, y));
+	gl_call(gl_ext_bind_vertex_array(tilemap->vao));
+	gl_call(glDrawArrays(GL_TRIANGLES, 0, 3));
+	gl_call(gl_ext_bind_vertex_array(renderer->vao));
+	gl_call(gl_ext_use_program(renderer->program));
+	gl_call(glEnable(GL_BLEND));
+	gl_call(glViewport(viewport[0], viewport[1], viewport[2],
+			   viewport[3]));
+	gl_call(gl_ext_bind_framebuffer(GL_FRAMEBUFFER, 0));
+	return 0;
+}
+
+static const struct renderer_texture_ops gl3_texture_ops = {
+	.update = update_gl3_texture,
+	.patch = patch_gl3_texture,
+	.compose = compose_gl3_texture,
+	.dtor = delete_gl3_texture,
+};
+
+static void setup_gl3_texture(struct gl_texture *self,
+			      const struct rgba *rgba)
+{
+	self->page = NULL;
+	__setup_renderer_texture(&self->texture, &gl3_texture_ops);
+	self->w = self->h = 0;
+	gl_call(glGenTextures(1, &self->id));
+	update_gl3_texture(&self->texture, rgba);
+}
+
+/* Textures that change size are moved, and get out of the atlas when they do
+ * not fit anymore.
+ */
+static void update_gl3_packed_texture(struct renderer_texture *up,
+				      const struct rgba *rgba)
+{
+	struct gl_texture *self = to_gl_texture(up);
+	struct gl_atlas *atlas = &to_gl3_renderer(up->renderer)->atlas;
+	if (rgba->w + 2 == self->w && rgba->h + 2 == self->h) {
+		upload_gl_atlas_texture(atlas, self, rgba);
+		return;
+	}
+	remove_gl_atlas_texture(self);
+	atlas->retextured = 1;
+	if (!fits_gl_atlas(rgba) ||
+	    alloc_gl_atlas_texture(atlas, self, rgba->w, rgba->h))
+		setup_gl3_texture(self, rgba);
+	else
+		upload_gl_atlas_texture(atlas, self, rgba);
+}
+
+static void patch_gl3_packed_texture(struct renderer_texture *up,
+				     const struct rgba *rgba,
+				     unsigned short int x, unsigned short int y,
+				     unsigned short int w, unsigned short int h)
+{
+	struct gl3_renderer *renderer = to_gl3_renderer(up->renderer);
+	if (patch_gl_atlas_texture(&renderer->atlas, to_gl_texture(up), rgba,
+				   x, y, w, h))
+		update_gl3_packed_texture(up, rgba);
+}
+
+/* The tilemap program draws into the whole texture: the image leaves the
+ * atlas for a texture of its own first.
+ */
+static int compose_gl3_packed_texture(struct renderer_texture *up,
+				      struct renderer_texture *tileset,
+				      const unsigned char *map,
+				      unsigned short int w,
+				      unsigned short int h,
+				      unsigned short int tw,
+				      unsigned short int th)
+{
+	struct gl_texture *self = to_gl_texture(up);
+	struct rgba empty = { .p = NULL, .w = w * tw, .h = h * th, };
+	if (self->w != empty.w + 2 || self->h != empty.h + 2)
+		return -1;
+	remove_gl_atlas_texture(self);
+	to_gl3_renderer(up->renderer)->atlas.retextured = 1;
+	setup_gl3_texture(self, &empty);
+	return compose_gl3_texture(up, tileset, map, w, h, tw, th);
+}
+
+static const struct renderer_texture_ops gl3_packed_texture_ops = {
+	.update = update_gl3_packed_texture,
+	.patch = patch_gl3_packed_texture,
+	.compose = compose_gl3_packed_texture,
+	.dtor = delete_gl3_texture,
+};
+
+static struct renderer_texture *new_gl3_texture(struct renderer *up,
+						const struct rgba *rgba)
+{
+	struct gl3_renderer *renderer = to_gl3_renderer(up);
+	struct gl_texture *self = b6_allocate(renderer->texture_allocator,
+					      sizeof(*self));
+	if (!self)
+		return NULL;
+	if (fits_gl_atlas(rgba) &&
+	    !alloc_gl_atlas_texture(&renderer->atlas, self, rgba->w,
+				    rgba->h)) {
+		__setup_renderer_texture(&self->texture,
+					 &gl3_packed_texture_ops);
+		upload_gl_atlas_texture(&renderer->atlas, self, rgba);
+	} else
+		setup_gl3_texture(self, rgba);
+	return &self->texture;
+}
+
+static int add_gl3_run(struct gl3_renderer *self, struct gl3_run *run)
+{
+	struct gl3_run *last;
+	if (!run->count)
+		return 0;
+	if (!(last = b6_array_extend(&self->runs, 1)))
+		return -1;
+	*last = *run;
+	return 0;
+}
+
+/* Gathers visible tiles that share the same texture and sit in consecutive
+ * slots into runs, across bases. Tiles out of the screen are left out.
+ */
+static int gl3_layout(struct gl3_renderer *self)
+{
+	const struct renderer_scene *scene = &self->renderer.scene;
+	unsigned long int i, n = b6_array_length(&scene->order);
+	const unsigned int *order = b6_array_get(&scene->order, 0);
+	const unsigned int *base = b6_array_get(&scene->tile_base, 0);
+	struct renderer_texture *const *texture =
+		b6_array_get(&scene->tile_texture, 0);
+	const float *x = b6_array_get(&scene->tile_x, 0);
+	const float *y = b6_array_get(&scene->tile_y, 0);
+	const float *w = b6_array_get(&scene->tile_w, 0);
+	const float *h = b6_array_get(&scene->tile_h, 0);
+	const float *offset = b6_array_get(&scene->base_offset, 0);
+	const unsigned char *shown = b6_array_get(&scene->base_shown, 0);
+	float width = self->renderer.internal_width;
+	float height = self->renderer.internal_height;
+	struct gl3_run run = { .texture = 0, .first = 0, .count = 0, };
+	b6_array_clear(&self->runs);
+	for (i = 0; i < n; i += 1) {
+		unsigned int j = order[i], k = base[j];
+		float x1 = offset[2 * k] + x[j], y1 = offset[2 * k + 1] + y[j];
+		GLuint id;
+		if (!texture[j] || !shown[k] || x1 >= width || y1 >= height ||
+		    x1 + w[j] <= 0 || y1 + h[j] <= 0)
+			continue;
+		id = to_gl_texture(texture[j])->id;
+		if (id != run.texture || (GLint)j * 6 != run.first + run.count) {
+			if (add_gl3_run(self, &run))
+				return -1;
+			run.texture = id;
+			run.first = j * 6;
+			run.count = 0;
+		}
+		run.count += 6;
+	}
+	return add_gl3_run(self, &run);
+}
+
+/* Only the bases of the tiles that got a handle since the last frame are
+ * sent, unless the buffer has to grow.
+ */
+static void push_gl3_bases(struct gl3_renderer *self)
+{
+	const struct b6_array *bases = &self->renderer.scene.tile_base;
+	unsigned long int size = b6_array_memsize(bases);
+	if (self->bases_lo == self->bases_hi)
+		return;
+	gl_call(gl_ext_bind_buffer(GL_TEXTURE_BUFFER, self->bases_tbo));
+	if (size > self->bases_size) {
+		gl_call(gl_ext_buffer_data(GL_TEXTURE_BUFFER, size,
+					   b6_array_get(bases, 0),
+					   GL_DYNAMIC_DRAW));
+		self->bases_size = size;
+	} else
+		gl_call(gl_ext_buffer_sub_data(
+			GL_TEXTURE_BUFFER, self->bases_lo * sizeof(GLuint),
+			(self->bases_hi - self->bases_lo) * sizeof(GLuint),
+			b6_array_get(bases, self->bases_lo)));
+	self->bases_lo = self->bases_hi = 0;
+}
+
+static void gl3_render(struct renderer *up)
+{
+	struct gl3_renderer *self = to_gl3_renderer(up);
+	struct gl_buffer *buffer = &self->srv_buffer.gl_buffer;
+	const struct b6_array *offsets = &up->scene.base_offset;
+	unsigned long int i;
+	if (self->offscreen)
+		bind_gl_frame(self->offscreen);
+	gl_call(glClear(GL_COLOR_BUFFER_BIT));
+	self->draw_count = 0;
+	if (sweep_renderer_scene(up)) {
+		log_e(_s("out of memory"));
+		return;
+	}
+	if (self->atlas.retextured) {
+		retexture_renderer_scene(&up->scene);
+		retexture_gl_buffer(buffer, &up->scene);
+		self->atlas.retextured = 0;
+	}
+	if (gl3_layout(self)) {
+		log_e(_s("out of memory"));
+		return;
+	}
+	if (buffer->lo != buffer->hi)
+		up->nrebuilds += 1;
+	push_gl_buffer(buffer);
+	push_gl3_bases(self);
+	gl_call(gl_ext_bind_buffer(GL_TEXTURE_BUFFER, self->tbo));
+	gl_call(gl_ext_buffer_data(GL_TEXTURE_BUFFER, b6_array_memsize(offsets),
+				   b6_array_get(offsets, 0), GL_STREAM_DRAW));
+	gl_call(gl_ext_uniform_2f(self->scale_location,
+				  2. / up->internal_width,
+				  2. / up->internal_height));
+	gl_call(gl_ext_uniform_1f(self->dim_location, self->dim));
+	for (i = 0; i < b6_array_length(&self->runs); i += 1) {
+		const struct gl3_run *run = b6_array_get(&self->runs, i);
+		bind_gl_texture(run->texture);
+		gl_call(glDrawArrays(GL_TRIANGLES, run->first, run->count));
+		self->draw_count += 1;
+	}
+	up->ndraws = self->draw_count;
+	if (self->offscreen)
+		blit_gl_frame(self->offscreen, up->external_width,
+			      up->external_height);
+}
+
+static void gl3_resize(struct renderer *up)
+{
+	struct gl3_renderer *self = to_gl3_renderer(up);
+	double wi = up->internal_width;
+	double hi = up->internal_height;
+	double we = up->external_width;
+	double he = up->external_height;
+	if (we <= 0 || he <= 0 || wi <= 0 || hi <= 0)
+		return;
+	if (self->offscreen)
+		gl_call(glViewport(0, 0, wi, hi));
+	else if (we * hi > he * wi) {
+		double width = wi / hi * he;
+		gl_call(glViewport((we - width) / 2, 0, width, he));
+	} else {
+		double height = hi / wi * we;
+		gl_call(glViewport(0, (he - height) / 2, we, height));
+	}
+}
+
+static void gl3_start(struct renderer *up)
+{
+	struct gl3_renderer *self = to_gl3_renderer(up);
+	if (self->offscreen && resize_gl_frame(self->offscreen,
+					       up->internal_width,
+					       up->internal_height)) {
+		log_w(_s("drawing into the window"));
+		finalize_gl_frame(self->offscreen);
+		self->offscreen = NULL;
+	}
+	gl_call(glClearColor(.0f, .0f, .0f, 1.f));
+	gl_call(glClear(GL_COLOR_BUFFER_BIT));
+	gl_call(glDisable(GL_DEPTH_TEST));
+	gl_call(glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA));
+	gl_call(glEnable(GL_BLEND));
+	gl_call(gl_ext_use_program(self->program));
+	gl_call(gl_ext_bind_vertex_array(self->vao));
+	gl_call(gl_ext_active_texture(GL_TEXTURE0));
+	unbind_gl_texture();
+}
+
+static void gl3_stop(struct renderer *up)
+{
+	gl_call(glDisable(GL_BLEND));
+}
+
+static void gl3_dim(struct renderer *up, float value)
+{
+	to_gl3_renderer(up)->dim = value;
+}
+
+static int setup_gl3_pipeline(struct gl3_renderer *self)
+{
+	if (!(self->program = link_gl3_program(gl3_vertex_shader,
+					       gl3_fragment_shader)))
+		return -1;
+	gl_call(gl_ext_use_program(self->program));
+	gl_call(gl_ext_uniform_1i(gl_ext_get_uniform_location(self->program,
+							      "image"), 0));
+	gl_call(gl_ext_uniform_1i(gl_ext_get_uniform_location(self->program,
+							      "offsets"), 1));
+	gl_call(gl_ext_uniform_1i(gl_ext_get_uniform_location(self->program,
+							      "bases"), 3));
+	gl_call(self->scale_location =
+		gl_ext_get_uniform_location(self->program, "scale"));
+	gl_call(self->dim_location =
+		gl_ext_get_uniform_location(self->program, "dim"));
+	gl_call(gl_ext_gen_vertex_arrays(1, &self->vao));
+	gl_call(gl_ext_bind_vertex_array(self->vao));
+	/* the buffer points the attributes of the vertex array when it grows */
+	if (initialize_gl_srv_buffer(&self->srv_buffer, 1)) {
+		gl_call(gl_ext_delete_vertex_arrays(1, &self->vao));
+		gl_call(gl_ext_delete_program(self->program));
+		return -1;
+	}
+	gl_call(gl_ext_enable_vertex_attrib_array(0));
+	gl_call(gl_ext_enable_vertex_attrib_array(1));
+	gl_call(gl_ext_gen_buffers(1, &self->tbo));
+	gl_call(gl_ext_bind_buffer(GL_TEXTURE_BUFFER, self->tbo));
+	gl_call(glGenTextures(1, &self->tbo_texture));
+	gl_call(gl_ext_active_texture(GL_TEXTURE1));
+	gl_call(glBindTexture(GL_TEXTURE_BUFFER, self->tbo_texture));
+	gl_call(gl_ext_tex_buffer(GL_TEXTURE_BUFFER, GL_RG32F, self->tbo));
+	gl_call(gl_ext_gen_buffers(1, &self->bases_tbo));
+	gl_call(gl_ext_bind_buffer(GL_TEXTURE_BUFFER, self->bases_tbo));
+	gl_call(glGenTextures(1, &self->bases_texture));
+	gl_call(gl_ext_active_texture(GL_TEXTURE3));
+	gl_call(glBindTexture(GL_TEXTURE_BUFFER, self->bases_texture));
+	gl_call(gl_ext_tex_buffer(GL_TEXTURE_BUFFER, GL_R32UI,
+				  self->bases_tbo));
+	gl_call(gl_ext_active_texture(GL_TEXTURE0));
+	self->bases_size = 0;
+	self->bases_lo = self->bases_hi = 0;
+	return 0;
+}
+
+static void finalize_gl3_pipeline(struct gl3_renderer *self)
+{
+	finalize_gl_srv_buffer(&self->srv_buffer);
+	gl_call(glDeleteTextures(1, &self->bases_texture));
+	gl_call(gl_ext_delete_buffers(1, &self->bases_tbo));
+	gl_call(glDeleteTextures(1, &self->tbo_texture));
+	gl_call(gl_ext_delete_buffers(1, &self->tbo));
+	gl_call(gl_ext_delete_vertex_arrays(1, &self->vao));
+	gl_call(gl_ext_delete_program(self->program));
+}
+
+int open_gl3_renderer(struct gl3_renderer *self)
+{
+	static const struct renderer_ops ops = {
+		.get_root = get_gl3_root,
+		.new_base = new_gl3_base,
+		.new_tile = new_gl3_tile,
+		.new_texture = new_gl3_texture,
+		.start = gl3_start,
+		.stop = gl3_stop,
+		.resize = gl3_resize,
+		.render = gl3_render,
+		.dim = gl3_dim,
+	};
+	if (!gl_shader_extension_is_supported()) {
+		log_e(_s("OpenGL 3.3 is not supported"));
+		return -1;
+	}
+	if (setup_gl3_pipeline(self))
+		return -1;
+	__setup_renderer(&self->renderer, &ops);
+	if (__setup_renderer_base(&self->root, &self->renderer, NULL,
+				  "gl3_root", 0, 0, NULL)) {
+		__finalize_renderer(&self->renderer);
+		finalize_gl3_pipeline(self);
+		return -1;
+	}
+	self->dim = 1.f;
+	b6_array_initialize(&self->runs, &b6_std_allocator,
+			    sizeof(struct gl3_run));
+	b6_reset_fixed_allocator(&self->allocator, self->buffer,
+				 sizeof(self->buffer));
+	b6_pool_initialize(&self->pool, &self->allocator.allocator, 1024,
+			   sizeof(self->buffer));
+	b6_pool_initialize(&self->texture_pool, &self->pool.parent,
+			   sizeof(struct gl_texture), 1024);
+	b6_pool_initialize(&self->tile_pool, &self->pool.parent,
+			   sizeof(struct gl3_tile), 1024);
+	b6_pool_initialize(&self->base_pool, &self->pool.parent,
+			   sizeof(struct gl3_base), 1024);
+	self->texture_allocator = &self->texture_pool.parent;
+	self->tile_allocator = &self->tile_pool.parent;
+	self->base_allocator = &self->base_pool.parent;
+	initialize_gl_atlas(&self->atlas, NULL);
+	self->tilemap.state = 0;
+	self->offscreen = NULL;
+	if (!initialize_gl_frame(&self->frame)) {
+		log_i(_s("drawing offscreen"));
+		self->offscreen = &self->frame;
+	}
+	return 0;
+}
+
+void close_gl3_renderer(struct gl3_renderer *self)
+{
+	finalize_gl3_tilemap(&self->tilemap);
+	finalize_gl_atlas(&self->atlas);
+	if (self->offscreen)
+		finalize_gl_frame(self->offscreen);
+	b6_pool_finalize(&self->base_pool);
+	b6_pool_finalize(&self->tile_pool);
+	b6_pool_finalize(&self->texture_pool);
+	b6_pool_finalize(&self->pool);
+	b6_array_finalize(&self->runs);
+	__finalize_renderer(&self->renderer);
+	finalize_gl3_pipeline(self);
+}
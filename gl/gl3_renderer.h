@@ -0,0 +1,89 @@
+/*
+ * Open Greedy - an open-source version of Edromel Studio's Greedy XP
+ *
+ * Copyright (C) 2014-2017 Arnaud TROEL
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef GL3_RENDERER_H
+#define GL3_RENDERER_H
+
+#include "core/renderer.h"
+#include "gl_atlas.h"
+#include "gl_frame.h"
+#include "gl_utils.h"
+
+#include <b6/array.h>
+#include <b6/pool.h>
+
+/* Draws tilemaps into textures, once a level rather than every frame. */
+struct gl3_tilemap {
+	GLuint program;
+	GLuint vao;
+	GLuint fbo;
+	GLuint map; /* texture of tile indices */
+	GLint tile_location;
+	GLint origin_location; /* of the tileset in its texture */
+	int state; /* 0 until first used, 1 when ready, -1 when unavailable */
+};
+
+/* OpenGL 3.3 core profile renderer.
+ *
+ * The vertices of every tile sit in the slot of the vertex buffer given by its
+ * handle, and only the slots that changed are sent again. The vertex shader
+ * finds the base of a tile in a buffer texture filled from the rows of the
+ * scene, and the absolute position of all bases is streamed each frame into
+ * another: a frame is one draw call per run of tiles sharing the same texture
+ * and sitting in consecutive slots, whatever the depth of the scene. Small
+ * textures share atlas pages, so that runs go on across glyphs and sprites.
+ */
+struct gl3_renderer {
+	struct renderer renderer;
+	struct renderer_base root;
+	float dim;
+	struct b6_allocator *texture_allocator;
+	struct b6_allocator *tile_allocator;
+	struct b6_allocator *base_allocator;
+	unsigned char buffer[65536];
+	struct b6_fixed_allocator allocator;
+	struct b6_pool pool;
+	struct b6_pool texture_pool;
+	struct b6_pool tile_pool;
+	struct b6_pool base_pool;
+	struct gl_atlas atlas;
+	struct gl_srv_buffer srv_buffer;
+	struct b6_array runs; /* struct gl3_run */
+	GLuint vao;
+	GLuint tbo; /* absolute position of every base */
+	GLuint tbo_texture;
+	GLuint bases_tbo; /* base of every tile */
+	GLuint bases_texture;
+	unsigned long int bases_size; /* in bytes */
+	unsigned long int bases_lo, bases_hi; /* tiles whose base is not sent */
+	GLuint program;
+	GLint scale_location;
+	GLint dim_location;
+	struct gl3_tilemap tilemap;
+	struct gl_frame frame;
+	struct gl_frame *offscreen; /* NULL when drawing into the window */
+	int draw_count;
+};
+
+/* Must be called with a 3.3 core profile context current. */
+extern int open_gl3_renderer(struct gl3_renderer *self);
+
+extern void close_gl3_renderer(struct gl3_renderer *self);
+
+#endif /* GL3_RENDERER_H */
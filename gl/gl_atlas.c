@@ -0,0 +1,399 @@
+/*
+ * Open Greedy - an open-source version of Edromel Studio's Greedy XP
+ *
+ * Copyright (C) 2014-2017 Arnaud TROEL
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "gl_atlas.h"
+
+#include <b6/cmdline.h>
+
+#include "lib/std.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+static int gl_atlas = 1;
+b6_flag(gl_atlas, bool);
+
+static void reset_gl_atlas_page(struct gl_atlas_page *self)
+{
+	b6_list_initialize(&self->textures);
+	self->area = 0;
+	self->top = 0;
+	self->nshelves = 0;
+}
+
+static struct gl_atlas_page *new_gl_atlas_page(struct gl_atlas *atlas)
+{
+	struct gl_atlas_page *self = b6_allocate(&b6_std_allocator,
+						 sizeof(*self));
+	if (!self) {
+		log_e(_s("out of memory"));
+		return NULL;
+	}
+	/* no pixels: the texture storage is allocated but left uninitialized.
+	 * The border of the images keeps sampling within them, whatever the
+	 * wrap mode.
+	 */
+	gl_call(glGenTextures(1, &self->id));
+	gl_call(bind_gl_texture(self->id));
+	gl_call(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER,
+				GL_LINEAR));
+	gl_call(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER,
+				GL_LINEAR));
+	gl_call(glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, GL_ATLAS_PAGE_SIZE,
+			     GL_ATLAS_PAGE_SIZE, 0, GL_RGBA, GL_UNSIGNED_BYTE,
+			     NULL));
+	reset_gl_atlas_page(self);
+	b6_list_add_last(&atlas->pages, &self->dref);
+	logf_i("new atlas page #%u", self->id);
+	return self;
+}
+
+static void delete_gl_atlas_page(struct gl_atlas_page *self)
+{
+	b6_list_del(&self->dref);
+	gl_call(glDeleteTextures(1, &self->id));
+	unbind_gl_texture();
+	b6_deallocate(&b6_std_allocator, self);
+}
+
+/* Picks the lowest shelf that can take a w x h image, unless it would waste
+ * more than a quarter of its height and there is room for a new shelf.
+ */
+static int find_gl_atlas_room(struct gl_atlas_page *self,
+			      unsigned short int w, unsigned short int h,
+			      unsigned short int *x, unsigned short int *y)
+{
+	struct gl_atlas_shelf *shelf, *best = NULL;
+	int i;
+	for (i = 0; i < self->nshelves; i += 1) {
+		shelf = &self->shelves[i];
+		if (shelf->h < h || shelf->x + w > GL_ATLAS_PAGE_SIZE)
+			continue;
+		if (!best || shelf->h < best->h)
+			best = shelf;
+	}
+	if ((!best || (best->h - h) * 4 > best->h) &&
+	    self->nshelves < GL_ATLAS_MAX_SHELVES &&
+	    self->top + h <= GL_ATLAS_PAGE_SIZE) {
+		best = &self->shelves[self->nshelves++];
+		best->x = 0;
+		best->y = self->top;
+		best->h = h;
+		self->top += h;
+	}
+	if (!best)
+		return -1;
+	*x = best->x;
+	*y = best->y;
+	best->x += w;
+	return 0;
+}
+
+static void place_gl_atlas_texture(struct gl_atlas_page *page,
+				   struct gl_texture *texture,
+				   unsigned short int x, unsigned short int y)
+{
+	const float scale = 1.f / GL_ATLAS_PAGE_SIZE;
+	texture->page = page;
+	texture->id = page->id;
+	texture->x = x;
+	texture->y = y;
+	texture->texture.u1 = (x + 1) * scale;
+	texture->texture.v1 = (y + 1) * scale;
+	texture->texture.u2 = (x + texture->w - 1) * scale;
+	texture->texture.v2 = (y + texture->h - 1) * scale;
+	page->area += texture->w * texture->h;
+	b6_list_add_last(&page->textures, &texture->dref);
+}
+
+static int insert_gl_atlas_texture(struct gl_atlas *atlas,
+				   struct gl_texture *texture)
+{
+	struct gl_atlas_page *page;
+	struct b6_dref *dref;
+	unsigned short int x, y;
+	for (dref = b6_list_first(&atlas->pages);
+	     dref != b6_list_tail(&atlas->pages);
+	     dref = b6_list_walk(dref, B6_NEXT)) {
+		page = b6_cast_of(dref, struct gl_atlas_page, dref);
+		if (!find_gl_atlas_room(page, texture->w, texture->h, &x, &y))
+			goto done;
+	}
+	if (!(page = new_gl_atlas_page(atlas)))
+		return -1;
+	if (find_gl_atlas_room(page, texture->w, texture->h, &x, &y))
+		return -1; /* NOT REACHED */
+done:
+	place_gl_atlas_texture(page, texture, x, y);
+	return 0;
+}
+
+void remove_gl_atlas_texture(struct gl_texture *texture)
+{
+	struct gl_atlas_page *page = texture->page;
+	b6_list_del(&texture->dref);
+	page->area -= texture->w * texture->h;
+	if (b6_list_empty(&page->textures))
+		reset_gl_atlas_page(page);
+	texture->page = NULL;
+}
+
+/* Shelves only get their room back once their page is empty: tell whether
+ * the room lost this way would be worth a repack.
+ */
+static int gl_atlas_is_fragmented(struct gl_atlas *atlas)
+{
+	unsigned long int lost = 0;
+	struct b6_dref *dref;
+	for (dref = b6_list_first(&atlas->pages);
+	     dref != b6_list_tail(&atlas->pages);
+	     dref = b6_list_walk(dref, B6_NEXT)) {
+		struct gl_atlas_page *page =
+			b6_cast_of(dref, struct gl_atlas_page, dref);
+		lost += page->top * GL_ATLAS_PAGE_SIZE - page->area;
+	}
+	return lost > GL_ATLAS_PAGE_SIZE * GL_ATLAS_PAGE_SIZE / 2;
+}
+
+struct gl_atlas_entry {
+	struct gl_texture *texture;
+	const struct rgba *from;
+	unsigned short int x, y; /* in the page read back */
+	struct gl_atlas_page *page; /* that the texture goes to */
+	unsigned short int to_x, to_y;
+};
+
+static int compare_gl_atlas_entries(const void *lhs, const void *rhs)
+{
+	const struct gl_atlas_entry *l = lhs, *r = rhs;
+	return r->texture->h - l->texture->h;
+}
+
+/* Lays the entries out on shelves that are reset copies of the pages, without
+ * touching the pages yet. Fails if they would not fit in as many pages.
+ */
+static int plan_gl_atlas(struct gl_atlas *atlas,
+			 struct gl_atlas_page *plan, unsigned long int npages,
+			 struct gl_atlas_entry *entries,
+			 unsigned long int nentries)
+{
+	struct b6_dref *dref;
+	unsigned long int i, j;
+	for (i = 0; i < npages; i += 1)
+		reset_gl_atlas_page(&plan[i]);
+	for (j = 0; j < nentries; j += 1) {
+		const struct gl_texture *t = entries[j].texture;
+		for (i = 0, dref = b6_list_first(&atlas->pages);
+		     i < npages; i += 1, dref = b6_list_walk(dref, B6_NEXT))
+			if (!find_gl_atlas_room(&plan[i], t->w, t->h,
+						&entries[j].to_x,
+						&entries[j].to_y))
+				break;
+		if (i >= npages)
+			return -1;
+		entries[j].page = b6_cast_of(dref, struct gl_atlas_page, dref);
+	}
+	return 0;
+}
+
+/* Reads back all pages, then inserts their textures again from the tallest
+ * to the shortest, which makes shelves as tight as possible. Nothing changes
+ * when that would take more pages than before.
+ */
+static int repack_gl_atlas(struct gl_atlas *atlas)
+{
+	struct gl_atlas_entry *entries;
+	struct gl_atlas_page *plan;
+	struct rgba *rgba;
+	struct b6_dref *dref, *iter;
+	unsigned long int npages = 0, nentries = 0, i, j;
+	int retval = -1;
+	for (dref = b6_list_first(&atlas->pages);
+	     dref != b6_list_tail(&atlas->pages);
+	     dref = b6_list_walk(dref, B6_NEXT)) {
+		struct gl_atlas_page *page =
+			b6_cast_of(dref, struct gl_atlas_page, dref);
+		for (iter = b6_list_first(&page->textures);
+		     iter != b6_list_tail(&page->textures);
+		     iter = b6_list_walk(iter, B6_NEXT))
+			nentries += 1;
+		npages += 1;
+	}
+	/* pages read back, then pages uploaded */
+	rgba = b6_allocate(&b6_std_allocator, 2 * npages * sizeof(*rgba));
+	plan = b6_allocate(&b6_std_allocator, npages * sizeof(*plan));
+	entries = b6_allocate(&b6_std_allocator, nentries * sizeof(*entries));
+	if (!rgba || !plan || !entries)
+		goto bail_out;
+	i = j = 0;
+	for (dref = b6_list_first(&atlas->pages);
+	     dref != b6_list_tail(&atlas->pages);
+	     dref = b6_list_walk(dref, B6_NEXT), i += 1) {
+		struct gl_atlas_page *page =
+			b6_cast_of(dref, struct gl_atlas_page, dref);
+		for (iter = b6_list_first(&page->textures);
+		     iter != b6_list_tail(&page->textures);
+		     iter = b6_list_walk(iter, B6_NEXT), j += 1) {
+			entries[j].texture = b6_cast_of(iter, struct gl_texture,
+							dref);
+			entries[j].from = &rgba[i];
+			entries[j].x = entries[j].texture->x;
+			entries[j].y = entries[j].texture->y;
+		}
+	}
+	qsort(entries, nentries, sizeof(*entries), compare_gl_atlas_entries);
+	if (plan_gl_atlas(atlas, plan, npages, entries, nentries))
+		goto bail_out;
+	for (i = 0; i < 2 * npages; i += 1)
+		if (initialize_rgba(&rgba[i], GL_ATLAS_PAGE_SIZE,
+				    GL_ATLAS_PAGE_SIZE)) {
+			while (i--)
+				finalize_rgba(&rgba[i]);
+			goto bail_out;
+		}
+	for (i = 0, dref = b6_list_first(&atlas->pages);
+	     dref != b6_list_tail(&atlas->pages);
+	     dref = b6_list_walk(dref, B6_NEXT), i += 1) {
+		struct gl_atlas_page *page =
+			b6_cast_of(dref, struct gl_atlas_page, dref);
+		gl_call(bind_gl_texture(page->id));
+		gl_call(glPixelStorei(GL_PACK_ROW_LENGTH, 0));
+		gl_call(glGetTexImage(GL_TEXTURE_2D, 0, GL_RGBA,
+				      GL_UNSIGNED_BYTE, rgba[i].p));
+		reset_gl_atlas_page(page);
+		page->top = plan[i].top;
+		page->nshelves = plan[i].nshelves;
+		memcpy(page->shelves, plan[i].shelves,
+		       sizeof(page->shelves));
+	}
+	for (j = 0; j < nentries; j += 1)
+		place_gl_atlas_texture(entries[j].page, entries[j].texture,
+				       entries[j].to_x, entries[j].to_y);
+	for (i = 0, dref = b6_list_first(&atlas->pages);
+	     dref != b6_list_tail(&atlas->pages);
+	     dref = b6_list_walk(dref, B6_NEXT), i += 1) {
+		struct gl_atlas_page *page =
+			b6_cast_of(dref, struct gl_atlas_page, dref);
+		struct rgba *to = &rgba[npages + i];
+		for (j = 0; j < nentries; j += 1) {
+			const struct gl_texture *t = entries[j].texture;
+			if (t->page == page)
+				copy_rgba(entries[j].from, entries[j].x,
+					  entries[j].y, t->w, t->h, to,
+					  t->x, t->y);
+		}
+		gl_call(bind_gl_texture(page->id));
+		gl_call(glPixelStorei(GL_UNPACK_ROW_LENGTH, 0));
+		gl_call(glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0,
+					GL_ATLAS_PAGE_SIZE, GL_ATLAS_PAGE_SIZE,
+					GL_RGBA, GL_UNSIGNED_BYTE, to->p));
+	}
+	for (i = 0; i < 2 * npages; i += 1)
+		finalize_rgba(&rgba[i]);
+	atlas->retextured = 1;
+	retval = 0;
+bail_out:
+	if (retval)
+		log_w(_s("could not repack atlas"));
+	b6_deallocate(&b6_std_allocator, entries);
+	b6_deallocate(&b6_std_allocator, plan);
+	b6_deallocate(&b6_std_allocator, rgba);
+	return retval;
+}
+
+int alloc_gl_atlas_texture(struct gl_atlas *atlas, struct gl_texture *texture,
+			   unsigned short int w, unsigned short int h)
+{
+	struct b6_dref *dref;
+	unsigned short int x, y;
+	texture->w = w + 2;
+	texture->h = h + 2;
+	for (dref = b6_list_first(&atlas->pages);
+	     dref != b6_list_tail(&atlas->pages);
+	     dref = b6_list_walk(dref, B6_NEXT)) {
+		struct gl_atlas_page *page =
+			b6_cast_of(dref, struct gl_atlas_page, dref);
+		if (!find_gl_atlas_room(page, texture->w, texture->h, &x, &y)) {
+			place_gl_atlas_texture(page, texture, x, y);
+			return 0;
+		}
+	}
+	if (gl_atlas_is_fragmented(atlas))
+		repack_gl_atlas(atlas);
+	return insert_gl_atlas_texture(atlas, texture);
+}
+
+/* Images are surrounded by a copy of their edges so that linear filtering
+ * never samples their neighbors in the page.
+ */
+void upload_gl_atlas_texture(struct gl_atlas *atlas, struct gl_texture *self,
+			     const struct rgba *rgba)
+{
+	struct rgba temp;
+	unsigned short int w = rgba->w, h = rgba->h;
+	if (initialize_rgba(&temp, self->w, self->h)) {
+		log_e(_s("out of memory"));
+		return;
+	}
+	copy_rgba(rgba, 0, 0, w, h, &temp, 1, 1);
+	copy_rgba(rgba, 0, 0, w, 1, &temp, 1, 0);
+	copy_rgba(rgba, 0, h - 1, w, 1, &temp, 1, h + 1);
+	copy_rgba(&temp, 1, 0, 1, h + 2, &temp, 0, 0);
+	copy_rgba(&temp, w, 0, 1, h + 2, &temp, w + 1, 0);
+	gl_call(bind_gl_texture(self->id));
+	upload_gl_texture_rect(atlas->pbo, &temp, 0, 0, self->w, self->h,
+			       self->x, self->y);
+	finalize_rgba(&temp);
+}
+
+int fits_gl_atlas(const struct rgba *rgba)
+{
+	return gl_atlas && rgba->w && rgba->h &&
+		rgba->w + 2 <= GL_ATLAS_MAX_ENTRY_SIZE &&
+		rgba->h + 2 <= GL_ATLAS_MAX_ENTRY_SIZE;
+}
+
+/* Rectangles that touch the edges of the image also change its border. */
+int patch_gl_atlas_texture(struct gl_atlas *atlas, struct gl_texture *self,
+			   const struct rgba *rgba,
+			   unsigned short int x, unsigned short int y,
+			   unsigned short int w, unsigned short int h)
+{
+	if (rgba->w + 2 != self->w || rgba->h + 2 != self->h ||
+	    !x || !y || x + w >= rgba->w || y + h >= rgba->h)
+		return -1;
+	gl_call(bind_gl_texture(self->id));
+	upload_gl_texture_rect(atlas->pbo, rgba, x, y, w, h,
+			       self->x + 1 + x, self->y + 1 + y);
+	return 0;
+}
+
+void initialize_gl_atlas(struct gl_atlas *self, struct gl_pbo_ring *pbo)
+{
+	b6_list_initialize(&self->pages);
+	self->pbo = pbo;
+	self->retextured = 0;
+}
+
+void finalize_gl_atlas(struct gl_atlas *self)
+{
+	while (!b6_list_empty(&self->pages))
+		delete_gl_atlas_page(b6_cast_of(b6_list_first(&self->pages),
+						struct gl_atlas_page, dref));
+}
@@ -0,0 +1,104 @@
+/*
+ * Open Greedy - an open-source version of Edromel Studio's Greedy XP
+ *
+ * Copyright (C) 2014-2017 Arnaud TROEL
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef GL_ATLAS_H
+#define GL_ATLAS_H
+
+#include "core/renderer.h"
+#include "gl_utils.h"
+
+#include <b6/list.h>
+
+/* Textures small enough are packed into shared pages, so that consecutive
+ * tiles showing different images can be drawn with a single texture bound.
+ * Pages are filled by shelves: rows of images of similar heights.
+ */
+#define GL_ATLAS_PAGE_SIZE 1024
+#define GL_ATLAS_MAX_ENTRY_SIZE 256
+#define GL_ATLAS_MAX_SHELVES 64
+
+struct gl_atlas_shelf {
+	unsigned short int x, y, h;
+};
+
+struct gl_atlas_page {
+	struct b6_dref dref;
+	GLuint id;
+	struct b6_list textures;
+	unsigned long int area; /* of the textures in this page */
+	unsigned short int top; /* height taken by the shelves */
+	unsigned short int nshelves;
+	struct gl_atlas_shelf shelves[GL_ATLAS_MAX_SHELVES];
+};
+
+struct gl_texture {
+	struct renderer_texture texture;
+	GLuint id; /* of the atlas page for textures that belong to one */
+	struct gl_atlas_page *page; /* NULL for textures of their own */
+	struct b6_dref dref;
+	/* in the page and border included, or the size of the image for
+	 * textures of their own.
+	 */
+	unsigned short int x, y, w, h;
+};
+
+static inline struct gl_texture *to_gl_texture(struct renderer_texture *up)
+{
+	return b6_cast_of(up, struct gl_texture, texture);
+}
+
+struct gl_atlas {
+	struct b6_list pages;
+	struct gl_pbo_ring *pbo; /* NULL when uploading from client memory */
+	int retextured; /* textures moved: all tiles need new coordinates */
+};
+
+extern void initialize_gl_atlas(struct gl_atlas *self,
+				struct gl_pbo_ring *pbo);
+
+extern void finalize_gl_atlas(struct gl_atlas *self);
+
+/* Tells whether an image of this size can go to an atlas page at all. */
+extern int fits_gl_atlas(const struct rgba *rgba);
+
+/* Finds room for a w x h image, repacking the pages or adding one as needed,
+ * and sets the texture coordinates of the texture accordingly.
+ */
+extern int alloc_gl_atlas_texture(struct gl_atlas *self,
+				  struct gl_texture *texture,
+				  unsigned short int w, unsigned short int h);
+
+extern void remove_gl_atlas_texture(struct gl_texture *texture);
+
+/* Uploads the whole image, which must have the size it was allocated for. */
+extern void upload_gl_atlas_texture(struct gl_atlas *self,
+				    struct gl_texture *texture,
+				    const struct rgba *rgba);
+
+/* Uploads a rectangle of the image. Returns -1 when the whole image has to be
+ * uploaded again instead, because the rectangle touches its border or the
+ * image changed size.
+ */
+extern int patch_gl_atlas_texture(struct gl_atlas *self,
+				  struct gl_texture *texture,
+				  const struct rgba *rgba,
+				  unsigned short int x, unsigned short int y,
+				  unsigned short int w, unsigned short int h);
+
+#endif /* GL_ATLAS_H */
@@ -0,0 +1,95 @@
+/*
+ * Open Greedy - an open-source version of Edromel Studio's Greedy XP
+ *
+ * Copyright (C) 2014-2017 Arnaud TROEL
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "gl_capture.h"
+
+#include <string.h>
+
+#include "core/rgba.h"
+#include "lib/log.h"
+#include "lib/std.h"
+
+int initialize_gl_capture(struct gl_capture *self)
+{
+	if (!gl_pbo_is_supported()) {
+		log_w(_s("capture needs pixel buffer objects"));
+		return -1;
+	}
+	gl_call(gl_ext_gen_buffers(GL_CAPTURE_DEPTH, self->pbo));
+	self->head = self->count = 0;
+	return 0;
+}
+
+void finalize_gl_capture(struct gl_capture *self)
+{
+	gl_call(gl_ext_bind_buffer(GL_PIXEL_PACK_BUFFER, 0));
+	gl_call(gl_ext_delete_buffers(GL_CAPTURE_DEPTH, self->pbo));
+}
+
+int read_gl_capture(struct gl_capture *self,
+		    unsigned short int w, unsigned short int h)
+{
+	unsigned int i;
+	if (gl_capture_is_full(self))
+		return -1;
+	i = (self->head + self->count) % GL_CAPTURE_DEPTH;
+	gl_call(gl_ext_bind_buffer(GL_PIXEL_PACK_BUFFER, self->pbo[i]));
+	gl_call(gl_ext_buffer_data(GL_PIXEL_PACK_BUFFER, 4UL * w * h, NULL,
+				   GL_STREAM_READ));
+	gl_call(glPixelStorei(GL_PACK_ALIGNMENT, 4));
+	gl_call(glReadPixels(0, 0, w, h, GL_RGBA, GL_UNSIGNED_BYTE, NULL));
+	gl_call(gl_ext_bind_buffer(GL_PIXEL_PACK_BUFFER, 0));
+	self->w[i] = w;
+	self->h[i] = h;
+	self->count += 1;
+	return 0;
+}
+
+void peek_gl_capture(const struct gl_capture *self,
+		     unsigned short int *w, unsigned short int *h)
+{
+	*w = self->w[self->head];
+	*h = self->h[self->head];
+}
+
+int collect_gl_capture(struct gl_capture *self, struct rgba *rgba)
+{
+	unsigned int i = self->head;
+	unsigned long int pitch = 4UL * self->w[i];
+	const unsigned char *src = NULL;
+	unsigned char *dst;
+	unsigned short int n;
+	int retval = 0;
+	if (gl_capture_is_empty(self))
+		return -1;
+	self->head = (self->head + 1) % GL_CAPTURE_DEPTH;
+	self->count -= 1;
+	gl_call(gl_ext_bind_buffer(GL_PIXEL_PACK_BUFFER, self->pbo[i]));
+	gl_call(src = gl_ext_map_buffer(GL_PIXEL_PACK_BUFFER, GL_READ_ONLY));
+	if (src) {
+		/* OpenGL rows go bottom up */
+		dst = rgba->p + pitch * self->h[i];
+		for (n = self->h[i]; n--; src += pitch)
+			memcpy(dst -= pitch, src, pitch);
+		gl_call(gl_ext_unmap_buffer(GL_PIXEL_PACK_BUFFER));
+	} else
+		retval = -1;
+	gl_call(gl_ext_bind_buffer(GL_PIXEL_PACK_BUFFER, 0));
+	return retval;
+}
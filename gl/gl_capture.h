@@ -0,0 +1,70 @@
+/*
+ * Open Greedy - an open-source version of Edromel Studio's Greedy XP
+ *
+ * Copyright (C) 2014-2017 Arnaud TROEL
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef GL_CAPTURE_H
+#define GL_CAPTURE_H
+
+#include "gl_utils.h"
+
+struct rgba;
+
+/* Frames are read back into pixel buffer objects, and only mapped once the
+ * next ones have been queued, by when the transfer is over and mapping does
+ * not stall.
+ */
+#define GL_CAPTURE_DEPTH 3
+
+struct gl_capture {
+	GLuint pbo[GL_CAPTURE_DEPTH];
+	unsigned short int w[GL_CAPTURE_DEPTH];
+	unsigned short int h[GL_CAPTURE_DEPTH];
+	unsigned int head; /* oldest pending readback */
+	unsigned int count; /* of pending readbacks */
+};
+
+extern int initialize_gl_capture(struct gl_capture *self);
+
+extern void finalize_gl_capture(struct gl_capture *self);
+
+static inline int gl_capture_is_full(const struct gl_capture *self)
+{
+	return self->count == GL_CAPTURE_DEPTH;
+}
+
+static inline int gl_capture_is_empty(const struct gl_capture *self)
+{
+	return !self->count;
+}
+
+/* Queues a readback of the w x h lower left corner of the color buffer.
+ * Returns -1 when the capture is full.
+ */
+extern int read_gl_capture(struct gl_capture *self,
+			   unsigned short int w, unsigned short int h);
+
+/* Size of the image that collect_gl_capture would return. */
+extern void peek_gl_capture(const struct gl_capture *self,
+			    unsigned short int *w, unsigned short int *h);
+
+/* Copies the oldest readback top down into rgba, that must have its size.
+ * Returns -1 when the capture is empty or the buffer cannot be mapped.
+ */
+extern int collect_gl_capture(struct gl_capture *self, struct rgba *rgba);
+
+#endif /* GL_CAPTURE_H */
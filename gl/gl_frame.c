@@ -0,0 +1,121 @@
+/*
+ * Open Greedy - an open-source version of Edromel Studio's Greedy XP
+ *
+ * Copyright (C) 2014-2017 Arnaud TROEL
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "gl_frame.h"
+
+#include <b6/cmdline.h>
+#include <string.h>
+
+#include "lib/log.h"
+#include "lib/std.h"
+
+/* "off" draws straight into the window, "nearest" and "linear" stretch the
+ * frame to the window keeping its aspect ratio, and "integer" magnifies it by
+ * the largest whole factor that fits.
+ */
+static const char *gl_scale = "nearest";
+b6_flag(gl_scale, string);
+
+int initialize_gl_frame(struct gl_frame *self)
+{
+	if (!strcmp(gl_scale, "off"))
+		return -1;
+	if (!gl_fbo_is_supported()) {
+		log_w(_s("framebuffer objects are not supported"));
+		return -1;
+	}
+	self->filter = GL_NEAREST;
+	self->integer = 0;
+	if (!strcmp(gl_scale, "linear"))
+		self->filter = GL_LINEAR;
+	else if (!strcmp(gl_scale, "integer"))
+		self->integer = 1;
+	else if (strcmp(gl_scale, "nearest"))
+		log_w(_s("unknown scaling "), _s(gl_scale));
+	gl_call(gl_ext_gen_framebuffers(1, &self->fbo));
+	gl_call(gl_ext_gen_renderbuffers(1, &self->rbo));
+	self->w = self->h = 0;
+	return 0;
+}
+
+void finalize_gl_frame(struct gl_frame *self)
+{
+	gl_call(gl_ext_bind_framebuffer(GL_FRAMEBUFFER, 0));
+	gl_call(gl_ext_delete_renderbuffers(1, &self->rbo));
+	gl_call(gl_ext_delete_framebuffers(1, &self->fbo));
+}
+
+int resize_gl_frame(struct gl_frame *self,
+		    unsigned short int w, unsigned short int h)
+{
+	GLenum status;
+	if (w == self->w && h == self->h)
+		return 0;
+	gl_call(gl_ext_bind_renderbuffer(GL_RENDERBUFFER, self->rbo));
+	gl_call(gl_ext_renderbuffer_storage(GL_RENDERBUFFER, GL_RGBA8, w, h));
+	gl_call(gl_ext_bind_renderbuffer(GL_RENDERBUFFER, 0));
+	gl_call(gl_ext_bind_framebuffer(GL_FRAMEBUFFER, self->fbo));
+	gl_call(gl_ext_framebuffer_renderbuffer(GL_FRAMEBUFFER,
+						GL_COLOR_ATTACHMENT0,
+						GL_RENDERBUFFER, self->rbo));
+	gl_call(status = gl_ext_check_framebuffer_status(GL_FRAMEBUFFER));
+	gl_call(gl_ext_bind_framebuffer(GL_FRAMEBUFFER, 0));
+	if (status != GL_FRAMEBUFFER_COMPLETE) {
+		logf_e("incomplete framebuffer 0x%04x", status);
+		self->w = self->h = 0;
+		return -1;
+	}
+	self->w = w;
+	self->h = h;
+	return 0;
+}
+
+void bind_gl_frame(const struct gl_frame *self)
+{
+	gl_call(gl_ext_bind_framebuffer(GL_FRAMEBUFFER, self->fbo));
+}
+
+void blit_gl_frame(const struct gl_frame *self,
+		   unsigned short int w, unsigned short int h)
+{
+	unsigned long int dw = w, dh = h;
+	unsigned short int k = 0;
+	unsigned short int x, y;
+	if (self->integer) {
+		k = w / self->w;
+		if (k > h / self->h)
+			k = h / self->h;
+	}
+	if (k) {
+		dw = k * self->w;
+		dh = k * self->h;
+	} else if (dw * self->h > dh * self->w)
+		dw = dh * self->w / self->h;
+	else
+		dh = dw * self->h / self->w;
+	x = (w - dw) / 2;
+	y = (h - dh) / 2;
+	gl_call(gl_ext_bind_framebuffer(GL_READ_FRAMEBUFFER, self->fbo));
+	gl_call(gl_ext_bind_framebuffer(GL_DRAW_FRAMEBUFFER, 0));
+	gl_call(glClear(GL_COLOR_BUFFER_BIT));
+	gl_call(gl_ext_blit_framebuffer(0, 0, self->w, self->h,
+					x, y, x + dw, y + dh,
+					GL_COLOR_BUFFER_BIT, self->filter));
+	gl_call(gl_ext_bind_framebuffer(GL_FRAMEBUFFER, 0));
+}
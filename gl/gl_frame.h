@@ -0,0 +1,55 @@
+/*
+ * Open Greedy - an open-source version of Edromel Studio's Greedy XP
+ *
+ * Copyright (C) 2014-2017 Arnaud TROEL
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef GL_FRAME_H
+#define GL_FRAME_H
+
+#include "gl_utils.h"
+
+/* Frames are drawn into an offscreen framebuffer of the internal size of the
+ * renderer, then scaled into the window with a single blit: drawing costs the
+ * same whatever the size of the screen.
+ */
+struct gl_frame {
+	GLuint fbo;
+	GLuint rbo;
+	unsigned short int w, h;
+	GLenum filter;
+	int integer; /* scales by whole factors when the window is big enough */
+};
+
+/* Returns -1 when framebuffer objects are not supported or not wanted. */
+extern int initialize_gl_frame(struct gl_frame *self);
+
+extern void finalize_gl_frame(struct gl_frame *self);
+
+/* Allocates the storage of the frame unless it has the size already. */
+extern int resize_gl_frame(struct gl_frame *self,
+			   unsigned short int w, unsigned short int h);
+
+/* Makes the next drawing commands go to the frame. */
+extern void bind_gl_frame(const struct gl_frame *self);
+
+/* Scales the frame into the w x h window, with black borders if need be, and
+ * makes the window the target of the following commands.
+ */
+extern void blit_gl_frame(const struct gl_frame *self,
+			  unsigned short int w, unsigned short int h);
+
+#endif /* GL_FRAME_H */
@@ -25,21 +25,20 @@
 
 #include "core/renderer.h"
 #include "gl_utils.h"
+#include "lib/std.h"
 
+#include <stdlib.h>
+
+/* forces power-of-two textures, which are otherwise only used when the
+ * driver does not support others.
+ */
 static int gl_pot = 0;
 b6_flag(gl_pot, bool);
 
-struct gl_texture {
-	struct renderer_texture texture;
-	GLuint id;
-	double w, h;
-};
-
-static struct gl_texture *to_gl_texture(struct renderer_texture *up)
-{
-	return b6_cast_of(up, struct gl_texture, texture);
-}
+static int gl_pbo = 1;
+b6_flag(gl_pbo, bool);
 
+/* The slot of a tile in the gl buffer is its handle. */
 struct gl_tile {
 	struct renderer_tile tile;
 };
@@ -85,16 +84,28 @@ static struct renderer_base *new_gl_base(struct renderer *up,
 					     sizeof(*self));
 	if (!self)
 		return NULL;
-	__setup_renderer_base(&self->base, parent, name, x, y, &ops);
+	if (__setup_renderer_base(&self->base, up, parent, name, x, y, &ops)) {
+		b6_deallocate(renderer->base_allocator, self);
+		return NULL;
+	}
 	return &self->base;
 }
 
 static void delete_gl_tile(struct renderer_tile *up)
 {
 	struct gl_tile *self = to_gl_tile(up);
-	struct gl_renderer *renderer = to_gl_renderer(up->renderer);
-	b6_deallocate(renderer->tile_allocator, self);
-	renderer->dirty = 1;
+	b6_deallocate(to_gl_renderer(up->renderer)->tile_allocator, self);
+}
+
+static void retexture_gl_tile(struct renderer_tile *up,
+			      struct renderer_texture *previous)
+{
+	set_gl_buffer_tile_uv(to_gl_renderer(up->renderer)->gl_buffer, up);
+}
+
+static void resize_gl_tile(struct renderer_tile *up)
+{
+	set_gl_buffer_tile(to_gl_renderer(up->renderer)->gl_buffer, up);
 }
 
 struct renderer_tile *new_gl_tile(struct renderer *up,
@@ -102,31 +113,39 @@ struct renderer_tile *new_gl_tile(struct renderer *up,
 				  double x, double y, double w, double h,
 				  struct renderer_texture *texture)
 {
-	static const struct renderer_tile_ops ops = { .dtor = delete_gl_tile, };
+	static const struct renderer_tile_ops ops = {
+		.dtor = delete_gl_tile,
+		.retexture = retexture_gl_tile,
+		.resize = resize_gl_tile,
+	};
 	struct gl_renderer *renderer = to_gl_renderer(up);
-	struct gl_tile *self = b6_allocate(renderer->tile_allocator,
-					      sizeof(*self));
-	if (!self)
+	struct gl_tile *self;
+	/* the handle either is recycled or comes next */
+	if (fit_gl_buffer(renderer->gl_buffer,
+			  b6_array_length(&up->scene.tile_x) + 1))
 		return NULL;
-	__setup_renderer_tile(&self->tile, base, x, y, w, h, texture, &ops);
-	renderer->dirty = 1;
+	if (!(self = b6_allocate(renderer->tile_allocator, sizeof(*self))))
+		return NULL;
+	if (__setup_renderer_tile(&self->tile, base, x, y, w, h, texture,
+				  &ops)) {
+		b6_deallocate(renderer->tile_allocator, self);
+		return NULL;
+	}
+	set_gl_buffer_tile(renderer->gl_buffer, &self->tile);
 	return &self->tile;
 }
 
 static void delete_gl_texture(struct renderer_texture *up)
 {
 	struct gl_texture *self = to_gl_texture(up);
-	gl_call(glDeleteTextures(1, &self->id));
-	b6_deallocate(to_gl_renderer(up->renderer)->texture_allocator, self);
-}
-
-static void update_gl_texture(struct renderer_texture *up,
-			      const struct rgba *rgba)
-{
-	struct gl_texture *self = to_gl_texture(up);
-	make_gl_texture(self->id, rgba);
-	self->w = 1.;
-	self->h = 1.;
+	struct gl_renderer *renderer = to_gl_renderer(up->renderer);
+	if (self->page)
+		remove_gl_atlas_texture(self);
+	else {
+		gl_call(glDeleteTextures(1, &self->id));
+		unbind_gl_texture();
+	}
+	b6_deallocate(renderer->texture_allocator, self);
 }
 
 static unsigned long int to_pot(unsigned short int n)
@@ -140,163 +159,222 @@ static unsigned long int to_pot(unsigned short int n)
 	return n + 1;
 }
 
-static void update_gl_texture_pot(struct renderer_texture *up,
-				  const struct rgba *rgba)
+/* Power-of-two storage is allocated empty and the image is uploaded in its
+ * corner, without an intermediate copy.
+ */
+static void resize_gl_texture(struct gl_renderer *renderer,
+			      struct gl_texture *self,
+			      unsigned short int w, unsigned short int h)
+{
+	struct rgba empty = { .p = NULL, .w = w, .h = h, };
+	if (renderer->pot) {
+		empty.w = to_pot(w);
+		empty.h = to_pot(h);
+	}
+	make_gl_texture(self->id, &empty);
+	self->w = w;
+	self->h = h;
+	self->texture.u1 = self->texture.v1 = 0.;
+	self->texture.u2 = (double)w / empty.w;
+	self->texture.v2 = (double)h / empty.h;
+}
+
+static void update_gl_texture(struct renderer_texture *up,
+			      const struct rgba *rgba)
 {
 	struct gl_texture *self = to_gl_texture(up);
-	unsigned long int w = to_pot(rgba->w), h = to_pot(rgba->h);
-	struct rgba temp;
-	if (w == rgba->w && h == rgba->h) {
+	struct gl_renderer *renderer = to_gl_renderer(up->renderer);
+	if (rgba->w != self->w || rgba->h != self->h) {
+		resize_gl_texture(renderer, self, rgba->w, rgba->h);
+		/* the image covers another part of its storage */
+		renderer->retextured |= renderer->pot;
+	} else
+		gl_call(bind_gl_texture(self->id));
+	upload_gl_texture_rect(renderer->pbo, rgba, 0, 0, rgba->w, rgba->h,
+			       0, 0);
+}
+
+static void patch_gl_texture(struct renderer_texture *up,
+			     const struct rgba *rgba,
+			     unsigned short int x, unsigned short int y,
+			     unsigned short int w, unsigned short int h)
+{
+	struct gl_texture *self = to_gl_texture(up);
+	if (rgba->w != self->w || rgba->h != self->h) {
 		update_gl_texture(up, rgba);
 		return;
 	}
-	initialize_rgba(&temp, w, h);
-	copy_rgba(rgba, 0, 0, rgba->w, rgba->h, &temp, 0, 0);
-	self->w = (double)rgba->w / w;
-	self->h = (double)rgba->h / h;
-	make_gl_texture(self->id, &temp);
-	finalize_rgba(&temp);
+	gl_call(bind_gl_texture(self->id));
+	upload_gl_texture_rect(to_gl_renderer(up->renderer)->pbo, rgba,
+			       x, y, w, h, x, y);
+}
+
+static const struct renderer_texture_ops gl_texture_ops = {
+	.update = update_gl_texture,
+	.patch = patch_gl_texture,
+	.dtor = delete_gl_texture,
+};
+
+static int setup_gl_texture(struct gl_renderer *renderer,
+			    struct gl_texture *self, const struct rgba *rgba)
+{
+	self->page = NULL;
+	__setup_renderer_texture(&self->texture, &gl_texture_ops);
+	gl_call(glGenTextures(1, &self->id));
+	resize_gl_texture(renderer, self, rgba->w, rgba->h);
+	upload_gl_texture_rect(renderer->pbo, rgba, 0, 0, rgba->w, rgba->h,
+			       0, 0);
+	return 0;
+}
+
+/* Textures that change size are moved, and get out of the atlas when they do
+ * not fit anymore.
+ */
+static void update_gl_packed_texture(struct renderer_texture *up,
+				     const struct rgba *rgba)
+{
+	struct gl_texture *self = to_gl_texture(up);
+	struct gl_renderer *renderer = to_gl_renderer(up->renderer);
+	if (rgba->w + 2 == self->w && rgba->h + 2 == self->h) {
+		upload_gl_atlas_texture(&renderer->atlas, self, rgba);
+		return;
+	}
+	remove_gl_atlas_texture(self);
+	renderer->retextured = 1;
+	if (!fits_gl_atlas(rgba) ||
+	    alloc_gl_atlas_texture(&renderer->atlas, self, rgba->w, rgba->h))
+		setup_gl_texture(renderer, self, rgba);
+	else
+		upload_gl_atlas_texture(&renderer->atlas, self, rgba);
+}
+
+static void patch_gl_packed_texture(struct renderer_texture *up,
+				    const struct rgba *rgba,
+				    unsigned short int x, unsigned short int y,
+				    unsigned short int w, unsigned short int h)
+{
+	struct gl_renderer *renderer = to_gl_renderer(up->renderer);
+	if (patch_gl_atlas_texture(&renderer->atlas, to_gl_texture(up), rgba,
+				   x, y, w, h))
+		update_gl_packed_texture(up, rgba);
 }
 
+static const struct renderer_texture_ops gl_packed_texture_ops = {
+	.update = update_gl_packed_texture,
+	.patch = patch_gl_packed_texture,
+	.dtor = delete_gl_texture,
+};
+
 static struct renderer_texture *new_gl_texture(struct renderer *up,
 					       const struct rgba *rgba)
 {
-	static const struct renderer_texture_ops ops = {
-		.update = update_gl_texture,
-		.dtor = delete_gl_texture,
-	};
-	static const struct renderer_texture_ops ops_pot = {
-		.update = update_gl_texture_pot,
-		.dtor = delete_gl_texture,
-	};
 	struct gl_renderer *gl_renderer = to_gl_renderer(up);
 	struct gl_texture *self = b6_allocate(gl_renderer->texture_allocator,
 					      sizeof(*self));
 	if (!self)
 		return NULL;
-	self->texture.ops = gl_pot ? &ops_pot : &ops;
-	gl_call(glGenTextures(1, &self->id));
-	self->texture.ops->update(&self->texture, rgba);
+	if (fits_gl_atlas(rgba) &&
+	    !alloc_gl_atlas_texture(&gl_renderer->atlas, self, rgba->w,
+				    rgba->h)) {
+		__setup_renderer_texture(&self->texture,
+					 &gl_packed_texture_ops);
+		upload_gl_atlas_texture(&gl_renderer->atlas, self, rgba);
+	} else
+		setup_gl_texture(gl_renderer, self, rgba);
 	return &self->texture;
 }
 
-static void gl_prerender_tiles(struct renderer_base *self)
+static void draw_gl_tiles(struct gl_renderer *self, GLuint texture,
+			  unsigned long int first, unsigned long int last)
 {
-	struct gl_buffer *gl_buffer = to_gl_renderer(self->renderer)->gl_buffer;
-	struct b6_dref *dref;
-	for (dref = b6_list_first(&self->tiles);
-	     dref != b6_list_tail(&self->tiles);
-	     dref = b6_list_walk(dref, B6_NEXT)) {
-		struct renderer_tile *tile =
-			b6_cast_of(dref, struct renderer_tile, dref);
-		double x0 = tile->x;
-		double y0 = tile->y;
-		double x1 = x0 + tile->w;
-		double y1 = y0 + tile->h;
-		float w = 1., h = 1.;
-		if (tile->texture) {
-			struct gl_texture *tx = to_gl_texture(tile->texture);
-			w = tx->w;
-			h = tx->h;
-		}
-		append_gl_buffer(gl_buffer, 0., 0., w, h, x0, y0, x1, y1);
-	}
-}
-
-static void gl_prerender_base(struct renderer_base *self)
-{
-	struct b6_dref *dref;
-	gl_prerender_tiles(self);
-	for (dref = b6_list_first(&self->bases);
-	     dref != b6_list_tail(&self->bases);
-	     dref = b6_list_walk(dref, B6_NEXT))
-		gl_prerender_base(b6_cast_of(dref, struct renderer_base, dref));
+	if (!texture)
+		return;
+	self->draw_count += 1;
+	bind_gl_texture(texture);
+	gl_call(glDrawArrays(GL_TRIANGLES, first, last - first));
 }
 
-static void gl_render_tiles(struct gl_renderer *self,
-			    struct renderer_base *base,
-			    unsigned long int *index, int visible)
+/* Tiles are swept in drawing order. Consecutive ones are drawn at once when
+ * they share a base and a texture and sit in consecutive slots, which they do
+ * unless recycled handles got in between.
+ */
+static void gl_render_tiles(struct gl_renderer *self)
 {
-	struct b6_dref *dref;
-	struct renderer_texture *texture = NULL;
-	unsigned long int local = 0;
-	if (!visible) {
-		for (dref = b6_list_first(&base->tiles);
-		     dref != b6_list_tail(&base->tiles);
-		     dref = b6_list_walk(dref, B6_NEXT))
-			*index += 6;
-		return;
-	}
-	for (dref = b6_list_first(&base->tiles);
-	     dref != b6_list_tail(&base->tiles);
-	     dref = b6_list_walk(dref, B6_NEXT)) {
-		struct renderer_tile *tile =
-			b6_cast_of(dref, struct renderer_tile, dref);
-		if (tile->texture != texture) {
-			if (texture != NULL) {
-				self->draw_count += 1;
-				bind_gl_texture(to_gl_texture(texture)->id);
-				gl_call(glDrawArrays(GL_TRIANGLES, local,
-						     *index - local));
+	const struct renderer_scene *scene = &self->renderer.scene;
+	unsigned long int i, n = b6_array_length(&scene->order);
+	const unsigned int *order = b6_array_get(&scene->order, 0);
+	const unsigned int *base = b6_array_get(&scene->tile_base, 0);
+	struct renderer_texture *const *texture =
+		b6_array_get(&scene->tile_texture, 0);
+	const float *offset = b6_array_get(&scene->base_offset, 0);
+	const unsigned char *shown = b6_array_get(&scene->base_shown, 0);
+	unsigned long int first = 0, last = 0;
+	long int current = -1;
+	GLuint id = 0;
+	for (i = 0; i < n; i += 1) {
+		unsigned int j = order[i], k = base[j];
+		GLuint t;
+		if (!shown[k])
+			continue;
+		t = texture[j] ? to_gl_texture(texture[j])->id : 0;
+		if (t != id || j * 6 != last || k != current) {
+			draw_gl_tiles(self, id, first, last);
+			if (k != current) {
+				gl_call(glLoadIdentity());
+				gl_call(glTranslatef(offset[2 * k],
+						     offset[2 * k + 1], 0));
+				current = k;
 			}
-			texture = tile->texture;
-			local = *index;
+			id = t;
+			first = j * 6;
 		}
-		*index += 6;
+		last = j * 6 + 6;
 	}
-	if (texture != NULL) {
-		self->draw_count += 1;
-		bind_gl_texture(to_gl_texture(texture)->id);
-		gl_call(glDrawArrays(GL_TRIANGLES, local, *index - local));
-	}
-}
-
-static void gl_render_base(struct gl_renderer *self, struct renderer_base *up,
-			   unsigned long int *index, int visible)
-{
-	struct b6_dref *dref;
-	visible &= up->visible;
-	gl_call(glPushMatrix());
-	gl_call(glTranslatef(up->x, up->y, 0));
-	gl_render_tiles(self, up, index, visible);
-	for (dref = b6_list_first(&up->bases);
-	     dref != b6_list_tail(&up->bases);
-	     dref = b6_list_walk(dref, B6_NEXT))
-		gl_render_base(self,
-			       b6_cast_of(dref, struct renderer_base, dref),
-			       index, visible);
-	gl_call(glPopMatrix());
+	draw_gl_tiles(self, id, first, last);
 }
 
 static void gl_render(struct renderer *up)
 {
 	struct gl_renderer *self = to_gl_renderer(up);
-	unsigned long int index = 0;
-	if (self->dirty) {
-		unbind_gl_texture();
-		clear_gl_buffer(self->gl_buffer);
-		gl_prerender_base(&self->root);
-		push_gl_buffer(self->gl_buffer);
-		self->dirty = 0;
+	if (sweep_renderer_scene(up)) {
+		log_e(_s("out of memory"));
+		return;
 	}
+	if (self->retextured || self->atlas.retextured) {
+		retexture_renderer_scene(&up->scene);
+		retexture_gl_buffer(self->gl_buffer, &up->scene);
+		self->retextured = self->atlas.retextured = 0;
+	}
+	if (self->gl_buffer->lo != self->gl_buffer->hi)
+		up->nrebuilds += 1;
+	push_gl_buffer(self->gl_buffer);
+	if (self->offscreen)
+		bind_gl_frame(self->offscreen);
 	gl_call(glLoadIdentity());
 	gl_call(glClear(GL_COLOR_BUFFER_BIT|
 			GL_DEPTH_BUFFER_BIT|
 			GL_STENCIL_BUFFER_BIT));
 	gl_call(glColor3f(self->dim, self->dim, self->dim));
 	self->draw_count = 0;
-	gl_render_base(self, &self->root, &index, 1);
+	gl_render_tiles(self);
+	up->ndraws = self->draw_count;
+	if (self->offscreen)
+		blit_gl_frame(self->offscreen, up->external_width,
+			      up->external_height);
 }
 
 static void gl_resize(struct renderer *up)
 {
+	struct gl_renderer *self = to_gl_renderer(up);
 	double wi = up->internal_width;
 	double hi = up->internal_height;
 	double we = up->external_width;
 	double he = up->external_height;
 	if (we <= 0 || he <= 0 || wi <= 0 || hi <= 0)
 		return;
-	if (we * hi > he * wi) {
+	if (self->offscreen)
+		gl_call(glViewport(0, 0, wi, hi));
+	else if (we * hi > he * wi) {
 		double width = wi / hi * he;
 		gl_call(glViewport((we - width) / 2, 0, width, he));
 	} else {
@@ -311,6 +389,14 @@ static void gl_resize(struct renderer *up)
 
 static void gl_start(struct renderer *up)
 {
+	struct gl_renderer *self = to_gl_renderer(up);
+	if (self->offscreen && resize_gl_frame(self->offscreen,
+					       up->internal_width,
+					       up->internal_height)) {
+		log_w(_s("drawing into the window"));
+		finalize_gl_frame(self->offscreen);
+		self->offscreen = NULL;
+	}
 	gl_call(glClearColor(.0f, .0f, .0f, 1.f));
 	gl_call(glClear(GL_COLOR_BUFFER_BIT|
 			GL_DEPTH_BUFFER_BIT|
@@ -353,17 +439,22 @@ int open_gl_renderer(struct gl_renderer *self)
 		.dim = gl_dim,
 	};
 	__setup_renderer(&self->renderer, &ops);
-	__setup_renderer_base(&self->root, NULL, "gl_root", 0, 0, NULL);
-	self->root.renderer = &self->renderer;
+	if (__setup_renderer_base(&self->root, &self->renderer, NULL,
+				  "gl_root", 0, 0, NULL)) {
+		__finalize_renderer(&self->renderer);
+		return -1;
+	}
 	self->dim = 1.f;
-	if (!initialize_gl_srv_buffer(&self->srv_buffer)) {
+	if (!initialize_gl_srv_buffer(&self->srv_buffer, 0)) {
 		log_i(_s("using remote gl buffer"));
 		self->gl_buffer = &self->srv_buffer.gl_buffer;
 	} else if (!initialize_gl_cli_buffer(&self->cli_buffer)) {
 		log_i(_s("using local gl buffer"));
 		self->gl_buffer = &self->cli_buffer.gl_buffer;
-	} else
+	} else {
+		__finalize_renderer(&self->renderer);
 		return -1;
+	}
 	b6_reset_fixed_allocator(&self->allocator, self->buffer,
 				 sizeof(self->buffer));
 	b6_pool_initialize(&self->pool, &self->allocator.allocator, 1024,
@@ -377,12 +468,31 @@ int open_gl_renderer(struct gl_renderer *self)
 	self->texture_allocator = &self->texture_pool.parent;
 	self->tile_allocator = &self->tile_pool.parent;
 	self->base_allocator = &self->base_pool.parent;
-	self->dirty = 1;
+	self->retextured = 0;
+	self->pot = gl_pot || !gl_npot_is_supported();
+	if (self->pot)
+		log_i(_s("using power-of-two textures"));
+	self->pbo = NULL;
+	if (gl_pbo && !initialize_gl_pbo_ring(&self->pbo_ring)) {
+		log_i(_s("streaming textures through pixel buffers"));
+		self->pbo = &self->pbo_ring;
+	}
+	initialize_gl_atlas(&self->atlas, self->pbo);
+	self->offscreen = NULL;
+	if (!initialize_gl_frame(&self->frame)) {
+		log_i(_s("drawing offscreen"));
+		self->offscreen = &self->frame;
+	}
 	return 0;
 }
 
 void close_gl_renderer(struct gl_renderer *self)
 {
+	if (self->offscreen)
+		finalize_gl_frame(self->offscreen);
+	if (self->pbo)
+		finalize_gl_pbo_ring(self->pbo);
+	finalize_gl_atlas(&self->atlas);
 	b6_pool_finalize(&self->base_pool);
 	b6_pool_finalize(&self->tile_pool);
 	b6_pool_finalize(&self->texture_pool);
@@ -391,4 +501,5 @@ void close_gl_renderer(struct gl_renderer *self)
 		finalize_gl_cli_buffer(&self->cli_buffer);
 	else if (self->gl_buffer == &self->srv_buffer.gl_buffer)
 		finalize_gl_srv_buffer(&self->srv_buffer);
+	__finalize_renderer(&self->renderer);
 }
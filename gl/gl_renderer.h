@@ -21,6 +21,8 @@
 #define GL_RENDERER_H
 
 #include "core/renderer.h"
+#include "gl_atlas.h"
+#include "gl_frame.h"
 #include "gl_utils.h"
 
 #include <b6/pool.h>
@@ -38,7 +40,16 @@ struct gl_renderer {
 	struct b6_pool texture_pool;
 	struct b6_pool tile_pool;
 	struct b6_pool base_pool;
-	int dirty;
+	/* textures of their own moved within their storage: all tiles need new
+	 * coordinates, as with atlas repacks
+	 */
+	int retextured;
+	struct gl_atlas atlas;
+	int pot; /* textures of their own have power-of-two sizes */
+	struct gl_pbo_ring pbo_ring;
+	struct gl_pbo_ring *pbo; /* NULL when uploading from client memory */
+	struct gl_frame frame;
+	struct gl_frame *offscreen; /* NULL when drawing into the window */
 	struct gl_cli_buffer cli_buffer;
 	struct gl_srv_buffer srv_buffer;
 	struct gl_buffer *gl_buffer;
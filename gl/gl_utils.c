@@ -18,11 +18,14 @@
  */
 
 #include "gl_utils.h"
+#include "core/renderer.h"
 #include "core/rgba.h"
 #include "lib/log.h"
 #include "lib/std.h"
 #include <b6/cmdline.h>
 
+#include <string.h>
+
 static int use_gl_ext = 1;
 b6_flag(use_gl_ext, bool);
 
@@ -60,12 +63,136 @@ void make_gl_texture(GLuint id, const struct rgba *rgba)
 	gl_call(glFlush());
 }
 
+static int get_gl_version(void)
+{
+	const char *s = (const char*)glGetString(GL_VERSION);
+	int major = 0, minor = 0;
+	if (!s)
+		return 0;
+	while (*s >= '0' && *s <= '9')
+		major = major * 10 + *s++ - '0';
+	if (*s++ == '.')
+		while (*s >= '0' && *s <= '9')
+			minor = minor * 10 + *s++ - '0';
+	return major * 10 + minor;
+}
+
+static int has_gl_extension(const char *name)
+{
+	const char *s = (const char*)glGetString(GL_EXTENSIONS);
+	unsigned long int len = strlen(name);
+	if (!s)
+		return 0;
+	while ((s = strstr(s, name))) {
+		if (s[len] == ' ' || s[len] == '\0')
+			return 1;
+		s += len;
+	}
+	return 0;
+}
+
+int gl_npot_is_supported(void)
+{
+	return get_gl_version() >= 20 ||
+		has_gl_extension("GL_ARB_texture_non_power_of_two");
+}
+
+int gl_pbo_is_supported(void)
+{
+	return use_gl_ext && gl_buffer_extension_is_supported() &&
+		(get_gl_version() >= 21 ||
+		 has_gl_extension("GL_ARB_pixel_buffer_object"));
+}
+
+int gl_fbo_is_supported(void)
+{
+	return use_gl_ext && gl_framebuffer_extension_is_supported() &&
+		(get_gl_version() >= 30 ||
+		 has_gl_extension("GL_ARB_framebuffer_object"));
+}
+
+int initialize_gl_pbo_ring(struct gl_pbo_ring *self)
+{
+	if (!gl_pbo_is_supported())
+		return -1;
+	gl_call(gl_ext_gen_buffers(GL_PBO_RING_SIZE, self->id));
+	self->next = 0;
+	return 0;
+}
+
+void finalize_gl_pbo_ring(struct gl_pbo_ring *self)
+{
+	gl_call(gl_ext_bind_buffer(GL_PIXEL_UNPACK_BUFFER, 0));
+	gl_call(gl_ext_delete_buffers(GL_PBO_RING_SIZE, self->id));
+}
+
+/* Returns -1 when the buffer could not be mapped, the caller then uploads
+ * from client memory.
+ */
+static int upload_gl_texture_rect_via(struct gl_pbo_ring *self,
+				      const struct rgba *rgba,
+				      unsigned short int x,
+				      unsigned short int y,
+				      unsigned short int w,
+				      unsigned short int h,
+				      unsigned short int u,
+				      unsigned short int v)
+{
+	unsigned long int pitch = 4 * w;
+	const unsigned char *src = &rgba->p[4 * (x + y * rgba->w)];
+	unsigned char *dst = NULL;
+	unsigned short int n;
+	gl_call(gl_ext_bind_buffer(GL_PIXEL_UNPACK_BUFFER,
+				   self->id[self->next]));
+	self->next = (self->next + 1) % GL_PBO_RING_SIZE;
+	/* orphans the previous storage rather than waiting for it */
+	gl_call(gl_ext_buffer_data(GL_PIXEL_UNPACK_BUFFER, pitch * h, NULL,
+				   GL_STREAM_DRAW));
+	gl_call(dst = gl_ext_map_buffer(GL_PIXEL_UNPACK_BUFFER,
+					GL_WRITE_ONLY));
+	if (!dst) {
+		gl_call(gl_ext_bind_buffer(GL_PIXEL_UNPACK_BUFFER, 0));
+		return -1;
+	}
+	for (n = h; n--; src += 4 * rgba->w, dst += pitch)
+		memcpy(dst, src, pitch);
+	gl_call(gl_ext_unmap_buffer(GL_PIXEL_UNPACK_BUFFER));
+	gl_call(glPixelStorei(GL_UNPACK_ROW_LENGTH, 0));
+	gl_call(glTexSubImage2D(GL_TEXTURE_2D, 0, u, v, w, h,
+				GL_RGBA, GL_UNSIGNED_BYTE, NULL));
+	gl_call(gl_ext_bind_buffer(GL_PIXEL_UNPACK_BUFFER, 0));
+	return 0;
+}
+
+void upload_gl_texture_rect(struct gl_pbo_ring *ring, const struct rgba *rgba,
+			    unsigned short int x, unsigned short int y,
+			    unsigned short int w, unsigned short int h,
+			    unsigned short int u, unsigned short int v)
+{
+	/* mapping a buffer costs more than copying a few glyphs */
+	static const unsigned long int min_pbo_size = 16384;
+	if (!w || !h)
+		return;
+	if (ring && 4UL * w * h >= min_pbo_size &&
+	    !upload_gl_texture_rect_via(ring, rgba, x, y, w, h, u, v))
+		return;
+	gl_call(glPixelStorei(GL_UNPACK_ROW_LENGTH, rgba->w));
+	gl_call(glPixelStorei(GL_UNPACK_SKIP_PIXELS, x));
+	gl_call(glPixelStorei(GL_UNPACK_SKIP_ROWS, y));
+	gl_call(glTexSubImage2D(GL_TEXTURE_2D, 0, u, v, w, h,
+				GL_RGBA, GL_UNSIGNED_BYTE, rgba->p));
+	gl_call(glPixelStorei(GL_UNPACK_SKIP_ROWS, 0));
+	gl_call(glPixelStorei(GL_UNPACK_SKIP_PIXELS, 0));
+	gl_call(glPixelStorei(GL_UNPACK_ROW_LENGTH, 0));
+}
+
 static void initialize_gl_buffer(struct gl_buffer *self,
 				 const struct gl_buffer_ops *ops)
 {
 	self->ops = ops;
 	b6_array_initialize(&self->t, &b6_std_allocator, 2 * sizeof(GLfloat));
 	b6_array_initialize(&self->v, &b6_std_allocator, 2 * sizeof(GLfloat));
+	self->lo = self->hi = 0;
 }
 
 static void finalize_gl_buffer(struct gl_buffer *self)
@@ -74,13 +201,59 @@ static void finalize_gl_buffer(struct gl_buffer *self)
 	b6_array_finalize(&self->v);
 }
 
+int fit_gl_buffer(struct gl_buffer *self, unsigned long int n)
+{
+	unsigned long int len = b6_array_length(&self->t) / 6;
+	if (n <= len)
+		return 0;
+	if (!b6_array_extend(&self->t, 6 * (n - len)))
+		return -1;
+	if (!b6_array_extend(&self->v, 6 * (n - len))) {
+		b6_array_reduce(&self->t, 6 * (n - len));
+		return -1;
+	}
+	return 0;
+}
+
+void set_gl_buffer_tile(struct gl_buffer *self,
+			const struct renderer_tile *tile)
+{
+	const float *uv = b6_array_get(&tile->renderer->scene.tile_uv,
+				       tile->handle);
+	float x = get_renderer_tile_x(tile), y = get_renderer_tile_y(tile);
+	set_gl_buffer_rect(self, tile->handle, uv[0], uv[1], uv[2], uv[3],
+			   x, y, x + get_renderer_tile_w(tile),
+			   y + get_renderer_tile_h(tile));
+}
+
+void set_gl_buffer_tile_uv(struct gl_buffer *self,
+			   const struct renderer_tile *tile)
+{
+	const float *uv = b6_array_get(&tile->renderer->scene.tile_uv,
+				       tile->handle);
+	set_gl_buffer_uv(self, tile->handle, uv[0], uv[1], uv[2], uv[3]);
+}
+
+void retexture_gl_buffer(struct gl_buffer *self,
+			 const struct renderer_scene *scene)
+{
+	unsigned long int i, n = b6_array_length(&scene->tile_uv);
+	if (n > b6_array_length(&self->t) / 6)
+		n = b6_array_length(&self->t) / 6;
+	for (i = 0; i < n; i += 1) {
+		const float *uv = b6_array_get(&scene->tile_uv, i);
+		set_gl_buffer_uv(self, i, uv[0], uv[1], uv[2], uv[3]);
+	}
+}
+
 static int push_gl_cli_buffer(struct gl_buffer *gl_buffer)
 {
 	float *t = b6_array_get(&gl_buffer->t, 0);
 	float *v = b6_array_get(&gl_buffer->v, 0);
-	logf_i("pushing %u vertices", b6_array_length(&gl_buffer->t));
+	/* arrays are read in place: only their address may have changed */
 	gl_call(glTexCoordPointer(2, GL_FLOAT, 0, t));
 	gl_call(glVertexPointer(2, GL_FLOAT, 0, v));
+	gl_buffer->lo = gl_buffer->hi = 0;
 	return 0;
 }
 
@@ -126,13 +299,50 @@ static void destroy_gl_buffer(unsigned int id)
 	gl_call(gl_ext_delete_buffers(1, &id));
 }
 
+/* Positions follow the texture coordinates of as many vertices as the local
+ * arrays can hold.
+ */
+static void point_gl_srv_buffer(const struct gl_srv_buffer *self,
+				unsigned long int max)
+{
+	const float *t = NULL, *v = t + max * 2;
+	if (self->attribs) {
+		gl_call(gl_ext_vertex_attrib_pointer(0, 2, GL_FLOAT, GL_FALSE,
+						     0, v));
+		gl_call(gl_ext_vertex_attrib_pointer(1, 2, GL_FLOAT, GL_FALSE,
+						     0, t));
+		return;
+	}
+	gl_call(glTexCoordPointer(2, GL_FLOAT, 0, t));
+	gl_call(glVertexPointer(2, GL_FLOAT, 0, v));
+}
+
 static void alloc_gl_buffer(unsigned long int size)
 {
 	gl_call(gl_ext_buffer_data(GL_ARRAY_BUFFER, size, NULL,
-				   GL_STREAM_DRAW));
+				   GL_DYNAMIC_DRAW));
 	/* GL_STATIC_DRAW, GL_STREAM_DRAW or GL_DYNAMIC_DRAW */
 }
 
+static void push_gl_srv_buffer_range(struct gl_srv_buffer *self)
+{
+	struct gl_buffer *gl_buffer = &self->gl_buffer;
+	unsigned long int lo = gl_buffer->lo * 2 * sizeof(float);
+	unsigned long int len = (gl_buffer->hi - gl_buffer->lo) *
+		2 * sizeof(float);
+	unsigned long int v_offset = self->capacity * 2 * sizeof(float);
+	bind_gl_buffer(self->id);
+	gl_call(gl_ext_buffer_sub_data(GL_ARRAY_BUFFER, lo, len,
+				       b6_array_get(&gl_buffer->t,
+						    gl_buffer->lo)));
+	gl_call(gl_ext_buffer_sub_data(GL_ARRAY_BUFFER, v_offset + lo, len,
+				       b6_array_get(&gl_buffer->v,
+						    gl_buffer->lo)));
+}
+
+/* Local arrays are laid out in the remote buffer according to their
+ * capacity: a full push is only needed when it changes.
+ */
 int push_gl_srv_buffer(struct gl_buffer *gl_buffer)
 {
 	struct gl_srv_buffer *self =
@@ -146,6 +356,12 @@ int push_gl_srv_buffer(struct gl_buffer *gl_buffer)
 	unsigned long int max = gl_buffer->t.capacity;
 	const float *v = b6_array_get(&gl_buffer->v, 0);
 	const float *t = b6_array_get(&gl_buffer->t, 0);
+	if (max == self->capacity) {
+		if (gl_buffer->lo != gl_buffer->hi)
+			push_gl_srv_buffer_range(self);
+		gl_buffer->lo = gl_buffer->hi = 0;
+		return 0;
+	}
 	if (size < v_size || size < t_size) {
 		log_e(_s("integer overflow"));
 		return -2;
@@ -160,14 +376,16 @@ int push_gl_srv_buffer(struct gl_buffer *gl_buffer)
 		create_gl_buffer(&self->id);
 		bind_gl_buffer(self->id);
 		alloc_gl_buffer(size);
-	}
+	} else
+		bind_gl_buffer(self->id);
 	logf_i("pushing %u/%u vertices", len, max);
 	p = map_gl_buffer();
 	q = p + max * 2;
 	while (len--) { *p++ = *t++; *p++ = *t++; *q++ = *v++; *q++ = *v++; }
 	unmap_gl_buffer();
-	gl_call(glTexCoordPointer(2, GL_FLOAT, 0, NULL));
-	gl_call(glVertexPointer(2, GL_FLOAT, 0, ((float*)NULL) + max * 2));
+	point_gl_srv_buffer(self, max);
+	self->capacity = max;
+	gl_buffer->lo = gl_buffer->hi = 0;
 	return 0;
 }
 
@@ -178,7 +396,7 @@ void finalize_gl_srv_buffer(struct gl_srv_buffer *self)
 	finalize_gl_buffer(&self->gl_buffer);
 }
 
-int initialize_gl_srv_buffer(struct gl_srv_buffer *self)
+int initialize_gl_srv_buffer(struct gl_srv_buffer *self, int attribs)
 {
 	static const struct gl_buffer_ops ops = { .push = push_gl_srv_buffer, };
 	if (!use_gl_ext || !gl_buffer_extension_is_supported())
@@ -186,5 +404,7 @@ int initialize_gl_srv_buffer(struct gl_srv_buffer *self)
 	initialize_gl_buffer(&self->gl_buffer, &ops);
 	self->id = NO_GL_ID;
 	self->size = 0;
+	self->capacity = 0;
+	self->attribs = attribs;
 	return 0;
 }
@@ -27,6 +27,8 @@
 #include <b6/array.h>
 #include <b6/utils.h>
 
+struct renderer_scene;
+struct renderer_tile;
 struct rgba;
 
 extern GLenum gl_error;
@@ -46,44 +48,108 @@ extern void unbind_gl_texture(void);
 
 extern void make_gl_texture(GLuint id, const struct rgba *rgba);
 
+extern int gl_npot_is_supported(void);
+
+extern int gl_pbo_is_supported(void);
+
+extern int gl_fbo_is_supported(void);
+
+/* Uploads go through a few pixel buffer objects used in turn, so that the
+ * copy into one does not wait for the driver to be done with the previous.
+ */
+#define GL_PBO_RING_SIZE 4
+
+struct gl_pbo_ring {
+	GLuint id[GL_PBO_RING_SIZE];
+	unsigned int next;
+};
+
+extern int initialize_gl_pbo_ring(struct gl_pbo_ring *self);
+
+extern void finalize_gl_pbo_ring(struct gl_pbo_ring *self);
+
+/* Uploads the w x h rectangle at (x, y) of rgba to (u, v) in the bound
+ * texture, through the ring when there is one.
+ */
+extern void upload_gl_texture_rect(struct gl_pbo_ring *ring,
+				   const struct rgba *rgba,
+				   unsigned short int x, unsigned short int y,
+				   unsigned short int w, unsigned short int h,
+				   unsigned short int u, unsigned short int v);
+
+/* Rectangles are stored as 6 vertices each, in the slot given by the handle
+ * of their tile in the scene: only the range of vertices that changed since
+ * the last push is sent again.
+ */
 struct gl_buffer {
 	const struct gl_buffer_ops *ops;
 	struct b6_array t;
 	struct b6_array v;
+	unsigned long int lo, hi; /* vertices changed since the last push */
 };
 
 struct gl_buffer_ops {
 	int (*push)(struct gl_buffer *self);
 };
 
-static inline void clear_gl_buffer(struct gl_buffer *self)
+static inline void touch_gl_buffer(struct gl_buffer *self,
+				   unsigned long int slot)
 {
-	b6_array_clear(&self->t);
-	b6_array_clear(&self->v);
+	unsigned long int lo = slot * 6, hi = lo + 6;
+	if (self->lo == self->hi) {
+		self->lo = lo;
+		self->hi = hi;
+		return;
+	}
+	if (self->lo > lo)
+		self->lo = lo;
+	if (self->hi < hi)
+		self->hi = hi;
 }
 
-static inline int append_gl_buffer(struct gl_buffer *self,
-				   float u1, float v1, float u2, float v2,
-				   float x1, float y1, float x2, float y2)
+/* Makes room for the slots below n. Returns -1 when out of memory. */
+extern int fit_gl_buffer(struct gl_buffer *self, unsigned long int n);
+
+static inline void set_gl_buffer_uv(struct gl_buffer *self,
+				    unsigned long int slot,
+				    float u1, float v1, float u2, float v2)
 {
-	float *t = b6_array_extend(&self->t, 6);
-	float *v = b6_array_extend(&self->v, 6);
-	if (t && v) {
-		*t++ = u2; *t++ = v2; *v++ = x2; *v++ = y2;
-		*t++ = u1; *t++ = v2; *v++ = x1; *v++ = y2;
-		*t++ = u1; *t++ = v1; *v++ = x1; *v++ = y1;
-		*t++ = u1; *t++ = v1; *v++ = x1; *v++ = y1;
-		*t++ = u2; *t++ = v1; *v++ = x2; *v++ = y1;
-		*t++ = u2; *t++ = v2; *v++ = x2; *v++ = y2;
-		return 0;
-	}
-	if (t)
-		b6_array_reduce(&self->t, 6);
-	if (v)
-		b6_array_reduce(&self->v, 6);
-	return -1;
+	float *t = b6_array_get(&self->t, slot * 6);
+	*t++ = u2; *t++ = v2;
+	*t++ = u1; *t++ = v2;
+	*t++ = u1; *t++ = v1;
+	*t++ = u1; *t++ = v1;
+	*t++ = u2; *t++ = v1;
+	*t++ = u2; *t++ = v2;
+	touch_gl_buffer(self, slot);
+}
+
+static inline void set_gl_buffer_rect(struct gl_buffer *self,
+				      unsigned long int slot,
+				      float u1, float v1, float u2, float v2,
+				      float x1, float y1, float x2, float y2)
+{
+	float *v = b6_array_get(&self->v, slot * 6);
+	*v++ = x2; *v++ = y2;
+	*v++ = x1; *v++ = y2;
+	*v++ = x1; *v++ = y1;
+	*v++ = x1; *v++ = y1;
+	*v++ = x2; *v++ = y1;
+	*v++ = x2; *v++ = y2;
+	set_gl_buffer_uv(self, slot, u1, v1, u2, v2);
 }
 
+/* Fills the slot of a tile from its row in the scene. */
+extern void set_gl_buffer_tile(struct gl_buffer *self,
+			       const struct renderer_tile *tile);
+
+extern void set_gl_buffer_tile_uv(struct gl_buffer *self,
+				  const struct renderer_tile *tile);
+
+/* Copies the texture coordinates of every row of the scene again. */
+extern void retexture_gl_buffer(struct gl_buffer *self,
+				const struct renderer_scene *scene);
+
 static inline int push_gl_buffer(struct gl_buffer *self)
 {
 	return self->ops->push(self);
@@ -101,9 +167,14 @@ struct gl_srv_buffer {
 	struct gl_buffer gl_buffer;
 	GLuint id;
 	unsigned long int size; /* size in bytes of the remote buffer */
+	unsigned long int capacity; /* of the local arrays it is laid out for */
+	/* feeds generic vertex attributes, 0 with positions and 1 with texture
+	 * coordinates, rather than the fixed function arrays
+	 */
+	int attribs;
 };
 
-extern int initialize_gl_srv_buffer(struct gl_srv_buffer*);
+extern int initialize_gl_srv_buffer(struct gl_srv_buffer*, int attribs);
 
 extern void finalize_gl_srv_buffer(struct gl_srv_buffer*);
 
@@ -65,6 +65,9 @@ b6_flag(mode, string);
 static const char *lang = NULL;
 b6_flag(lang, string);
 
+static const char *config = NULL;
+b6_flag(config, string);
+
 /* ascii to lev */
 static int a2l(struct b6_cmd *b6_cmd, int argc, char *argv[])
 {
@@ -203,6 +206,17 @@ static int greedy(struct b6_clock *clock)
 		goto bail_out;
 	if (!(languages = get_embedded_lang(json)))
 		goto bail_out;
+	if (config) {
+		static struct game_config custom_game_config;
+		copy_game_config(&custom_game_config,
+				 get_default_game_config());
+		if (read_game_config(&custom_game_config, json, config))
+			goto bail_out;
+		b6_register(&__game_config_registry, &custom_game_config.entry,
+			    B6_UTF8("custom"));
+		if (!mode)
+			mode = "custom";
+	}
 	reset_random_number_generator(b6_get_clock_time(clock));
 	if (initialize_pref(&preferences, json, "prefs.json.z"))
 		goto bail_out;
@@ -36,11 +36,41 @@
 	} \
 	static struct embedded embedded_ ## _data
 
+/* Publishes an image embedded as pixels in the layout textures upload, that
+ * is tw x th RGBA pixels with the w x h image in the upper left corner.
+ */
+#define publish_embedded_image(_data, _size, _w, _h, _tw, _th, _flags, _id) \
+	static struct embedded embedded_ ## _data; \
+	b6_ctor(publish_embedded_ ## _data); \
+	static void publish_embedded_ ## _data(void) \
+	{ \
+		struct embedded *self = &embedded_ ## _data; \
+		self->buf = _data; \
+		self->len = sizeof(_data); \
+		self->uncompressed_len = _size; \
+		self->w = _w; \
+		self->h = _h; \
+		self->tw = _tw; \
+		self->th = _th; \
+		self->flags = _flags; \
+		register_embedded(self, _id); \
+	} \
+	static struct embedded embedded_ ## _data
+
+enum {
+	EMBEDDED_DEFLATED = 1, /* buf has to be inflated */
+};
+
 struct embedded {
 	struct b6_entry entry;
 	const void *buf;
 	unsigned long int len;
 	unsigned long int uncompressed_len;
+	unsigned short int w; /* 0 unless published as an image */
+	unsigned short int h;
+	unsigned short int tw;
+	unsigned short int th;
+	unsigned int flags;
 };
 
 extern struct b6_registry __embedded_registry;
@@ -18,16 +18,32 @@
  */
 
 #include "lib/rng.h"
-#include <stdlib.h>
+
+/* xorshift32, which unlike rand() exposes its state */
+static unsigned long int rng_state = 1;
 
 void reset_random_number_generator(unsigned int seed)
 {
-	srand(seed);
+	set_random_number_generator_state(seed);
 }
 
 double read_random_number_generator(void)
 {
-	double a = rand();
-	double b = RAND_MAX;
-	return a / (b + 1);
+	unsigned long int x = rng_state;
+	x ^= (x << 13) & 0xffffffff;
+	x ^= x >> 17;
+	x ^= (x << 5) & 0xffffffff;
+	rng_state = x;
+	return (x - 1) / 4294967295.;
+}
+
+unsigned long int get_random_number_generator_state(void)
+{
+	return rng_state;
+}
+
+void set_random_number_generator_state(unsigned long int state)
+{
+	state &= 0xffffffff;
+	rng_state = state ? state : 0x2545f491;
 }
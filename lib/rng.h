@@ -23,4 +23,9 @@
 extern void reset_random_number_generator(unsigned int seed);
 extern double read_random_number_generator(void);
 
+/* The state fits in 32 bits so that it can be saved along with a game. */
+extern unsigned long int get_random_number_generator_state(void);
+
+extern void set_random_number_generator_state(unsigned long int state);
+
 #endif /* RNG_H */
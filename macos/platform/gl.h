@@ -22,6 +22,8 @@
 
 #include <OpenGL/gl.h>
 #include <OpenGL/glext.h>
+#define GL_DO_NOT_WARN_IF_MULTI_GL_VERSION_HEADERS_INCLUDED
+#include <OpenGL/gl3.h>
 
 #define gl_ext_gen_buffers glGenBuffers
 #define gl_ext_delete_buffers glDeleteBuffers
@@ -29,7 +31,51 @@
 #define gl_ext_map_buffer glMapBuffer
 #define gl_ext_unmap_buffer glUnmapBuffer
 #define gl_ext_bind_buffer glBindBuffer
+#define gl_ext_buffer_sub_data glBufferSubData
 
 static inline int gl_buffer_extension_is_supported(void) { return 1; }
 
+/* OpenGL 3.3 core profile entry points */
+#define gl_ext_gen_vertex_arrays glGenVertexArrays
+#define gl_ext_delete_vertex_arrays glDeleteVertexArrays
+#define gl_ext_bind_vertex_array glBindVertexArray
+#define gl_ext_create_shader glCreateShader
+#define gl_ext_shader_source glShaderSource
+#define gl_ext_compile_shader glCompileShader
+#define gl_ext_get_shader_iv glGetShaderiv
+#define gl_ext_get_shader_info_log glGetShaderInfoLog
+#define gl_ext_delete_shader glDeleteShader
+#define gl_ext_create_program glCreateProgram
+#define gl_ext_attach_shader glAttachShader
+#define gl_ext_link_program glLinkProgram
+#define gl_ext_get_program_iv glGetProgramiv
+#define gl_ext_get_program_info_log glGetProgramInfoLog
+#define gl_ext_use_program glUseProgram
+#define gl_ext_delete_program glDeleteProgram
+#define gl_ext_get_uniform_location glGetUniformLocation
+#define gl_ext_uniform_1i glUniform1i
+#define gl_ext_uniform_1f glUniform1f
+#define gl_ext_uniform_2f glUniform2f
+#define gl_ext_vertex_attrib_pointer glVertexAttribPointer
+#define gl_ext_enable_vertex_attrib_array glEnableVertexAttribArray
+#define gl_ext_tex_buffer glTexBuffer
+#define gl_ext_active_texture glActiveTexture
+
+static inline int gl_shader_extension_is_supported(void) { return 1; }
+
+/* framebuffer objects */
+#define gl_ext_gen_framebuffers glGenFramebuffers
+#define gl_ext_delete_framebuffers glDeleteFramebuffers
+#define gl_ext_bind_framebuffer glBindFramebuffer
+#define gl_ext_check_framebuffer_status glCheckFramebufferStatus
+#define gl_ext_framebuffer_renderbuffer glFramebufferRenderbuffer
+#define gl_ext_framebuffer_texture_2d glFramebufferTexture2D
+#define gl_ext_blit_framebuffer glBlitFramebuffer
+#define gl_ext_gen_renderbuffers glGenRenderbuffers
+#define gl_ext_delete_renderbuffers glDeleteRenderbuffers
+#define gl_ext_bind_renderbuffer glBindRenderbuffer
+#define gl_ext_renderbuffer_storage glRenderbufferStorage
+
+static inline int gl_framebuffer_extension_is_supported(void) { return 1; }
+
 #endif /* PLATFORM_GL_H */
@@ -18,4 +18,4 @@
 #
 
 libs+=lib.a
-lib.a:=debug.o env.o
+lib.a:=debug.o env.o jobs.o
@@ -0,0 +1,57 @@
+/*
+ * Open Greedy - an open-source version of Edromel Studio's Greedy XP
+ *
+ * Copyright (C) 2014-2017 Arnaud TROEL
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdio.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+
+unsigned int get_platform_cpu_count(void)
+{
+	long int n = sysconf(_SC_NPROCESSORS_ONLN);
+	return n > 0 ? n : 1;
+}
+
+/* Each job runs in its own process as the game is not reentrant. */
+int run_platform_jobs(unsigned int njobs, void (*job)(unsigned int, void*),
+		      void *arg)
+{
+	unsigned int i, nchildren = 0;
+	int retval = 0, status;
+	fflush(stdout);
+	fflush(stderr);
+	for (i = 0; i < njobs; i += 1) {
+		pid_t pid = fork();
+		if (!pid) {
+			job(i, arg);
+			fflush(stdout);
+			_exit(0);
+		}
+		if (pid < 0) {
+			retval = -1;
+			break;
+		}
+		nchildren += 1;
+	}
+	while (nchildren--)
+		if (wait(&status) < 0 || !WIFEXITED(status) ||
+		    WEXITSTATUS(status))
+			retval = -1;
+	return retval;
+}
@@ -22,6 +22,7 @@
 #define BUILDING_STATIC
 #include <xmp.h>
 #undef BUILDING_STATIC
+#include <b6/array.h>
 #include <b6/clock.h>
 #include <b6/cmdline.h>
 #include <b6/utf8.h>
@@ -30,6 +31,9 @@
 #include "core/controller.h"
 #include "core/mixer.h"
 #include "core/renderer.h"
+#include "core/rgba.h"
+#include "gl/gl3_renderer.h"
+#include "gl/gl_capture.h"
 #include "gl/gl_renderer.h"
 #include "lib/init.h"
 #include "lib/io.h"
@@ -46,12 +50,25 @@ b6_flag(sdl_scale, string);
 static unsigned int sdl_sleep = 15;
 b6_flag(sdl_sleep, uint);
 
+/* Prefix of the files frames are captured to, from the start when given. */
+static const char *capture = NULL;
+b6_flag(capture, string);
+
+/* "tga" for a file per frame, "raw" or "z" for a single stream of RGBA
+ * frames, compressed with zlib for the latter.
+ */
+static const char *capture_format = "tga";
+b6_flag(capture_format, string);
+
 static Uint32 flags = SDL_WINDOW_RESIZABLE;
 
+static int sdl_screenshot = 0; /* requested with F12 */
+
 static int sdl_count = 0;
 static char sdl_rw_dir[1024];
 static const struct b6_utf8 sdl_utf8 = B6_DEFINE_UTF8("sdl");
 static const struct b6_utf8 sdl_gl_utf8 = B6_DEFINE_UTF8("sdl/gl");
+static const struct b6_utf8 sdl_gl3_utf8 = B6_DEFINE_UTF8("sdl/gl3");
 
 const char *get_platform_rw_dir(void)
 {
@@ -163,6 +180,34 @@ static int set_sdl_video_size(unsigned short int w, unsigned short int h)
 	return 0;
 }
 
+/* Without a size given on the command line, fullscreen is the size of the
+ * desktop: SDL then resizes the window and does not switch modes.
+ */
+static int sdl_console_fullscreen(struct console *up, int value)
+{
+	Uint32 mode = 0;
+	unsigned short int w, h;
+	if (!window)
+		return -1;
+	if (value)
+		mode = get_console_width() && get_console_height() ?
+			SDL_WINDOW_FULLSCREEN : SDL_WINDOW_FULLSCREEN_DESKTOP;
+	if (SDL_SetWindowFullscreen(window, mode)) {
+		log_w(_s("SDL_SetWindowFullscreen: "), _s(SDL_GetError()));
+		return -1;
+	}
+	if (value) {
+		SDL_ShowCursor(SDL_DISABLE);
+		flags |= SDL_WINDOW_FULLSCREEN;
+	} else {
+		SDL_ShowCursor(SDL_ENABLE);
+		flags &= ~SDL_WINDOW_FULLSCREEN;
+	}
+	if (!get_sdl_video_size(&w, &h))
+		resize_renderer(up->default_renderer, w, h);
+	return 0;
+}
+
 static enum controller_key sdl_to_controller_key(int sym)
 {
 	switch (sym) {
@@ -219,6 +264,7 @@ static enum controller_key sdl_to_controller_key(int sym)
 	case SDLK_PERIOD: return CTRLK_PERIOD;
 	case SDLK_COMMA: return CTRLK_COMMA;
 	case SDLK_KP_ENTER: return CTRLK_ENTER;
+	case SDLK_F11: return CTRLK_F11;
 	}
 	return CTRLK_UNKNOWN;
 }
@@ -233,6 +279,8 @@ again:
 	case SDL_KEYDOWN:
 		if (event.key.repeat)
 			break;
+		if (event.key.keysym.sym == SDLK_F12)
+			sdl_screenshot = 1;
 		__notify_controller_key_pressed(
 			up->default_controller,
 			sdl_to_controller_key(event.key.keysym.sym));
@@ -247,7 +295,8 @@ again:
 					     event.text.text[0]);
 		break;
 	case SDL_WINDOWEVENT:
-		if (event.window.event == SDL_WINDOWEVENT_RESIZED) {
+		/* also sent when the size changes with fullscreen */
+		if (event.window.event == SDL_WINDOWEVENT_SIZE_CHANGED) {
 			unsigned short int w = event.window.data1;
 			unsigned short int h = event.window.data2;
 			resize_renderer(up->default_renderer, w, h);
@@ -270,6 +319,7 @@ again:
 struct sdl_texture {
 	struct renderer_texture up;
 	struct SDL_Texture *texture;
+	unsigned short int w, h;
 };
 
 static struct sdl_texture *to_sdl_texture(struct renderer_texture *up)
@@ -295,12 +345,24 @@ static struct sdl_base *to_sdl_base(struct renderer_base *up)
 	return b6_cast_of(up, struct sdl_base, up);
 }
 
+/* SDL_RenderGeometry appeared in SDL 2.0.18: tiles are drawn one by one with
+ * older versions.
+ */
+#if SDL_VERSION_ATLEAST(2, 0, 18)
+#define SDL_BATCH 1
+#else
+#define SDL_BATCH 0
+#endif
+
 struct sdl_renderer {
 	struct renderer up;
 	struct renderer_base root;
-	double x, y;
 	unsigned char dim;
 	struct SDL_Renderer *renderer;
+#if SDL_BATCH
+	struct b6_array batch; /* vertices of tiles sharing batch_texture */
+	SDL_Texture *batch_texture;
+#endif
 };
 
 static struct sdl_renderer *to_sdl_renderer(struct renderer *up)
@@ -330,7 +392,10 @@ static struct renderer_base *new_sdl_base(struct renderer *up,
 	struct sdl_base *self = b6_allocate(&b6_std_allocator, sizeof(*self));
 	if (!self)
 		return NULL;
-	__setup_renderer_base(&self->up, parent, name, x, y, &ops);
+	if (__setup_renderer_base(&self->up, up, parent, name, x, y, &ops)) {
+		b6_deallocate(&b6_std_allocator, self);
+		return NULL;
+	}
 	return &self->up;
 }
 
@@ -352,7 +417,10 @@ struct renderer_tile *new_sdl_tile(struct renderer *up,
 		b6_allocate(&b6_std_allocator, sizeof(*self));
 	if (!self)
 		return NULL;
-	__setup_renderer_tile(&self->up, base, x, y, w, h, texture, &ops);
+	if (__setup_renderer_tile(&self->up, base, x, y, w, h, texture, &ops)) {
+		b6_deallocate(&b6_std_allocator, self);
+		return NULL;
+	}
 	return &self->up;
 }
 
@@ -362,85 +430,171 @@ static void delete_sdl_texture(struct renderer_texture *up)
 	b6_deallocate(&b6_std_allocator, self);
 }
 
+static void make_sdl_texture(struct sdl_texture *self,
+			     struct SDL_Renderer *renderer,
+			     unsigned short int w, unsigned short int h)
+{
+	self->texture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_ABGR8888,
+					  SDL_TEXTUREACCESS_STATIC, w, h);
+	b6_check(!!self->texture);
+	SDL_SetTextureBlendMode(self->texture, SDL_BLENDMODE_BLEND);
+	self->w = w;
+	self->h = h;
+}
+
 static void update_sdl_texture(struct renderer_texture *up,
 			       const struct rgba *rgba)
 {
 	struct sdl_texture *self = to_sdl_texture(up);
+	if (self->w != rgba->w || self->h != rgba->h) {
+		SDL_DestroyTexture(self->texture);
+		make_sdl_texture(self, to_sdl_renderer(up->renderer)->renderer,
+				 rgba->w, rgba->h);
+	}
 	SDL_UpdateTexture(self->texture, NULL, rgba->p, rgba->w * 4);
 }
 
+static void patch_sdl_texture(struct renderer_texture *up,
+			      const struct rgba *rgba,
+			      unsigned short int x, unsigned short int y,
+			      unsigned short int w, unsigned short int h)
+{
+	struct sdl_texture *self = to_sdl_texture(up);
+	SDL_Rect rect = { .x = x, .y = y, .w = w, .h = h, };
+	if (self->w != rgba->w || self->h != rgba->h) {
+		update_sdl_texture(up, rgba);
+		return;
+	}
+	SDL_UpdateTexture(self->texture, &rect, &rgba->p[4 * (x + y * rgba->w)],
+			  rgba->w * 4);
+}
+
 static struct renderer_texture *new_sdl_texture(struct renderer *up,
 						const struct rgba *rgba)
 {
 	static const struct renderer_texture_ops ops = {
 		.update = update_sdl_texture,
+		.patch = patch_sdl_texture,
 		.dtor = delete_sdl_texture,
 	};
 	struct sdl_texture *self =
 		b6_allocate(&b6_std_allocator, sizeof(*self));
 	if (!self)
 		return NULL;
-	self->up.ops = &ops;
-	self->texture = SDL_CreateTexture(to_sdl_renderer(up)->renderer,
-					  SDL_PIXELFORMAT_ABGR8888,
-					  SDL_TEXTUREACCESS_STATIC,
-					  rgba->w, rgba->h);
-	b6_check(!!self->texture);
+	__setup_renderer_texture(&self->up, &ops);
+	make_sdl_texture(self, to_sdl_renderer(up)->renderer, rgba->w, rgba->h);
 	update_sdl_texture(&self->up, rgba);
-	SDL_SetTextureBlendMode(self->texture, SDL_BLENDMODE_BLEND);
 	return &self->up;
 }
 
-static void sdl_render_tiles(struct sdl_renderer *self,
-			     struct renderer_base *up)
+#if SDL_BATCH
+static void flush_sdl_batch(struct sdl_renderer *self)
 {
-	struct b6_dref *dref;
-	for (dref = b6_list_first(&up->tiles);
-	     dref != b6_list_tail(&up->tiles);
-	     dref = b6_list_walk(dref, B6_NEXT)) {
-		SDL_Rect dst;
-		struct renderer_tile *tile =
-			b6_cast_of(dref, struct renderer_tile, dref);
-		struct sdl_texture *texture = to_sdl_texture(tile->texture);
-		if (!texture)
-			continue;
-		if (!texture->texture)
-			continue;
-		dst.x = self->x + tile->x;
-		dst.y = self->y + tile->y;
-		dst.w = tile->w;
-		dst.h = tile->h;
-		SDL_RenderCopy(self->renderer, texture->texture, NULL, &dst);
-	}
+	unsigned long int n = b6_array_length(&self->batch);
+	if (!n)
+		return;
+	SDL_RenderGeometry(self->renderer, self->batch_texture,
+			   b6_array_get(&self->batch, 0), n, NULL, 0);
+	self->up.ndraws += 1;
+	b6_array_reduce(&self->batch, n);
 }
 
-static void sdl_render_base(struct sdl_renderer *self, struct renderer_base *up)
+static void set_sdl_vertex(SDL_Vertex *v, float x, float y, float u, float w)
 {
-	struct b6_dref *dref;
-	double x = self->x;
-	double y = self->y;
-	if (!up->visible)
+	v->position.x = x;
+	v->position.y = y;
+	v->color.r = v->color.g = v->color.b = v->color.a = 255;
+	v->tex_coord.x = u;
+	v->tex_coord.y = w;
+}
+
+/* Consecutive tiles that share a texture are drawn with a single call, even
+ * across bases.
+ */
+static void draw_sdl_tile(struct sdl_renderer *self, SDL_Texture *texture,
+			  const SDL_Rect *dst)
+{
+	float x1 = dst->x, y1 = dst->y;
+	float x2 = dst->x + dst->w, y2 = dst->y + dst->h;
+	SDL_Vertex *v;
+	if (texture != self->batch_texture) {
+		flush_sdl_batch(self);
+		self->batch_texture = texture;
+	}
+	if (!(v = b6_array_extend(&self->batch, 6))) {
+		flush_sdl_batch(self);
+		SDL_RenderCopy(self->renderer, texture, NULL, dst);
+		self->up.ndraws += 1;
 		return;
-	self->x += up->x;
-	self->y += up->y;
-	sdl_render_tiles(self, up);
-	for (dref = b6_list_first(&up->bases);
-	     dref != b6_list_tail(&up->bases);
-	     dref = b6_list_walk(dref, B6_NEXT))
-		sdl_render_base(self,
-				b6_cast_of(dref, struct renderer_base, dref));
-	self->x = x;
-	self->y = y;
+	}
+	set_sdl_vertex(v++, x1, y1, 0, 0);
+	set_sdl_vertex(v++, x2, y1, 1, 0);
+	set_sdl_vertex(v++, x1, y2, 0, 1);
+	set_sdl_vertex(v++, x2, y1, 1, 0);
+	set_sdl_vertex(v++, x2, y2, 1, 1);
+	set_sdl_vertex(v++, x1, y2, 0, 1);
+}
+#else
+static void flush_sdl_batch(struct sdl_renderer *self)
+{
+}
+
+static void draw_sdl_tile(struct sdl_renderer *self, SDL_Texture *texture,
+			  const SDL_Rect *dst)
+{
+	SDL_RenderCopy(self->renderer, texture, NULL, dst);
+	self->up.ndraws += 1;
+}
+#endif
+
+static void sdl_render_tiles(struct sdl_renderer *self)
+{
+	const struct renderer_scene *scene = &self->up.scene;
+	unsigned long int i, n = b6_array_length(&scene->order);
+	const unsigned int *order = b6_array_get(&scene->order, 0);
+	const unsigned int *base = b6_array_get(&scene->tile_base, 0);
+	struct renderer_texture *const *texture =
+		b6_array_get(&scene->tile_texture, 0);
+	const float *x = b6_array_get(&scene->tile_x, 0);
+	const float *y = b6_array_get(&scene->tile_y, 0);
+	const float *w = b6_array_get(&scene->tile_w, 0);
+	const float *h = b6_array_get(&scene->tile_h, 0);
+	const float *offset = b6_array_get(&scene->base_offset, 0);
+	const unsigned char *shown = b6_array_get(&scene->base_shown, 0);
+	for (i = 0; i < n; i += 1) {
+		unsigned int j = order[i], k = base[j];
+		struct sdl_texture *t;
+		SDL_Rect dst;
+		if (!texture[j] || !shown[k])
+			continue;
+		t = to_sdl_texture(texture[j]);
+		if (!t->texture)
+			continue;
+		dst.x = offset[2 * k] + x[j];
+		dst.y = offset[2 * k + 1] + y[j];
+		dst.w = w[j];
+		dst.h = h[j];
+		draw_sdl_tile(self, t->texture, &dst);
+	}
 }
 
 static void sdl_render(struct renderer *up)
 {
 	struct sdl_renderer *self = to_sdl_renderer(up);
+	if (sweep_renderer_scene(up)) {
+		log_e(_s("out of memory"));
+		return;
+	}
 	SDL_RenderClear(self->renderer);
-	sdl_render_base(self, &self->root);
-	SDL_SetRenderDrawColor(self->renderer, 0, 0, 0, self->dim);
-	SDL_SetRenderDrawBlendMode(self->renderer, SDL_BLENDMODE_BLEND);
-	SDL_RenderFillRect(self->renderer, NULL);
+	sdl_render_tiles(self);
+	flush_sdl_batch(self);
+	if (self->dim) {
+		SDL_SetRenderDrawColor(self->renderer, 0, 0, 0, self->dim);
+		SDL_SetRenderDrawBlendMode(self->renderer,
+					   SDL_BLENDMODE_BLEND);
+		SDL_RenderFillRect(self->renderer, NULL);
+		SDL_SetRenderDrawColor(self->renderer, 0, 0, 0, 255);
+	}
 	SDL_RenderPresent(self->renderer);
 }
 
@@ -473,10 +627,13 @@ static int open_sdl_renderer(struct sdl_renderer *self)
 		.dim = sdl_dim,
 	};
 	int vs = get_console_vsync();
-	self->x = self->y = .0;
 	self->dim = 0;
 	__setup_renderer(&self->up, &ops);
-	__setup_renderer_base(&self->root, NULL, "sdl_root", 0, 0, NULL);
+	if (__setup_renderer_base(&self->root, &self->up, NULL, "sdl_root",
+				  0, 0, NULL)) {
+		__finalize_renderer(&self->up);
+		return -1;
+	}
 	SDL_SetHint(SDL_HINT_FRAMEBUFFER_ACCELERATION, sdl_accel);
 	SDL_SetHint(SDL_HINT_RENDER_SCALE_QUALITY, sdl_scale);
 	if (vs == 0)
@@ -486,15 +643,25 @@ static int open_sdl_renderer(struct sdl_renderer *self)
 	if (!(self->renderer = SDL_CreateRenderer(window, -1, 0))) {
 		log_e(_s(SDL_GetError()));
 		SDL_ClearHints();
+		__finalize_renderer(&self->up);
 		return -1;
 	}
+#if SDL_BATCH
+	b6_array_initialize(&self->batch, &b6_std_allocator,
+			    sizeof(SDL_Vertex));
+	self->batch_texture = NULL;
+#endif
 	return 0;
 }
 
 static void close_sdl_renderer(struct sdl_renderer *self)
 {
+#if SDL_BATCH
+	b6_array_finalize(&self->batch);
+#endif
 	SDL_ClearHints();
 	SDL_DestroyRenderer(self->renderer);
+	__finalize_renderer(&self->up);
 }
 
 struct sdl_console {
@@ -550,16 +717,261 @@ static int sdl_console_register(void)
 		.poll = sdl_console_poll,
 		.show = sdl_console_show,
 		.close = sdl_console_close,
+		.fullscreen = sdl_console_fullscreen,
 	};
 	static struct sdl_console instance = { .up = { .ops = &ops, }, };
 	return register_console(&instance.up, &sdl_utf8);
 }
 register_init(sdl_console_register);
 
+/* Readbacks are collected a couple of frames after they are queued, then
+ * encoded and written by a thread of their own. Its queue only holds the game
+ * when the disk cannot keep up, so that no frame is ever dropped.
+ */
+#define SDL_CAPTURE_QUEUE 8
+
+enum { SDL_CAPTURE_FRAME = 1, SDL_CAPTURE_SHOT = 2, };
+
+struct sdl_capture_frame {
+	struct rgba rgba;
+	unsigned long int frame, shot; /* numbers of either */
+	int tags;
+};
+
+struct sdl_capture {
+	struct gl_capture gl_capture;
+	struct {
+		unsigned long int frame, shot;
+		int tags;
+	} pending[GL_CAPTURE_DEPTH]; /* readbacks in the gl capture */
+	unsigned long int frames; /* captured so far */
+	unsigned long int shots; /* taken so far */
+	int state; /* 0: idle, 1: running, -1: failed */
+	SDL_Thread *thread;
+	SDL_mutex *mutex;
+	SDL_cond *cond;
+	struct sdl_capture_frame queue[SDL_CAPTURE_QUEUE];
+	unsigned int head, count;
+	int quit;
+	/* only touched by the thread */
+	unsigned long int errors;
+	struct ofstream ofs;
+	struct ozstream ozs;
+	struct ostream *ostream;
+	unsigned char buf[65536];
+};
+
+static int write_sdl_capture_tga(const struct rgba *rgba, const char *path)
+{
+	struct ofstream ofs;
+	int retval;
+	if (initialize_ofstream(&ofs, path))
+		return -1;
+	retval = write_rgba_as_tga(rgba, &ofs.ostream);
+	finalize_ofstream(&ofs);
+	return retval;
+}
+
+static int write_sdl_capture_stream(struct sdl_capture *self,
+				    const struct rgba *rgba)
+{
+	unsigned long long int len = 4ULL * rgba->w * rgba->h;
+	char path[1024];
+	if (!self->ostream) {
+		int z = !strcmp(capture_format, "z");
+		snprintf(path, sizeof(path), "%s.rgba%s", capture,
+			 z ? ".z" : "");
+		if (initialize_ofstream(&self->ofs, path))
+			return -1;
+		self->ostream = &self->ofs.ostream;
+		if (z && !initialize_ozstream(&self->ozs, &self->ofs.ostream,
+					      self->buf, sizeof(self->buf)))
+			self->ostream = &self->ozs.up;
+	}
+	return write_ostream(self->ostream, rgba->p, len) < len ? -1 : 0;
+}
+
+static void write_sdl_capture_frame(struct sdl_capture *self,
+				    const struct sdl_capture_frame *frame)
+{
+	char path[1024];
+	if (frame->tags & SDL_CAPTURE_SHOT) {
+		snprintf(path, sizeof(path), "%sscreenshot-%06lu.tga",
+			 sdl_rw_dir, frame->shot);
+		if (write_sdl_capture_tga(&frame->rgba, path))
+			self->errors += 1;
+	}
+	if (!(frame->tags & SDL_CAPTURE_FRAME))
+		return;
+	if (!strcmp(capture_format, "tga")) {
+		snprintf(path, sizeof(path), "%s%06lu.tga", capture,
+			 frame->frame);
+		if (write_sdl_capture_tga(&frame->rgba, path))
+			self->errors += 1;
+	} else if (write_sdl_capture_stream(self, &frame->rgba))
+		self->errors += 1;
+}
+
+static int run_sdl_capture(void *data)
+{
+	struct sdl_capture *self = data;
+	SDL_LockMutex(self->mutex);
+	for (;;) {
+		while (!self->count && !self->quit)
+			SDL_CondWait(self->cond, self->mutex);
+		if (!self->count)
+			break;
+		SDL_UnlockMutex(self->mutex);
+		write_sdl_capture_frame(self, &self->queue[self->head]);
+		SDL_LockMutex(self->mutex);
+		self->head = (self->head + 1) % SDL_CAPTURE_QUEUE;
+		self->count -= 1;
+		SDL_CondBroadcast(self->cond);
+	}
+	SDL_UnlockMutex(self->mutex);
+	if (self->ostream == &self->ozs.up)
+		finalize_ozstream(&self->ozs);
+	if (self->ostream)
+		finalize_ofstream(&self->ofs);
+	return 0;
+}
+
+static void reset_sdl_capture(struct sdl_capture *self)
+{
+	self->state = 0;
+	self->frames = self->shots = 0;
+}
+
+static int start_sdl_capture(struct sdl_capture *self)
+{
+	int i;
+	if (capture && strcmp(capture_format, "tga") &&
+	    strcmp(capture_format, "raw") && strcmp(capture_format, "z")) {
+		log_e(_s("unknown capture format: "), _s(capture_format));
+		goto fail_format;
+	}
+	if (initialize_gl_capture(&self->gl_capture))
+		goto fail_gl_capture;
+	if (!(self->mutex = SDL_CreateMutex()))
+		goto fail_mutex;
+	if (!(self->cond = SDL_CreateCond()))
+		goto fail_cond;
+	for (i = 0; i < SDL_CAPTURE_QUEUE; i += 1) {
+		self->queue[i].rgba.p = NULL;
+		self->queue[i].rgba.w = self->queue[i].rgba.h = 0;
+	}
+	self->head = self->count = 0;
+	self->quit = 0;
+	self->errors = 0;
+	self->ostream = NULL;
+	self->thread = SDL_CreateThread(run_sdl_capture, "capture", self);
+	if (!self->thread)
+		goto fail_thread;
+	self->state = 1;
+	return 0;
+fail_thread:
+	SDL_DestroyCond(self->cond);
+fail_cond:
+	SDL_DestroyMutex(self->mutex);
+fail_mutex:
+	finalize_gl_capture(&self->gl_capture);
+fail_gl_capture:
+	log_e(_s("cannot capture: "), _s(SDL_GetError()));
+fail_format:
+	self->state = -1;
+	return -1;
+}
+
+/* Waits for room in the queue rather than dropping the frame. */
+static void collect_sdl_capture(struct sdl_capture *self)
+{
+	struct sdl_capture_frame *frame;
+	unsigned int i = self->gl_capture.head;
+	unsigned short int w, h;
+	SDL_LockMutex(self->mutex);
+	while (self->count == SDL_CAPTURE_QUEUE)
+		SDL_CondWait(self->cond, self->mutex);
+	frame = &self->queue[(self->head + self->count) % SDL_CAPTURE_QUEUE];
+	SDL_UnlockMutex(self->mutex);
+	peek_gl_capture(&self->gl_capture, &w, &h);
+	if (frame->rgba.w != w || frame->rgba.h != h) {
+		if (frame->rgba.p)
+			finalize_rgba(&frame->rgba);
+		if (initialize_rgba(&frame->rgba, w, h))
+			log_p(_s("out of memory"));
+	}
+	frame->tags = self->pending[i].tags;
+	frame->frame = self->pending[i].frame;
+	frame->shot = self->pending[i].shot;
+	if (collect_gl_capture(&self->gl_capture, &frame->rgba)) {
+		log_w(_s("lost a captured frame"));
+		return;
+	}
+	SDL_LockMutex(self->mutex);
+	self->count += 1;
+	SDL_CondBroadcast(self->cond);
+	SDL_UnlockMutex(self->mutex);
+}
+
+static void update_sdl_capture(struct sdl_capture *self,
+			       const struct renderer *renderer)
+{
+	int tags = (capture ? SDL_CAPTURE_FRAME : 0) |
+		(sdl_screenshot ? SDL_CAPTURE_SHOT : 0);
+	unsigned int i;
+	sdl_screenshot = 0;
+	if (!self->state && tags)
+		start_sdl_capture(self);
+	if (self->state <= 0)
+		return;
+	if (gl_capture_is_full(&self->gl_capture) ||
+	    (!tags && !gl_capture_is_empty(&self->gl_capture)))
+		collect_sdl_capture(self);
+	if (!tags)
+		return;
+	i = (self->gl_capture.head + self->gl_capture.count) %
+		GL_CAPTURE_DEPTH;
+	self->pending[i].tags = tags;
+	self->pending[i].frame = self->frames;
+	self->pending[i].shot = self->shots;
+	if (tags & SDL_CAPTURE_FRAME)
+		self->frames += 1;
+	if (tags & SDL_CAPTURE_SHOT)
+		self->shots += 1;
+	read_gl_capture(&self->gl_capture, renderer->external_width,
+			renderer->external_height);
+}
+
+static void stop_sdl_capture(struct sdl_capture *self)
+{
+	int i;
+	if (self->state <= 0)
+		return;
+	while (!gl_capture_is_empty(&self->gl_capture))
+		collect_sdl_capture(self);
+	SDL_LockMutex(self->mutex);
+	self->quit = 1;
+	SDL_CondBroadcast(self->cond);
+	SDL_UnlockMutex(self->mutex);
+	SDL_WaitThread(self->thread, NULL);
+	for (i = 0; i < SDL_CAPTURE_QUEUE; i += 1)
+		if (self->queue[i].rgba.p)
+			finalize_rgba(&self->queue[i].rgba);
+	SDL_DestroyCond(self->cond);
+	SDL_DestroyMutex(self->mutex);
+	finalize_gl_capture(&self->gl_capture);
+	if (self->errors)
+		logf_e("could not write %lu captured frames", self->errors);
+	logf_i("captured %lu frames and %lu screenshots", self->frames,
+	       self->shots);
+	self->state = 0;
+}
+
 struct sdl_gl_console {
 	struct console up;
 	struct controller controller;
 	struct gl_renderer gl_renderer;
+	struct sdl_capture capture;
 	SDL_GLContext context;
 	Uint32 ticks;
 };
@@ -572,9 +984,6 @@ static int sdl_gl_console_open(struct console *up)
 	int retval = -1;
 	if ((retval = initialize_sdl_video()))
 		goto bail_out;
-	if ((retval = open_gl_renderer(&self->gl_renderer)))
-		goto bail_out;
-	up->default_renderer = &self->gl_renderer.renderer;
 	self->ticks = 0;
 	flags |= SDL_WINDOW_OPENGL;
 	SDL_GL_SetAttribute(SDL_GL_RED_SIZE, 8);
@@ -587,6 +996,13 @@ static int sdl_gl_console_open(struct console *up)
 		goto bail_out;
 	}
 	self->context = SDL_GL_CreateContext(window);
+	/* extensions can only be probed once the context is current */
+	if ((retval = open_gl_renderer(&self->gl_renderer))) {
+		SDL_GL_DeleteContext(self->context);
+		finalize_sdl_video();
+		goto bail_out;
+	}
+	up->default_renderer = &self->gl_renderer.renderer;
 	if (vsync >= 0 && SDL_GL_SetSwapInterval(vsync))
 		logf_e("SDL_GL_SetSwapInterval(%d): %s", vsync, SDL_GetError());
 	if ((retval = get_sdl_video_size(&w, &h))) {
@@ -595,6 +1011,7 @@ static int sdl_gl_console_open(struct console *up)
 	}
 	resize_renderer(up->default_renderer, w, h);
 	up->default_controller = setup_controller(&self->controller);
+	reset_sdl_capture(&self->capture);
 	SDL_StartTextInput();
 bail_out:
 	return retval;
@@ -603,6 +1020,7 @@ bail_out:
 static void sdl_gl_console_close(struct console *up)
 {
 	struct sdl_gl_console *self = b6_cast_of(up, struct sdl_gl_console, up);
+	stop_sdl_capture(&self->capture);
 	SDL_StopTextInput();
 	close_gl_renderer(&self->gl_renderer);
 	SDL_GL_DeleteContext(self->context);
@@ -614,6 +1032,7 @@ static void sdl_gl_console_show(struct console *up)
 	struct sdl_gl_console *self = b6_cast_of(up, struct sdl_gl_console, up);
 	Uint32 ticks;
 	show_renderer(up->default_renderer);
+	update_sdl_capture(&self->capture, up->default_renderer);
 	glFinish();
 	SDL_GL_SwapWindow(window);
 	ticks = SDL_GetTicks();
@@ -629,12 +1048,117 @@ static int sdl_gl_console_register(void)
 		.poll = sdl_console_poll,
 		.show = sdl_gl_console_show,
 		.close = sdl_gl_console_close,
+		.fullscreen = sdl_console_fullscreen,
 	};
 	static struct sdl_gl_console instance = { .up = { .ops = &ops, }, };
 	return register_console(&instance.up, &sdl_gl_utf8);
 }
 register_init(sdl_gl_console_register);
 
+struct sdl_gl3_console {
+	struct console up;
+	struct controller controller;
+	struct gl3_renderer gl3_renderer;
+	struct sdl_capture capture;
+	SDL_GLContext context;
+	Uint32 ticks;
+};
+
+static int sdl_gl3_console_open(struct console *up)
+{
+	struct sdl_gl3_console *self =
+		b6_cast_of(up, struct sdl_gl3_console, up);
+	unsigned short int w = get_console_width(), h = get_console_height();
+	int vsync = get_console_vsync();
+	int retval = -1;
+	if ((retval = initialize_sdl_video()))
+		goto bail_out;
+	self->ticks = 0;
+	flags |= SDL_WINDOW_OPENGL;
+	SDL_GL_SetAttribute(SDL_GL_CONTEXT_MAJOR_VERSION, 3);
+	SDL_GL_SetAttribute(SDL_GL_CONTEXT_MINOR_VERSION, 3);
+	SDL_GL_SetAttribute(SDL_GL_CONTEXT_PROFILE_MASK,
+			    SDL_GL_CONTEXT_PROFILE_CORE);
+	SDL_GL_SetAttribute(SDL_GL_CONTEXT_FLAGS,
+			    SDL_GL_CONTEXT_FORWARD_COMPATIBLE_FLAG);
+	SDL_GL_SetAttribute(SDL_GL_RED_SIZE, 8);
+	SDL_GL_SetAttribute(SDL_GL_GREEN_SIZE, 8);
+	SDL_GL_SetAttribute(SDL_GL_BLUE_SIZE, 8);
+	SDL_GL_SetAttribute(SDL_GL_ALPHA_SIZE, 8);
+	SDL_GL_SetAttribute(SDL_GL_DOUBLEBUFFER, 1);
+	if ((retval = set_sdl_video_size(w, h)))
+		goto reset_attributes;
+	if (!(self->context = SDL_GL_CreateContext(window))) {
+		logf_e("SDL_GL_CreateContext: %s", SDL_GetError());
+		retval = -1;
+		goto reset_attributes;
+	}
+	/* shaders can only be compiled once the context is current */
+	if ((retval = open_gl3_renderer(&self->gl3_renderer)))
+		goto delete_context;
+	up->default_renderer = &self->gl3_renderer.renderer;
+	if (vsync >= 0 && SDL_GL_SetSwapInterval(vsync))
+		logf_e("SDL_GL_SetSwapInterval(%d): %s", vsync, SDL_GetError());
+	if ((retval = get_sdl_video_size(&w, &h))) {
+		log_p(_s("could not get video size"));
+		goto bail_out; /* NOT REACHED */
+	}
+	resize_renderer(up->default_renderer, w, h);
+	up->default_controller = setup_controller(&self->controller);
+	reset_sdl_capture(&self->capture);
+	SDL_StartTextInput();
+	return 0;
+delete_context:
+	SDL_GL_DeleteContext(self->context);
+reset_attributes:
+	SDL_GL_ResetAttributes();
+	flags &= ~SDL_WINDOW_OPENGL;
+	finalize_sdl_video();
+bail_out:
+	return retval;
+}
+
+static void sdl_gl3_console_close(struct console *up)
+{
+	struct sdl_gl3_console *self =
+		b6_cast_of(up, struct sdl_gl3_console, up);
+	stop_sdl_capture(&self->capture);
+	SDL_StopTextInput();
+	close_gl3_renderer(&self->gl3_renderer);
+	SDL_GL_DeleteContext(self->context);
+	SDL_GL_ResetAttributes();
+	flags &= ~SDL_WINDOW_OPENGL;
+	finalize_sdl_video();
+}
+
+static void sdl_gl3_console_show(struct console *up)
+{
+	struct sdl_gl3_console *self =
+		b6_cast_of(up, struct sdl_gl3_console, up);
+	Uint32 ticks;
+	show_renderer(up->default_renderer);
+	update_sdl_capture(&self->capture, up->default_renderer);
+	SDL_GL_SwapWindow(window);
+	ticks = SDL_GetTicks();
+	if (ticks - self->ticks < sdl_sleep)
+		SDL_Delay(sdl_sleep - (ticks - self->ticks));
+	self->ticks = ticks;
+}
+
+static int sdl_gl3_console_register(void)
+{
+	static const struct console_ops ops = {
+		.open = sdl_gl3_console_open,
+		.poll = sdl_console_poll,
+		.show = sdl_gl3_console_show,
+		.close = sdl_gl3_console_close,
+		.fullscreen = sdl_console_fullscreen,
+	};
+	static struct sdl_gl3_console instance = { .up = { .ops = &ops, }, };
+	return register_console(&instance.up, &sdl_gl3_utf8);
+}
+register_init(sdl_gl3_console_register);
+
 struct sdl_sample {
 	struct sample sample;
 	Mix_Chunk *chunk;
@@ -26,6 +26,42 @@ gl_ext_buffer_data_t gl_ext_buffer_data = NULL;
 gl_ext_map_buffer_t gl_ext_map_buffer = NULL;
 gl_ext_unmap_buffer_t gl_ext_unmap_buffer = NULL;
 gl_ext_bind_buffer_t gl_ext_bind_buffer = NULL;
+gl_ext_buffer_sub_data_t gl_ext_buffer_sub_data = NULL;
+gl_ext_gen_vertex_arrays_t gl_ext_gen_vertex_arrays = NULL;
+gl_ext_delete_vertex_arrays_t gl_ext_delete_vertex_arrays = NULL;
+gl_ext_bind_vertex_array_t gl_ext_bind_vertex_array = NULL;
+gl_ext_create_shader_t gl_ext_create_shader = NULL;
+gl_ext_shader_source_t gl_ext_shader_source = NULL;
+gl_ext_compile_shader_t gl_ext_compile_shader = NULL;
+gl_ext_get_shader_iv_t gl_ext_get_shader_iv = NULL;
+gl_ext_get_shader_info_log_t gl_ext_get_shader_info_log = NULL;
+gl_ext_delete_shader_t gl_ext_delete_shader = NULL;
+gl_ext_create_program_t gl_ext_create_program = NULL;
+gl_ext_attach_shader_t gl_ext_attach_shader = NULL;
+gl_ext_link_program_t gl_ext_link_program = NULL;
+gl_ext_get_program_iv_t gl_ext_get_program_iv = NULL;
+gl_ext_get_program_info_log_t gl_ext_get_program_info_log = NULL;
+gl_ext_use_program_t gl_ext_use_program = NULL;
+gl_ext_delete_program_t gl_ext_delete_program = NULL;
+gl_ext_get_uniform_location_t gl_ext_get_uniform_location = NULL;
+gl_ext_uniform_1i_t gl_ext_uniform_1i = NULL;
+gl_ext_uniform_1f_t gl_ext_uniform_1f = NULL;
+gl_ext_uniform_2f_t gl_ext_uniform_2f = NULL;
+gl_ext_vertex_attrib_pointer_t gl_ext_vertex_attrib_pointer = NULL;
+gl_ext_enable_vertex_attrib_array_t gl_ext_enable_vertex_attrib_array = NULL;
+gl_ext_tex_buffer_t gl_ext_tex_buffer = NULL;
+gl_ext_active_texture_t gl_ext_active_texture = NULL;
+gl_ext_gen_framebuffers_t gl_ext_gen_framebuffers = NULL;
+gl_ext_delete_framebuffers_t gl_ext_delete_framebuffers = NULL;
+gl_ext_bind_framebuffer_t gl_ext_bind_framebuffer = NULL;
+gl_ext_check_framebuffer_status_t gl_ext_check_framebuffer_status = NULL;
+gl_ext_framebuffer_renderbuffer_t gl_ext_framebuffer_renderbuffer = NULL;
+gl_ext_framebuffer_texture_2d_t gl_ext_framebuffer_texture_2d = NULL;
+gl_ext_blit_framebuffer_t gl_ext_blit_framebuffer = NULL;
+gl_ext_gen_renderbuffers_t gl_ext_gen_renderbuffers = NULL;
+gl_ext_delete_renderbuffers_t gl_ext_delete_renderbuffers = NULL;
+gl_ext_bind_renderbuffer_t gl_ext_bind_renderbuffer = NULL;
+gl_ext_renderbuffer_storage_t gl_ext_renderbuffer_storage = NULL;
 
 static void *get_gl_extension(const char *name)
 {
@@ -54,6 +90,118 @@ int gl_buffer_extension_is_supported(void)
 		goto done;
 	if (!(gl_ext_unmap_buffer = get_gl_extension("glUnmapBuffer")))
 		goto done;
+	if (!(gl_ext_buffer_sub_data = get_gl_extension("glBufferSubData")))
+		goto done;
+	supported = 1;
+done:
+	return supported;
+}
+
+int gl_shader_extension_is_supported(void)
+{
+	static short int initialized = 0;
+	static short int supported = 0;
+	if (initialized)
+		goto done;
+	initialized = 1;
+	if (!gl_buffer_extension_is_supported())
+		goto done;
+	if (!(gl_ext_gen_vertex_arrays = get_gl_extension("glGenVertexArrays")))
+		goto done;
+	if (!(gl_ext_delete_vertex_arrays =
+	      get_gl_extension("glDeleteVertexArrays")))
+		goto done;
+	if (!(gl_ext_bind_vertex_array = get_gl_extension("glBindVertexArray")))
+		goto done;
+	if (!(gl_ext_create_shader = get_gl_extension("glCreateShader")))
+		goto done;
+	if (!(gl_ext_shader_source = get_gl_extension("glShaderSource")))
+		goto done;
+	if (!(gl_ext_compile_shader = get_gl_extension("glCompileShader")))
+		goto done;
+	if (!(gl_ext_get_shader_iv = get_gl_extension("glGetShaderiv")))
+		goto done;
+	if (!(gl_ext_get_shader_info_log =
+	      get_gl_extension("glGetShaderInfoLog")))
+		goto done;
+	if (!(gl_ext_delete_shader = get_gl_extension("glDeleteShader")))
+		goto done;
+	if (!(gl_ext_create_program = get_gl_extension("glCreateProgram")))
+		goto done;
+	if (!(gl_ext_attach_shader = get_gl_extension("glAttachShader")))
+		goto done;
+	if (!(gl_ext_link_program = get_gl_extension("glLinkProgram")))
+		goto done;
+	if (!(gl_ext_get_program_iv = get_gl_extension("glGetProgramiv")))
+		goto done;
+	if (!(gl_ext_get_program_info_log =
+	      get_gl_extension("glGetProgramInfoLog")))
+		goto done;
+	if (!(gl_ext_use_program = get_gl_extension("glUseProgram")))
+		goto done;
+	if (!(gl_ext_delete_program = get_gl_extension("glDeleteProgram")))
+		goto done;
+	if (!(gl_ext_get_uniform_location =
+	      get_gl_extension("glGetUniformLocation")))
+		goto done;
+	if (!(gl_ext_uniform_1i = get_gl_extension("glUniform1i")))
+		goto done;
+	if (!(gl_ext_uniform_1f = get_gl_extension("glUniform1f")))
+		goto done;
+	if (!(gl_ext_uniform_2f = get_gl_extension("glUniform2f")))
+		goto done;
+	if (!(gl_ext_vertex_attrib_pointer =
+	      get_gl_extension("glVertexAttribPointer")))
+		goto done;
+	if (!(gl_ext_enable_vertex_attrib_array =
+	      get_gl_extension("glEnableVertexAttribArray")))
+		goto done;
+	if (!(gl_ext_tex_buffer = get_gl_extension("glTexBuffer")))
+		goto done;
+	if (!(gl_ext_active_texture = get_gl_extension("glActiveTexture")))
+		goto done;
+	supported = 1;
+done:
+	return supported;
+}
+
+int gl_framebuffer_extension_is_supported(void)
+{
+	static short int initialized = 0;
+	static short int supported = 0;
+	if (initialized)
+		goto done;
+	initialized = 1;
+	if (!(gl_ext_gen_framebuffers = get_gl_extension("glGenFramebuffers")))
+		goto done;
+	if (!(gl_ext_delete_framebuffers =
+	      get_gl_extension("glDeleteFramebuffers")))
+		goto done;
+	if (!(gl_ext_bind_framebuffer = get_gl_extension("glBindFramebuffer")))
+		goto done;
+	if (!(gl_ext_check_framebuffer_status =
+	      get_gl_extension("glCheckFramebufferStatus")))
+		goto done;
+	if (!(gl_ext_framebuffer_renderbuffer =
+	      get_gl_extension("glFramebufferRenderbuffer")))
+		goto done;
+	if (!(gl_ext_framebuffer_texture_2d =
+	      get_gl_extension("glFramebufferTexture2D")))
+		goto done;
+	if (!(gl_ext_blit_framebuffer = get_gl_extension("glBlitFramebuffer")))
+		goto done;
+	if (!(gl_ext_gen_renderbuffers =
+	      get_gl_extension("glGenRenderbuffers")))
+		goto done;
+	if (!(gl_ext_delete_renderbuffers =
+	      get_gl_extension("glDeleteRenderbuffers")))
+		goto done;
+	if (!(gl_ext_bind_renderbuffer =
+	      get_gl_extension("glBindRenderbuffer")))
+		goto done;
+	if (!(gl_ext_renderbuffer_storage =
+	      get_gl_extension("glRenderbufferStorage")))
+		goto done;
 	supported = 1;
 done:
 	return supported;
@@ -0,0 +1,36 @@
+/*
+ * Open Greedy - an open-source version of Edromel Studio's Greedy XP
+ *
+ * Copyright (C) 2014-2017 Arnaud TROEL
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* The game is not reentrant: jobs cannot run in threads and there is no fork
+ * on this platform, so they run one after the other.
+ */
+
+unsigned int get_platform_cpu_count(void)
+{
+	return 1;
+}
+
+int run_platform_jobs(unsigned int njobs, void (*job)(unsigned int, void*),
+		      void *arg)
+{
+	unsigned int i;
+	for (i = 0; i < njobs; i += 1)
+		job(i, arg);
+	return 0;
+}
@@ -40,6 +40,8 @@
 #define GL_DYNAMIC_DRAW                   0x88E8
 #define GL_DYNAMIC_READ                   0x88E9
 #define GL_DYNAMIC_COPY                   0x88EA
+#define GL_PIXEL_PACK_BUFFER              0x88EB
+#define GL_PIXEL_UNPACK_BUFFER            0x88EC
 
 typedef void (APIENTRY *gl_ext_gen_buffers_t)(GLsizei, GLuint*);
 typedef void (APIENTRY *gl_ext_delete_buffers_t)(GLsizei, const GLuint*);
@@ -48,6 +50,8 @@ typedef void (APIENTRY *gl_ext_buffer_data_t)(GLenum, int, const GLvoid*,
 typedef GLvoid* (APIENTRY *gl_ext_map_buffer_t)(GLenum, GLenum);
 typedef GLboolean (APIENTRY *gl_ext_unmap_buffer_t)(GLenum);
 typedef void (APIENTRY *gl_ext_bind_buffer_t)(GLenum, GLuint);
+typedef void (APIENTRY *gl_ext_buffer_sub_data_t)(GLenum, int, int,
+						  const GLvoid*);
 
 extern gl_ext_gen_buffers_t gl_ext_gen_buffers;
 extern gl_ext_delete_buffers_t gl_ext_delete_buffers;
@@ -55,7 +59,88 @@ extern gl_ext_buffer_data_t gl_ext_buffer_data;
 extern gl_ext_map_buffer_t gl_ext_map_buffer;
 extern gl_ext_unmap_buffer_t gl_ext_unmap_buffer;
 extern gl_ext_bind_buffer_t gl_ext_bind_buffer;
+extern gl_ext_buffer_sub_data_t gl_ext_buffer_sub_data;
 
 extern int gl_buffer_extension_is_supported(void);
 
+/* OpenGL 3.3 core profile entry points */
+typedef PFNGLGENVERTEXARRAYSPROC gl_ext_gen_vertex_arrays_t;
+typedef PFNGLDELETEVERTEXARRAYSPROC gl_ext_delete_vertex_arrays_t;
+typedef PFNGLBINDVERTEXARRAYPROC gl_ext_bind_vertex_array_t;
+typedef PFNGLCREATESHADERPROC gl_ext_create_shader_t;
+typedef PFNGLSHADERSOURCEPROC gl_ext_shader_source_t;
+typedef PFNGLCOMPILESHADERPROC gl_ext_compile_shader_t;
+typedef PFNGLGETSHADERIVPROC gl_ext_get_shader_iv_t;
+typedef PFNGLGETSHADERINFOLOGPROC gl_ext_get_shader_info_log_t;
+typedef PFNGLDELETESHADERPROC gl_ext_delete_shader_t;
+typedef PFNGLCREATEPROGRAMPROC gl_ext_create_program_t;
+typedef PFNGLATTACHSHADERPROC gl_ext_attach_shader_t;
+typedef PFNGLLINKPROGRAMPROC gl_ext_link_program_t;
+typedef PFNGLGETPROGRAMIVPROC gl_ext_get_program_iv_t;
+typedef PFNGLGETPROGRAMINFOLOGPROC gl_ext_get_program_info_log_t;
+typedef PFNGLUSEPROGRAMPROC gl_ext_use_program_t;
+typedef PFNGLDELETEPROGRAMPROC gl_ext_delete_program_t;
+typedef PFNGLGETUNIFORMLOCATIONPROC gl_ext_get_uniform_location_t;
+typedef PFNGLUNIFORM1IPROC gl_ext_uniform_1i_t;
+typedef PFNGLUNIFORM1FPROC gl_ext_uniform_1f_t;
+typedef PFNGLUNIFORM2FPROC gl_ext_uniform_2f_t;
+typedef PFNGLVERTEXATTRIBPOINTERPROC gl_ext_vertex_attrib_pointer_t;
+typedef PFNGLENABLEVERTEXATTRIBARRAYPROC gl_ext_enable_vertex_attrib_array_t;
+typedef PFNGLTEXBUFFERPROC gl_ext_tex_buffer_t;
+typedef PFNGLACTIVETEXTUREPROC gl_ext_active_texture_t;
+
+extern gl_ext_gen_vertex_arrays_t gl_ext_gen_vertex_arrays;
+extern gl_ext_delete_vertex_arrays_t gl_ext_delete_vertex_arrays;
+extern gl_ext_bind_vertex_array_t gl_ext_bind_vertex_array;
+extern gl_ext_create_shader_t gl_ext_create_shader;
+extern gl_ext_shader_source_t gl_ext_shader_source;
+extern gl_ext_compile_shader_t gl_ext_compile_shader;
+extern gl_ext_get_shader_iv_t gl_ext_get_shader_iv;
+extern gl_ext_get_shader_info_log_t gl_ext_get_shader_info_log;
+extern gl_ext_delete_shader_t gl_ext_delete_shader;
+extern gl_ext_create_program_t gl_ext_create_program;
+extern gl_ext_attach_shader_t gl_ext_attach_shader;
+extern gl_ext_link_program_t gl_ext_link_program;
+extern gl_ext_get_program_iv_t gl_ext_get_program_iv;
+extern gl_ext_get_program_info_log_t gl_ext_get_program_info_log;
+extern gl_ext_use_program_t gl_ext_use_program;
+extern gl_ext_delete_program_t gl_ext_delete_program;
+extern gl_ext_get_uniform_location_t gl_ext_get_uniform_location;
+extern gl_ext_uniform_1i_t gl_ext_uniform_1i;
+extern gl_ext_uniform_1f_t gl_ext_uniform_1f;
+extern gl_ext_uniform_2f_t gl_ext_uniform_2f;
+extern gl_ext_vertex_attrib_pointer_t gl_ext_vertex_attrib_pointer;
+extern gl_ext_enable_vertex_attrib_array_t gl_ext_enable_vertex_attrib_array;
+extern gl_ext_tex_buffer_t gl_ext_tex_buffer;
+extern gl_ext_active_texture_t gl_ext_active_texture;
+
+extern int gl_shader_extension_is_supported(void);
+
+/* framebuffer objects, OpenGL 3.0 or GL_ARB_framebuffer_object */
+typedef PFNGLGENFRAMEBUFFERSPROC gl_ext_gen_framebuffers_t;
+typedef PFNGLDELETEFRAMEBUFFERSPROC gl_ext_delete_framebuffers_t;
+typedef PFNGLBINDFRAMEBUFFERPROC gl_ext_bind_framebuffer_t;
+typedef PFNGLCHECKFRAMEBUFFERSTATUSPROC gl_ext_check_framebuffer_status_t;
+typedef PFNGLFRAMEBUFFERRENDERBUFFERPROC gl_ext_framebuffer_renderbuffer_t;
+typedef PFNGLFRAMEBUFFERTEXTURE2DPROC gl_ext_framebuffer_texture_2d_t;
+typedef PFNGLBLITFRAMEBUFFERPROC gl_ext_blit_framebuffer_t;
+typedef PFNGLGENRENDERBUFFERSPROC gl_ext_gen_renderbuffers_t;
+typedef PFNGLDELETERENDERBUFFERSPROC gl_ext_delete_renderbuffers_t;
+typedef PFNGLBINDRENDERBUFFERPROC gl_ext_bind_renderbuffer_t;
+typedef PFNGLRENDERBUFFERSTORAGEPROC gl_ext_renderbuffer_storage_t;
+
+extern gl_ext_gen_framebuffers_t gl_ext_gen_framebuffers;
+extern gl_ext_delete_framebuffers_t gl_ext_delete_framebuffers;
+extern gl_ext_bind_framebuffer_t gl_ext_bind_framebuffer;
+extern gl_ext_check_framebuffer_status_t gl_ext_check_framebuffer_status;
+extern gl_ext_framebuffer_renderbuffer_t gl_ext_framebuffer_renderbuffer;
+extern gl_ext_framebuffer_texture_2d_t gl_ext_framebuffer_texture_2d;
+extern gl_ext_blit_framebuffer_t gl_ext_blit_framebuffer;
+extern gl_ext_gen_renderbuffers_t gl_ext_gen_renderbuffers;
+extern gl_ext_delete_renderbuffers_t gl_ext_delete_renderbuffers;
+extern gl_ext_bind_renderbuffer_t gl_ext_bind_renderbuffer;
+extern gl_ext_renderbuffer_storage_t gl_ext_renderbuffer_storage;
+
+extern int gl_framebuffer_extension_is_supported(void);
+
 #endif /* PLATFORM_GL_H */